@@ -9,6 +9,7 @@
 #include <exec/execbase.h>
 #include <dos/dos.h>
 #include <dos/dostags.h>
+#include <dos/datetime.h>
 #include <intuition/intuition.h>
 #include <intuition/intuitionbase.h>
 #include <intuition/classusr.h>
@@ -19,6 +20,7 @@
 #include <workbench/startup.h>
 #include <datatypes/datatypes.h>
 #include <datatypes/datatypesclass.h>
+#include <devices/timer.h>
 #include <utility/tagitem.h>
 #include <string.h>
 #include <stdlib.h>
@@ -69,6 +71,7 @@ ULONG LaunchToolA(struct Tool *, STRPTR, struct TagItem *);
 #include <proto/datatypes.h>
 #include <proto/utility.h>
 #include <proto/requester.h>
+#include <proto/timer.h>
 
 /* Library base pointers */
 extern struct ExecBase *SysBase;
@@ -82,32 +85,643 @@ extern struct Library *UtilityBase;
 /* Reaction class library bases */
 struct ClassLibrary *RequesterBase = NULL;
 
+/* timer.device base for ReadEClock() (STATS only) */
+struct Device *TimerBase = NULL;
+
 /* Reaction class handles */
 Class *RequesterClass = NULL;
 
 /* Global flag to track if running from Workbench */
 static BOOL g_fromWorkbench = FALSE;
 
+/* Identification tiers - how much work may be spent identifying an item */
+#define TIER_FULL         0  /* DefIcons, datatypes.library and the header */
+#define TIER_HEADER       1  /* Header bytes only */
+#define TIER_FAST         2  /* File name (suffix map) and FIB only */
+
+/* Number of bytes read from the start of a file for identification */
+/* Large enough for the hunk table of an executable with up to 59 hunks */
+#define ITEM_HEADER_SIZE  256
+
+/* What is already known about the item currently being opened */
+/* Filled once per item from Examine() or from ExAllData, so the */
+/* classification helpers do not have to examine the same file again */
+struct ItemInfo {
+    BOOL  fibValid;      /* TRUE if the fields below are valid */
+    LONG  dirEntryType;  /* fib_DirEntryType / ed_Type */
+    ULONG size;          /* fib_Size / ed_Size */
+    ULONG protection;    /* fib_Protection / ed_Prot */
+    struct DateStamp date;     /* fib_Date / ed_Days, ed_Mins, ed_Ticks */
+    struct DateStamp started;  /* When work on the item began */
+    struct MsgPort *handler;   /* Filesystem handler of the item's volume */
+    UWORD tier;          /* TIER_xxx identification depth for this item */
+    BOOL  groupValid;    /* TRUE once groupID below has been looked up */
+    ULONG groupID;       /* Datatypes group ID, 0 if no datatype */
+    BOOL  headerValid;   /* TRUE once the header below has been read */
+    LONG  headerLen;     /* Number of valid bytes in header */
+    UBYTE header[ITEM_HEADER_SIZE];  /* First bytes of the file */
+};
+static struct ItemInfo g_item;
+static LONG g_itemError = 0;    /* IoErr() of the last item that failed, taken before cleanup */
+
+/* Set once Ctrl-C has been seen */
+static BOOL g_aborted = FALSE;
+
+/* Per-file identification deadline in milliseconds (0 = no deadline) */
+static LONG g_deadlineMillis = 0;
+
+/* What we know about each volume seen during this run */
+/* Keyed by handler port, so no I/O is needed to recognise a volume again */
+struct VolumeState {
+    struct MsgPort *handler;  /* Filesystem handler port */
+    BOOL  slow;               /* TRUE once it has missed the deadline */
+    UWORD tier;               /* Identification tier from the policy table */
+};
+#define MAX_VOLUMES       16
+static struct VolumeState g_volumes[MAX_VOLUMES];
+static LONG g_volumeCount = 0;
+
+/* Per-volume identification policy from ENV:Open/Volumes */
+struct VolumePolicy {
+    UBYTE name[32];           /* Device or volume name without the colon */
+    UWORD tier;               /* TIER_xxx */
+};
+#define MAX_VOLUME_POLICIES 16
+static struct VolumePolicy g_policies[MAX_VOLUME_POLICIES];
+static LONG g_policyCount = 0;
+
+/* FAST switch - identify by name only for this invocation */
+static BOOL g_forceFast = FALSE;
+
+/* Rules from ENV:Open/Rules - pattern and verb to tool */
+/* Rules of the form "#?.suffix" go into a hash table keyed by suffix, all */
+/* others are kept as precompiled patterns in file order */
+struct Rule {
+    struct Rule *next;        /* Next rule in hash chain or pattern list */
+    LONG   order;             /* Line order, earlier rules win */
+    UWORD  verb;              /* TW_xxx, or 0 for any verb */
+    BOOL   isWild;            /* FALSE if pattern is a plain name */
+    STRPTR suffix;            /* Suffix including the period (hash rules) */
+    STRPTR pattern;           /* ParsePatternNoCase() tokens (pattern rules) */
+    STRPTR tool;              /* Tool to launch */
+};
+#define RULE_HASH_SIZE    32
+static struct Rule *g_ruleHash[RULE_HASH_SIZE];
+static struct Rule *g_rulePatterns = NULL;
+static struct Rule *g_rulePatternsTail = NULL;
+static LONG g_ruleCount = 0;
+
+/* Size routing from ENV:Open/LargeFiles - files of a datatypes group or */
+/* DefIcons type at or above the limit go to an alternative tool */
+struct SizeRoute {
+    UBYTE name[32];           /* Group or DefIcons type name */
+    ULONG groupID;            /* GID_xxx if name is a datatypes group, else 0 */
+    ULONG limit;              /* Size in bytes from which the route applies */
+    UBYTE tool[256];          /* Tool for files of this size or larger */
+};
+#define MAX_SIZE_ROUTES   16
+static struct SizeRoute g_sizeRoutes[MAX_SIZE_ROUTES];
+static LONG g_sizeRouteCount = 0;
+static ULONG g_sizeRouteMin = 0;       /* Smallest limit of any route */
+static BOOL g_sizeRouteGroups = FALSE; /* TRUE if any route names a group */
+
+/* Datatypes group names accepted in ENV:Open/LargeFiles */
+struct GroupName {
+    const char *name;
+    ULONG groupID;
+};
+static const struct GroupName groupNames[] = {
+    { "system",     GID_SYSTEM },
+    { "text",       GID_TEXT },
+    { "document",   GID_DOCUMENT },
+    { "sound",      GID_SOUND },
+    { "instrument", GID_INSTRUMENT },
+    { "music",      GID_MUSIC },
+    { "picture",    GID_PICTURE },
+    { "animation",  GID_ANIMATION },
+    { "movie",      GID_MOVIE },
+    { "binary",     GID_BINARY },
+    { NULL,         0 }
+};
+
+/* Per-run memo of resolved tools, keyed by DefIcons type or datatype name */
+/* and verb, so further files of a kind need no def_ icon load or ToolNode walk */
+#define MEMO_DEFICONS     1
+#define MEMO_DATATYPES    2
+struct ToolMemo {
+    UWORD source;             /* MEMO_xxx - which stage resolved it */
+    UWORD verb;               /* TW_xxx it was resolved for (0 for DefIcons) */
+    BOOL  found;              /* FALSE if that stage had no tool */
+    UWORD which;              /* tn_Which of the datatypes tool */
+    UWORD flags;              /* tn_Flags of the datatypes tool */
+    UBYTE key[32];            /* DefIcons type or datatype name */
+    UBYTE program[256];       /* Resolved tool */
+};
+#define MAX_TOOL_MEMOS    32
+static struct ToolMemo g_toolMemos[MAX_TOOL_MEMOS];
+static LONG g_toolMemoCount = 0;
+static LONG g_toolMemoNext = 0;        /* Slot to reuse once the table is full */
+
+/* Which resolution stage produced the tool, per suffix class */
+/* Kept in ENV:Open/Stages (and ENVARC:) across runs so the stage that */
+/* usually wins for a suffix can be tried first */
+#define STAGE_DEFICONS    0
+#define STAGE_DATATYPES   1
+#define STAGE_ICON        2
+#define STAGE_COUNT       3
+struct StageStat {
+    UBYTE suffix[16];         /* Lower case suffix including the period */
+    ULONG wins[STAGE_COUNT];  /* Times each stage produced the tool */
+    BOOL  verified;           /* Resolved in the usual order during this run */
+};
+#define MAX_STAGE_STATS   64
+#define STAGE_PROMOTE_MIN 3           /* Wins needed before reordering */
+#define STAGE_WINS_MAX    10000       /* Counts are halved beyond this */
+#define STAGE_ARCHIVE_EVERY 8         /* Changes saved to ENV: per copy to ENVARC: */
+static struct StageStat g_stageStats[MAX_STAGE_STATS];
+static LONG g_stageStatCount = 0;
+static const char *stageNames[STAGE_COUNT] = { "deficons", "datatypes", "icon" };
+static BOOL g_stageStatsLoaded = FALSE;
+static BOOL g_stageStatsDirty = FALSE;
+static LONG g_stageChanges = 0;                  /* Saved since ENVARC: was written */
+
+/* Tool name to resolved path cache, kept in ENV:Open/ToolCache */
+/* An entry is checked against the file's datestamp once per run; after */
+/* that the resolved path is used without further I/O */
+struct ToolPath {
+    UBYTE name[64];           /* Tool as given by DefIcons, datatypes or icon */
+    UBYTE path[256];          /* Absolute path from NameFromLock() */
+    struct DateStamp date;    /* fib_Date of the tool when resolved */
+    BOOL  checked;            /* Validated during this run */
+};
+#define MAX_TOOL_PATHS    32
+static struct ToolPath g_toolPaths[MAX_TOOL_PATHS];
+static LONG g_toolPathCount = 0;
+static BOOL g_toolPathsLoaded = FALSE;
+static BOOL g_toolPathsDirty = FALSE;
+
+/* Pure tools kept resident for System() launches, listed in ENV:Open/Residents */
+/* $Open/SegCache gives the memory budget in KB; unset or 0 turns it off */
+struct SegCacheEntry {
+    UBYTE name[32];           /* Resident name - FilePart() and a hash of the path */
+    UBYTE path[256];          /* Tool the seglist was loaded from */
+    struct DateStamp date;    /* fib_Date of the tool when loaded */
+    ULONG size;               /* fib_Size, stands in for the seglist size */
+    struct DateStamp used;    /* Last launch, the oldest is dropped first */
+};
+#define MAX_SEG_CACHE     16
+#define SEG_CACHE_LOCK    "Open.segcache"   /* Semaphore held while ENV:Open/Residents is rewritten */
+struct SegCacheLock {
+    struct SignalSemaphore sl_Semaphore;
+    UBYTE sl_Name[16];
+};
+static struct SegCacheEntry g_segCache[MAX_SEG_CACHE];
+static LONG g_segCacheCount = 0;
+static LONG g_segCacheBudget = -1;     /* Bytes, 0 = off, -1 = not read yet */
+static BOOL g_segCacheDirty = FALSE;
+
+/* Entry in a CLI's command path list (cli_CommandDir) */
+struct CommandPathEntry {
+    BPTR cpe_Next;            /* BPTR to next entry */
+    BPTR cpe_Lock;            /* Lock on the directory */
+};
+
+/* Where Workbench looks for tools, used when there is no CLI path */
+static const char *workbenchPath[] = {
+    "C:",
+    "SYS:Utilities",
+    "SYS:Tools",
+    "SYS:System",
+    "SYS:Rexxc",
+    "S:",
+    "SYS:Prefs",
+    "SYS:Tools/Commodities",
+    NULL
+};
+
+/* Resolution cache shared by all running Open processes */
+/* Published as a named SignalSemaphore so other instances find it with */
+/* FindSemaphore(); readers share the semaphore, inserts take it exclusively */
+#define SHARED_CACHE_NAME     "Open.cache"
+#define SHARED_CACHE_VERSION  2
+#define SHARED_CACHE_SLOTS    64
+#define SHARED_CACHE_KEEP     10      /* Default minutes to keep it unused */
+#define SHARED_DEFTOOL        1       /* def_ icon tool by DefIcons type */
+#define SHARED_DTTOOL         2       /* Datatypes tool by datatype name and verb */
+#define SHARED_FILETYPE       3       /* DefIcons type of one file */
+struct SharedEntry {
+    UWORD kind;               /* SHARED_xxx, 0 if the slot is free */
+    UWORD verb;               /* TW_xxx for SHARED_DTTOOL */
+    BOOL  found;              /* FALSE if the lookup found nothing */
+    UWORD which;              /* tn_Which of a datatypes tool */
+    UWORD flags;              /* tn_Flags of a datatypes tool */
+    ULONG size;               /* File size (SHARED_FILETYPE) */
+    struct DateStamp date;    /* File, def_ icon or DEVS:DataTypes date the entry was made from */
+    UBYTE key[64];            /* Type, datatype name or file key */
+    UBYTE value[256];         /* Tool or DefIcons type */
+};
+struct SharedCache {
+    struct SignalSemaphore sc_Semaphore;
+    UBYTE  sc_Name[16];       /* Semaphore name, lives with the cache */
+    UWORD  sc_Version;        /* SHARED_CACHE_VERSION */
+    UWORD  sc_Slots;          /* Number of entries below */
+    ULONG  sc_Users;          /* Attached processes, changed under Forbid() */
+    ULONG  sc_NextSlot;       /* Next slot to reuse */
+    LONG   sc_KeepMinutes;    /* Free when unused for this long */
+    struct DateStamp sc_LastUsed;
+    struct SharedEntry sc_Entries[SHARED_CACHE_SLOTS];
+};
+static struct SharedCache *g_sharedCache = NULL;
+static struct SharedEntry g_sharedEntry;        /* Scratch copy, too big for the stack */
+
+/* DEVS:DataTypes descriptors compiled for matching against the item header */
+/* Kept in ENV:Open/DTMatch and rebuilt when the drawer's date changes */
+#define DTMATCH_FILE      "ENV:Open/DTMatch"
+#define DTMATCH_MAGIC     0x4F50444D        /* 'OPDM' */
+#define DTMATCH_VERSION   2
+#define DTMATCH_FAILED    0xFFFF            /* Count of a file that only notes the drawer can't be compiled */
+#define MAX_DTMATCH       256               /* Descriptors */
+#define DTMATCH_POOL      16384             /* Bytes for masks and patterns */
+#define DTMATCH_ANY       256               /* Bucket for masks without a fixed first byte */
+struct DTMatchEntry {
+    ULONG groupID;            /* dth_GroupID */
+    WORD  priority;           /* dth_Priority */
+    UWORD flags;              /* dth_Flags */
+    UWORD maskLen;            /* dth_MaskLen */
+    UWORD opaque;             /* Needs datatypes.library - DTCD hook or no mask */
+    ULONG maskOffset;         /* WORDs in the pool, letters folded unless DTF_CASE */
+    ULONG patternOffset;      /* Parsed dth_Pattern in the pool, 0 = any name */
+};
+struct DTMatchHeader {
+    ULONG magic;
+    UWORD version;
+    UWORD count;              /* Entries following the header */
+    struct DateStamp dirDate; /* DEVS:DataTypes when compiled */
+    ULONG poolSize;           /* Bytes following the entries */
+};
+static struct DTMatchHeader g_dtMatchHeader;
+static struct DTMatchEntry *g_dtMatch = NULL;    /* Entries, then the pool */
+static UBYTE *g_dtMatchPool = NULL;
+static UWORD g_dtBucketStart[DTMATCH_ANY + 2];   /* First-byte dispatch */
+static UWORD *g_dtBuckets = NULL;                /* Entry numbers by bucket */
+static BOOL g_dtMatchLoaded = FALSE;             /* Tried - g_dtMatch may still be NULL */
+static struct DateStamp g_dtDirDate;             /* Date of DEVS:DataTypes, zero if unknown */
+static BOOL g_dtDirChecked = FALSE;
+
+/* RESOLVE switch - decide what to do with each item but launch nothing */
+/* What was decided is collected here and printed as one record per item */
+struct Resolution {
+    const char *kind;        /* drawer, executable, asset, info or data */
+    const char *method;      /* workbench, datatypes, system, skip or none */
+    const char *stage;       /* What decided, e.g. deficons or rule */
+    UBYTE type[32];           /* DefIcons (or header/name) type */
+    UBYTE tool[256];          /* Tool that would be started */
+};
+static struct Resolution g_resolution;
+static BOOL g_resolveOnly = FALSE;
+static BOOL g_resolveVars = FALSE;     /* SETVAR - also set local variables */
+
+/* STATS switch - EClock timing of each stage and counts of costly calls */
+#define STAT_LOCK         0   /* Lock() and Examine() of the item */
+#define STAT_IDENTIFY     1   /* DefIcons identification (GetIconTagList) */
+#define STAT_DATATYPE     2   /* ObtainDataTypeA() */
+#define STAT_DEFICON      3   /* def_ icon load (GetDiskObject) */
+#define STAT_ICON         4   /* The item's own icon default tool */
+#define STAT_LAUNCH       5   /* Starting the tool, drawer or program */
+#define STAT_COUNT        6
+#define COUNT_PARENTDIR   0   /* ParentDir() */
+#define COUNT_FINDTOOL    1   /* FindToolNodeA() */
+#define COUNT_READ        2   /* Read() of file headers */
+#define COUNT_LOCK        3   /* Lock() */
+#define COUNT_EXAMINE     4   /* Examine() */
+#define COUNT_OBTAINDT    5   /* ObtainDataTypeA() */
+#define COUNT_ICONTAGS    6   /* GetIconTagList() */
+#define COUNT_DISKOBJECT  7   /* GetDiskObject() */
+#define COUNT_WBOPEN      8   /* OpenWorkbenchObjectA() */
+#define COUNT_SYSTEM      9   /* System() */
+#define COUNT_MISSING     10  /* Tools named by a stage that could not be found */
+#define COUNT_COUNT       11
+struct StatTiming {
+    ULONG calls;              /* Number of timed calls */
+    ULONG total;              /* Microseconds, all calls */
+    ULONG min;                /* Microseconds, fastest call */
+    ULONG max;                /* Microseconds, slowest call */
+};
+static const char *statNames[STAT_COUNT] = {
+    "lock", "identify", "datatype", "deficon", "icon", "launch"
+};
+static const char *countNames[COUNT_COUNT] = {
+    "ParentDir", "FindToolNodeA", "Read", "Lock", "Examine", "ObtainDataTypeA",
+    "GetIconTagList", "GetDiskObject", "OpenWorkbenchObjectA", "System", "MissingTool"
+};
+static BOOL g_statsEnabled = FALSE;
+static struct MsgPort *g_timerPort = NULL;
+static struct timerequest *g_timerIO = NULL;
+static ULONG g_eclockFreq = 0;                   /* EClock ticks per second */
+static struct EClockVal g_statStart[STAT_COUNT]; /* When each stage began */
+static struct StatTiming g_statTimes[STAT_COUNT];/* Per stage, whole run */
+static ULONG g_itemMicros[STAT_COUNT];           /* Per stage, current item */
+static struct StatTiming g_itemTimes;            /* Per item totals, whole run */
+static struct EClockVal g_statsBegin;            /* For items per second */
+static BOOL g_timingEnabled = FALSE;             /* Stage times are needed */
+
+/* BENCH=<n> - repeat each item's decision n times and print percentiles */
+#define BENCH_ITEM        STAT_COUNT        /* Whole items */
+#define BENCH_TIMINGS     (STAT_COUNT + 1)
+#define BENCH_MAX         100000            /* Runs per item, keeps the sample table in range */
+static ULONG g_benchCount = 0;                   /* Runs per item, 0 = no BENCH */
+static BOOL g_benchCold = FALSE;                 /* COLD - flush caches between runs */
+static ULONG *g_benchSamples = NULL;             /* BENCH_TIMINGS x g_benchCount */
+static ULONG g_benchIteration = 0;
+static ULONG g_apiCounts[COUNT_COUNT];
+static ULONG g_itemCounts[COUNT_COUNT];          /* Current item */
+
+/* TRACE=<file> - begin/end events in a preallocated ring, written at exit */
+#define TRACE_ITEM        STAT_COUNT        /* A whole item, start to cleanup */
+#define TRACE_VOLUME      (STAT_COUNT + 1)  /* BATCH volume check (DOS wait) */
+#define TRACE_KINDS       (STAT_COUNT + 2)
+#define TRACE_EVENTS      4096              /* Ring size, oldest events are dropped */
+#define TRACE_NAMES       8192              /* Bytes kept for item names, oldest overwritten */
+#define TRACE_ITEMS       (TRACE_EVENTS / 2) /* Items the ring can hold, each has a B and an E */
+#define TRACE_NAME_MAX    256               /* Longer names are not kept */
+struct TraceEvent {
+    ULONG micros;             /* Since the trace began */
+    ULONG item;               /* Item number, 0 = between items */
+    UBYTE kind;               /* STAT_ or TRACE_ */
+    UBYTE phase;              /* 'B' begin or 'E' end */
+};
+struct TraceName {
+    ULONG item;               /* Item whose name this is, 0 = none */
+    ULONG at;                 /* Position in the name ring, counting every byte ever used */
+};
+static const char *traceNames[TRACE_KINDS] = {
+    "lock", "identify", "datatype", "deficon", "icon", "launch", "item", "volume"
+};
+static STRPTR g_traceName = NULL;                /* TRACE file name */
+static BPTR g_traceFile = NULL;                  /* Opened up front, written at exit */
+static struct TraceEvent *g_traceEvents = NULL;  /* TRACE_EVENTS entries */
+static ULONG g_traceCount = 0;                   /* Events ever added */
+static char *g_traceItemNames = NULL;            /* TRACE_NAMES ring of NUL-terminated names */
+static struct TraceName *g_traceNameSlots = NULL; /* TRACE_ITEMS entries, by item number */
+static ULONG g_traceNamesUsed = 0;               /* Name bytes ever used */
+static ULONG g_traceItems = 0;                   /* Items started */
+static ULONG g_traceItem = 0;                    /* Current item, 0 = none */
+static struct EClockVal g_traceStart;
+
+/* $Open/Monitor - counters and latency histograms kept in ENVARC: across runs */
+#define USAGE_FILE        "ENVARC:Open/Usage"
+#define USAGE_MAGIC       0x4F505553        /* 'OPUS' */
+#define USAGE_VERSION     1
+#define USAGE_ITEM        STAT_COUNT        /* Whole items */
+#define USAGE_TIMINGS     (STAT_COUNT + 1)
+#define USAGE_BUCKETS     16                /* Bucket n is below 2^(n+5)us, the last is open */
+struct UsageTiming {
+    ULONG calls;
+    ULONG millis;                           /* Total time, milliseconds */
+    ULONG buckets[USAGE_BUCKETS];
+};
+struct UsageFile {
+    ULONG magic;
+    UWORD version;
+    UWORD timings;                          /* Layout check - USAGE_TIMINGS */
+    UWORD buckets;                          /* USAGE_BUCKETS */
+    UWORD counts;                           /* COUNT_COUNT */
+    ULONG runs;
+    struct DateStamp first;                 /* First and last run counted */
+    struct DateStamp last;
+    struct UsageTiming timing[USAGE_TIMINGS];
+    ULONG count[COUNT_COUNT];
+};
+static const char *bucketNames[USAGE_BUCKETS] = {
+    "<32us", "<64us", "<128us", "<256us", "<512us", "<1ms", "<2ms", "<4ms",
+    "<8ms", "<16ms", "<33ms", "<66ms", "<131ms", "<262ms", "<524ms", ">=524ms"
+};
+static BOOL g_usageEnabled = FALSE;
+static BOOL g_usageReport = FALSE;                 /* REPORT switch */
+static struct UsageTiming g_usageRun[USAGE_TIMINGS]; /* This run, millis unused */
+static ULONG g_usageMicros[USAGE_TIMINGS];         /* This run, total microseconds */
+
+/* BATCH switch - never wait for a human */
+static BOOL g_batchMode = FALSE;
+
+/* Memory an executable's hunks need, from the hunk table in its header */
+struct HunkNeeds {
+    ULONG chip;               /* Bytes that must be chip memory */
+    ULONG fast;               /* Bytes that must be fast memory */
+    ULONG any;                /* Bytes that may be either */
+    ULONG chipLargest;        /* Largest single hunk of each kind */
+    ULONG fastLargest;
+    ULONG anyLargest;
+    BOOL  complete;           /* FALSE if the table runs past the header */
+};
+
+/* Header read-ahead - the headers of the next few items are read with */
+/* packets sent straight to their handlers while the current one is launched */
+#define READAHEAD_DEPTH   4
+#define RA_FREE           0  /* Slot not in use */
+#define RA_OPENING        1  /* ACTION_FINDINPUT sent */
+#define RA_READING        2  /* ACTION_READ sent */
+#define RA_CLOSING        3  /* ACTION_END sent, the header is in */
+#define RA_READY          4  /* All I/O done, waiting for the item */
+struct ReadAhead {
+    UWORD state;              /* RA_xxx */
+    BOOL  discard;            /* Nobody wants the header - just finish the I/O */
+    ULONG sequence;           /* Order the slots were started in */
+    BPTR  dirLock;            /* Directory the name is relative to */
+    struct StandardPacket *packet;
+    struct FileHandle *handle;
+    struct MsgPort *handler;  /* Filesystem the packets go to */
+    struct DevProc *devProc;  /* Held until ACTION_FINDINPUT is answered, as it may own the lock */
+    UBYTE *bname;             /* BSTR copy of the name for ACTION_FINDINPUT */
+    LONG  length;             /* Bytes read, -1 if the open or read failed */
+    UBYTE name[256];
+    UBYTE header[ITEM_HEADER_SIZE];
+};
+static struct ReadAhead g_readAhead[READAHEAD_DEPTH];
+static struct MsgPort *g_readAheadPort = NULL;   /* Replies for all slots */
+static ULONG g_readAheadSequence = 0;
+static LONG g_readAheadCurrent = -1;             /* Slot of the item being opened */
+
+/* Workbench mode - items that failed, shown in one requester at the end */
+#define ERROR_SUMMARY_LINES 8     /* Items named, the rest are only counted */
+#define ERROR_SUMMARY_SIZE  1024
+static UBYTE g_errorSummary[ERROR_SUMMARY_SIZE];
+static LONG g_errorCount = 0;
+
+/* Availability of each volume named by an argument in BATCH mode */
+/* Checked once per distinct name, with system requesters suppressed */
+struct VolumeCheck {
+    UBYTE name[32];           /* Device, volume or assign name with colon */
+    BOOL  available;          /* TRUE if it could be reached */
+    LONG  errorCode;          /* Why not, if it couldn't */
+};
+#define MAX_VOLUME_CHECKS 16
+static struct VolumeCheck g_volumeChecks[MAX_VOLUME_CHECKS];
+static LONG g_volumeCheckCount = 0;
+
+/* ExAll() buffer size for the ALL walk (one buffer per level) */
+#define EXALL_BUFFER_SIZE 2048
+
+/* Maximum drawer nesting followed by the ALL walk */
+#define MAX_WALK_DEPTH    32
+
+/* One drawer of the ALL walk - kept on the heap, not the 4K stack */
+struct WalkLevel {
+    BPTR lock;
+    struct ExAllControl *eac;
+    struct ExAllData *buffer;
+    struct ExAllData *next;   /* Next entry to look at, NULL to call ExAll() again */
+    BOOL more;                /* ExAll() has more entries to give */
+};
+
+/* Longest line accepted from a FROM list file */
+#define MAX_LIST_LINE     512
+
 /* Forward declarations */
-BOOL InitializeLibraries(VOID);
+BOOL InitializeLibraries(BOOL launching);
 BOOL InitializeApplication(VOID);
 VOID Cleanup(VOID);
 VOID ShowUsage(VOID);
 VOID ShowErrorDialog(STRPTR title, STRPTR message);
+VOID NoteItemError(STRPTR fileName, LONG errorCode);
+VOID ShowErrorSummary(VOID);
 LONG OpenItem(STRPTR fileName, STRPTR forceTool, BOOL forceBrowse, BOOL forceEdit, BOOL forceInfo, BOOL forcePrint, BOOL forceMail, BOOL showAll);
+LONG BenchItem(STRPTR fileName, STRPTR forceTool, BOOL forceBrowse, BOOL forceEdit, BOOL forceInfo, BOOL forcePrint, BOOL forceMail, BOOL showAll);
+VOID FlushCaches(VOID);
+VOID SortMicros(ULONG *values, ULONG count);
+VOID PrintBench(STRPTR fileName, ULONG runs);
+LONG OpenArgument(STRPTR fileName, STRPTR forceTool, BOOL forceBrowse, BOOL forceEdit, BOOL forceInfo, BOOL forcePrint, BOOL forceMail, BOOL showAll, BOOL recurseAll);
+LONG ParseQualifiers(STRPTR fileName, BOOL checkName, STRPTR *toolOut, UWORD *verbOut, BOOL *showAllOut);
+LONG OpenFromList(STRPTR listName, STRPTR forceTool, BOOL forceBrowse, BOOL forceEdit, BOOL forceInfo, BOOL forcePrint, BOOL forceMail, BOOL showAll, BOOL recurseAll, LONG *countOut);
+LONG OpenTree(STRPTR fileName, STRPTR forceTool, BOOL forceBrowse, BOOL forceEdit, BOOL forceInfo, BOOL forcePrint, BOOL forceMail, BOOL showAll);
+LONG WalkDrawer(BPTR dirLock, STRPTR forceTool, BOOL forceBrowse, BOOL forceEdit, BOOL forceInfo, BOOL forcePrint, BOOL forceMail, BOOL showAll);
+BOOL StartWalkLevel(struct WalkLevel *level, BPTR lock);
+VOID EndWalkLevel(struct WalkLevel *level, BOOL unlock);
+BOOL CheckAbort(VOID);
+LONG GetDeadlineFromEnv(VOID);
+LONG ElapsedMillis(struct DateStamp *since);
+BOOL IdentifyAllowed(VOID);
+BOOL HeaderAllowed(VOID);
+BOOL IdentifyTierAllowed(UWORD tier);
+struct VolumeState *GetVolumeState(struct MsgPort *handler);
+UWORD GetItemTier(struct MsgPort *handler);
+UWORD ResolveVolumeTier(struct MsgPort *handler);
+VOID LoadVolumePolicies(VOID);
+VOID LoadRules(VOID);
+VOID AddRule(STRPTR pattern, UWORD verb, STRPTR tool, LONG order);
+VOID FreeRules(VOID);
+ULONG HashSuffix(STRPTR suffix);
+STRPTR FindRuleTool(STRPTR fileName, UWORD preferredTool);
+UWORD GetPreferredTool(BOOL forceBrowse, BOOL forceEdit, BOOL forceInfo, BOOL forcePrint, BOOL forceMail);
+VOID LoadSizeRoutes(VOID);
+STRPTR GetLargeFileTool(STRPTR fileName, BPTR fileLock, STRPTR typeIdentifier);
+VOID LoadStageStats(VOID);
+VOID SaveStageStats(VOID);
+BOOL WriteStageStats(STRPTR fileName);
+BPTR OpenNewEnvFile(STRPTR fileName);
+struct StageStat *FindStageStat(STRPTR fileName, BOOL create);
+UWORD GetFirstStage(STRPTR fileName);
+UWORD GetLearnedStage(struct StageStat *stat);
+VOID RecordStageWin(STRPTR fileName, UWORD stage);
+STRPTR GetDefIconsTool(STRPTR fileName, BPTR fileLock, STRPTR *typeOut);
+VOID LoadToolPaths(VOID);
+VOID SaveToolPaths(VOID);
+BOOL CheckToolPath(STRPTR tool, UWORD toolFlags, UBYTE *pathOut, LONG pathSize);
+BOOL CheckToolProgram(STRPTR tool, UBYTE *pathOut, LONG pathSize);
+BPTR ErrorOutput(VOID);
+BPTR MessageOutput(VOID);
+VOID PrintError(LONG errorCode);
+BOOL LocateTool(STRPTR tool, UBYTE *pathOut, LONG pathSize, struct DateStamp *dateOut);
+BOOL GetToolDate(BPTR toolLock, struct DateStamp *dateOut);
+VOID LoadSegCache(VOID);
+LONG ReadSegCacheFile(struct SegCacheEntry *entries);
+VOID SaveSegCache(VOID);
+struct SignalSemaphore *GetSegCacheLock(VOID);
+VOID DropSegCacheEntry(LONG index);
+BOOL EvictSegCache(ULONG needed);
+STRPTR GetResidentCommand(STRPTR toolPath);
+VOID MakeResidentName(STRPTR toolPath, UBYTE *nameOut, LONG nameSize);
+VOID AttachSharedCache(VOID);
+VOID DetachSharedCache(VOID);
+BOOL IsSharedCacheStale(struct SharedCache *cache);
+BOOL GetSharedEntry(UWORD kind, STRPTR key, UWORD verb, struct SharedEntry *entryOut);
+VOID PutSharedEntry(struct SharedEntry *entry);
+BOOL GetFileKey(STRPTR fileName, BPTR fileLock, UBYTE *keyOut, LONG keySize);
+VOID GetDefIconDate(STRPTR defIconName, struct DateStamp *dateOut);
+BOOL GetDataTypesDate(struct DateStamp *dateOut);
+ULONG GetItemGroup(STRPTR fileName, BPTR fileLock);
+VOID LoadDTMatch(VOID);
+BOOL ReadDTMatch(struct DateStamp *dirDate);
+LONG CompileDTMatch(struct DateStamp *dirDate);
+LONG CompileDTDescriptor(STRPTR name, struct DTMatchEntry *entry, UBYTE *pool, ULONG *poolUsed);
+VOID WriteDTMatch(VOID);
+BOOL BuildDTBuckets(VOID);
+VOID FreeDTMatch(VOID);
+BOOL MatchDTHeader(STRPTR fileName, ULONG *groupOut);
+VOID SetResolution(const char *kind, STRPTR tool, const char *method, const char *stage);
+VOID ReportResolution(STRPTR fileName, BPTR fileLock);
+const char *GetGroupName(ULONG groupID);
+BOOL InitStats(VOID);
+VOID FreeStats(VOID);
+VOID StatBegin(UWORD stage);
+VOID StatEnd(UWORD stage);
+VOID StatCount(UWORD counter);
+VOID AddTiming(struct StatTiming *timing, ULONG micros);
+VOID ItemStats(STRPTR fileName);
+VOID PrintStats(VOID);
+ULONG EClockMicros(struct EClockVal *from, struct EClockVal *to);
+BOOL InitTrace(STRPTR traceName);
+VOID FreeTrace(VOID);
+VOID ItemBegin(STRPTR fileName);
+VOID TraceMark(UWORD kind, UBYTE phase);
+VOID TraceAdd(UWORD kind, UBYTE phase, struct EClockVal *when);
+BOOL GetMonitorFromEnv(VOID);
+VOID UsageSample(UWORD timing, ULONG micros);
+BOOL ReadUsage(struct UsageFile *usage);
+VOID SaveUsage(VOID);
+LONG PrintUsageReport(VOID);
+BOOL IsVolumeAvailable(STRPTR fileName, BOOL report);
+BOOL CheckVolume(STRPTR volumeName, LONG *errorOut);
+BOOL ReadItemHeader(STRPTR fileName);
+VOID ReadAhead(BPTR dirLock, STRPTR fileName);
+VOID StartReadAhead(BPTR dirLock, STRPTR fileName);
+VOID ClaimReadAhead(STRPTR fileName);
+BOOL TakeReadAhead(UBYTE *buffer, LONG *lengthOut);
+VOID DropReadAhead(VOID);
+VOID DropReadAheadSlot(struct ReadAhead *slot);
+VOID PollReadAhead(VOID);
+VOID ReadAheadReply(struct ReadAhead *slot);
+VOID FreeReadAhead(VOID);
+BOOL IsHunkHeader(VOID);
+BOOL IsTextHeader(VOID);
+STRPTR GetHeaderTypeIdentifier(VOID);
+const struct SuffixType *FindSuffixType(STRPTR fileName);
+STRPTR GetQuickTypeIdentifier(STRPTR fileName);
+BOOL IsTextQuick(STRPTR fileName);
+BOOL IsExecutableQuick(STRPTR fileName);
+BOOL IsExecutableFromInfo(STRPTR fileName);
+BOOL ExamineItem(BPTR fileLock);
+VOID ClearItemInfo(VOID);
 BOOL IsDrawer(STRPTR fileName, BPTR fileLock);
 BOOL IsExecutable(STRPTR fileName, BPTR fileLock);
 BOOL IsBinaryAsset(STRPTR fileName);
 BOOL IsInfoFile(STRPTR fileName);
-BOOL OpenDrawer(STRPTR drawerPath, BOOL showAll);
+BOOL OpenDrawer(STRPTR drawerPath, BPTR drawerLock, BOOL showAll);
+BOOL ShowOpenDrawer(BPTR drawerLock);
 BOOL OpenExecutable(STRPTR execPath);
+BOOL GetHunkNeeds(struct HunkNeeds *needs);
+BOOL CheckLaunchMemory(STRPTR execPath);
+ULONG AddBytes(ULONG total, ULONG bytes);
 BOOL OpenInfoFile(STRPTR fileName, BPTR fileLock);
 BOOL OpenDataFile(STRPTR fileName, BPTR fileLock, STRPTR forceTool, BOOL forceBrowse, BOOL forceEdit, BOOL forceInfo, BOOL forcePrint, BOOL forceMail);
 BOOL IsDefIconsRunning(VOID);
 STRPTR GetDefIconsTypeIdentifier(STRPTR fileName, BPTR fileLock);
 STRPTR GetDefIconsDefaultTool(STRPTR typeIdentifier);
-STRPTR GetDatatypesTool(STRPTR fileName, BPTR fileLock, UWORD preferredTool);
-struct ToolNode *GetDatatypesToolNode(STRPTR fileName, BPTR fileLock, UWORD preferredTool, struct DataType **dtnOut);
+STRPTR GetDatatypesTool(STRPTR fileName, BPTR fileLock, UWORD preferredTool, struct Tool *toolOut);
+struct ToolNode *FindDatatypesToolNode(struct DataType *dtn, UWORD preferredTool);
+struct ToolMemo *FindToolMemo(UWORD source, STRPTR key, UWORD verb);
+struct ToolMemo *AddToolMemo(UWORD source, STRPTR key, UWORD verb);
+BOOL LaunchWorkbenchTool(STRPTR tool, STRPTR fileName, BPTR fileLock);
 STRPTR GetIconDefaultTool(STRPTR fileName, BPTR fileLock);
 BOOL IsTextFile(STRPTR fileName, BPTR fileLock);
 STRPTR GetEditorFromEnv(VOID);
@@ -115,8 +729,9 @@ BOOL LaunchEditorWithSystem(STRPTR editorPath, STRPTR fileName);
 STRPTR GetViewerFromEnv(VOID);
 BOOL LaunchViewerWithSystem(STRPTR viewerPath, STRPTR fileName);
 
-static const char *verstag = "$VER: Open 47.1 (3/1/2026)\n";
-static const char *stack_cookie = "$STACK: 4096\n";
+/* Not static - found by Version and the shell, so they must be kept */
+const char *verstag = "$VER: Open 47.1 (3/1/2026)\n";
+const char *stack_cookie = "$STACK: 4096\n";
 const long oslibversion = 47L;
 
 /* Binary asset extensions to skip */
@@ -130,6 +745,48 @@ static const char *binaryAssets[] = {
     NULL
 };
 
+/* Suffix map for the FAST identification tier */
+/* Maps a file name suffix to a DefIcons type, whose ENV:Sys/def_<type> */
+/* icon then supplies the default tool */
+struct SuffixType {
+    const char *suffix;
+    const char *type;
+    BOOL isText;
+};
+
+static const struct SuffixType suffixTypes[] = {
+    { ".txt",      "ascii",      TRUE  },
+    { ".doc",      "ascii",      TRUE  },
+    { ".readme",   "ascii",      TRUE  },
+    { ".c",        "c",          TRUE  },
+    { ".h",        "h",          TRUE  },
+    { ".asm",      "asm",        TRUE  },
+    { ".s",        "asm",        TRUE  },
+    { ".rexx",     "rexx",       TRUE  },
+    { ".guide",    "amigaguide", TRUE  },
+    { ".html",     "html",       TRUE  },
+    { ".htm",      "html",       TRUE  },
+    { ".iff",      "iff",        FALSE },
+    { ".ilbm",     "ilbm",       FALSE },
+    { ".lbm",      "ilbm",       FALSE },
+    { ".gif",      "gif",        FALSE },
+    { ".jpg",      "jpeg",       FALSE },
+    { ".jpeg",     "jpeg",       FALSE },
+    { ".png",      "png",        FALSE },
+    { ".anim",     "anim",       FALSE },
+    { ".8svx",     "8svx",       FALSE },
+    { ".wav",      "wave",       FALSE },
+    { ".aiff",     "aiff",       FALSE },
+    { ".mod",      "mod",        FALSE },
+    { ".pdf",      "pdf",        FALSE },
+    { ".ps",       "ps",         FALSE },
+    { ".lha",      "lha",        FALSE },
+    { ".lzh",      "lha",        FALSE },
+    { ".lzx",      "lzx",        FALSE },
+    { ".zip",      "zip",        FALSE },
+    { NULL,        NULL,         FALSE }
+};
+
 /* Main entry point */
 int main(int argc, char *argv[])
 {
@@ -149,8 +806,7 @@ int main(int argc, char *argv[])
         wbs = (struct WBStartup *)argv;
         
         /* Initialize libraries */
-        if (!InitializeLibraries()) {
-            LONG errorCode = IoErr();
+        if (!InitializeLibraries(TRUE)) {
             ShowErrorDialog("Open Error", "Failed to initialize libraries.");
             return RETURN_FAIL;
         }
@@ -170,26 +826,61 @@ int main(int argc, char *argv[])
             return RETURN_FAIL;
         }
         
+        /* Identification deadline and monitoring can only come from the environment here */
+        g_deadlineMillis = GetDeadlineFromEnv();
+        g_usageEnabled = GetMonitorFromEnv();
+        LoadVolumePolicies();
+        LoadRules();
+        LoadSizeRoutes();
+        AttachSharedCache();
+        
+        /* $Open/Monitor needs timer.device for EClock reads */
+        if (g_usageEnabled && !InitStats()) {
+            g_usageEnabled = FALSE;
+        }
+        g_timingEnabled = g_usageEnabled;
+        
         /* Process each file argument (skip index 0 which is our tool) */
         for (i = 1, wbarg = &wbs->sm_ArgList[i]; i < wbs->sm_NumArgs; i++, wbarg++) {
             BPTR oldDir = NULL;
             
+            if (CheckAbort()) {
+                success = FALSE;
+                break;
+            }
+            
+            /* Read the next few headers in the background while this item is opened */
+            {
+                LONG ahead;
+                
+                for (ahead = 1; ahead <= READAHEAD_DEPTH && i + ahead < wbs->sm_NumArgs; ahead++) {
+                    if (wbarg[ahead].wa_Lock && wbarg[ahead].wa_Name && *wbarg[ahead].wa_Name) {
+                        ReadAhead(wbarg[ahead].wa_Lock, wbarg[ahead].wa_Name);
+                    }
+                }
+            }
+            
             if (wbarg->wa_Lock && wbarg->wa_Name && *wbarg->wa_Name) {
                 /* Change to the file's directory */
                 oldDir = CurrentDir(wbarg->wa_Lock);
                 
-                /* Open the file */
+                /* Open the file - a failure is noted, not reported, so the rest don't wait */
                 if (OpenItem(wbarg->wa_Name, NULL, FALSE, FALSE, FALSE, FALSE, FALSE, FALSE) != RETURN_OK) {
+                    NoteItemError(wbarg->wa_Name, g_itemError);
                     success = FALSE;
                 }
                 
-                /* Restore original directory */
-                if (oldDir != NULL) {
-                    CurrentDir(oldDir);
-                }
+                /* Restore original directory - 0 is a valid one too */
+                CurrentDir(oldDir);
             }
         }
         
+        /* One requester for everything that failed, once all items are started */
+        ShowErrorSummary();
+        
+        /* $Open/Monitor: add this run to ENVARC:Open/Usage */
+        SaveUsage();
+        
         /* Cleanup */
         Cleanup();
         
@@ -207,15 +898,19 @@ int main(int argc, char *argv[])
         BOOL forcePrint = FALSE;
         BOOL forceMail = FALSE;
         BOOL showAll = FALSE;
+        BOOL recurseAll = FALSE;
+        STRPTR listName = NULL;
         
         /* Command template - matches DataType command */
-        static const char *template = "DRAWER=FILE/M,TOOL/K,VIEW=BROWSE/S,EDIT/S,INFO/S,PRINT/S,MAIL/S,SHOWALL/S";
-        LONG args[8];
+        static const char *template = "DRAWER=FILE/M,TOOL/K,VIEW=BROWSE/S,EDIT/S,INFO/S,PRINT/S,MAIL/S,SHOWALL/S,ALL/S,FROM/K,DEADLINE/K/N,FAST/S,BATCH/S,RESOLVE/S,SETVAR/S,STATS/S,TRACE/K,REPORT/S,BENCH/K/N,COLD/S";
+        LONG args[20];
+        APTR oldWindowPtr = NULL;
+        struct Process *process = NULL;
         
         /* Initialize args array */
         {
             LONG i;
-            for (i = 0; i < 8; i++) {
+            for (i = 0; i < 20; i++) {
                 args[i] = 0;
             }
         }
@@ -225,7 +920,7 @@ int main(int argc, char *argv[])
         if (!rda) {
             LONG errorCode = IoErr();
             if (errorCode != 0) {
-                PrintFault(errorCode, "Open");
+                PrintError(errorCode);
             } else {
                 ShowUsage();
             }
@@ -240,15 +935,70 @@ int main(int argc, char *argv[])
         forcePrint = (BOOL)(args[5] != 0);
         forceMail = (BOOL)(args[6] != 0);
         showAll = (BOOL)(args[7] != 0);
+        recurseAll = (BOOL)(args[8] != 0);
+        listName = (STRPTR)args[9];
         
-        /* Initialize libraries */
-        if (!InitializeLibraries()) {
+        /* DEADLINE overrides the Open/Deadline environment variable */
+        if (args[10]) {
+            g_deadlineMillis = *(LONG *)args[10];
+        } else {
+            g_deadlineMillis = GetDeadlineFromEnv();
+        }
+        g_forceFast = (BOOL)(args[11] != 0);
+        g_batchMode = (BOOL)(args[12] != 0);
+        g_resolveOnly = (BOOL)(args[13] != 0);
+        g_resolveVars = (BOOL)(args[14] != 0);
+        g_statsEnabled = (BOOL)(args[15] != 0);
+        g_traceName = (STRPTR)args[16];
+        g_usageReport = (BOOL)(args[17] != 0);
+        g_usageEnabled = GetMonitorFromEnv();
+        
+        /* BENCH: repeat the decision without launching anything */
+        if (args[18] && *(LONG *)args[18] > 0) {
+            g_benchCount = (ULONG)*(LONG *)args[18];
+            if (g_benchCount > BENCH_MAX) {
+                g_benchCount = BENCH_MAX;
+            }
+            g_benchCold = (BOOL)(args[19] != 0);
+            g_resolveOnly = TRUE;
+        }
+        
+        /* Initialize libraries - RESOLVE launches nothing and needs fewer */
+        if (!InitializeLibraries(!g_resolveOnly)) {
             LONG errorCode = IoErr();
-            PrintFault(errorCode ? errorCode : ERROR_OBJECT_NOT_FOUND, "Open");
+            PrintError(errorCode ? errorCode : ERROR_OBJECT_NOT_FOUND);
             FreeArgs(rda);
             return RETURN_FAIL;
         }
         
+        /* Per-volume identification policy and tool rules */
+        LoadVolumePolicies();
+        LoadRules();
+        LoadSizeRoutes();
+        AttachSharedCache();
+        
+        /* STATS, TRACE, BENCH and $Open/Monitor: need timer.device for EClock reads */
+        if ((g_statsEnabled || g_traceName || g_usageEnabled || g_benchCount) && !InitStats()) {
+            FPrintf(MessageOutput(), "Open: Could not open timer.device, timing disabled\n");
+            g_statsEnabled = FALSE;
+            g_traceName = NULL;
+            g_usageEnabled = FALSE;
+            g_benchCount = 0;
+        }
+        g_timingEnabled = (BOOL)(g_statsEnabled || g_usageEnabled || g_benchCount);
+        if (g_traceName && !InitTrace(g_traceName)) {
+            LONG errorCode = IoErr();
+            PrintError(errorCode ? errorCode : ERROR_NO_FREE_STORE);
+            FPrintf(MessageOutput(), "Open: TRACE disabled\n");
+        }
+        
+        /* BATCH: suppress "Please insert volume" and other DOS requesters */
+        if (g_batchMode) {
+            process = (struct Process *)FindTask(NULL);
+            oldWindowPtr = process->pr_WindowPtr;
+            process->pr_WindowPtr = (APTR)-1L;
+        }
+        
         /* FILE/M returns an array of string pointers (STRPTR *), last entry is NULL */
         {
             STRPTR *fileArray = (STRPTR *)args[0];
@@ -257,6 +1007,15 @@ int main(int argc, char *argv[])
             /* Initialize result to OK - will be set to FAIL if any file fails */
             result = RETURN_OK;
             
+            /* BATCH: resolve every distinct volume once, before opening anything */
+            if (g_batchMode && fileArray) {
+                LONG i;
+                
+                for (i = 0; fileArray[i] != NULL; i++) {
+                    IsVolumeAvailable(fileArray[i], FALSE);
+                }
+            }
+            
             if (fileArray && fileArray[0]) {
                 /* Process each file in the array */
                 LONG i = 0;
@@ -264,8 +1023,22 @@ int main(int argc, char *argv[])
                     fileName = fileArray[i];
                     fileCount++;
                     
+                    if (CheckAbort()) {
+                        result = RETURN_FAIL;
+                        break;
+                    }
+                    
+                    /* Read the next few headers in the background while this item is opened */
+                    if (!recurseAll) {
+                        LONG ahead;
+                        
+                        for (ahead = 1; ahead <= READAHEAD_DEPTH && fileArray[i + ahead] != NULL; ahead++) {
+                            ReadAhead(NULL, fileArray[i + ahead]);
+                        }
+                    }
+                    
                     /* Open the item */
-                    if (OpenItem(fileName, forceTool, forceBrowse, forceEdit, forceInfo, forcePrint, forceMail, showAll) != RETURN_OK) {
+                    if (OpenArgument(fileName, forceTool, forceBrowse, forceEdit, forceInfo, forcePrint, forceMail, showAll, recurseAll) != RETURN_OK) {
                         result = RETURN_FAIL;
                     }
                     
@@ -273,6 +1046,30 @@ int main(int argc, char *argv[])
                 }
             }
             
+            /* Stream further names from a list file or stdin */
+            if (listName && *listName) {
+                if (OpenFromList(listName, forceTool, forceBrowse, forceEdit, forceInfo, forcePrint, forceMail, showAll, recurseAll, &fileCount) != RETURN_OK) {
+                    result = RETURN_FAIL;
+                }
+            }
+            
+            /* With ALL and no files, walk the current directory */
+            if (fileCount == 0 && recurseAll) {
+                fileCount++;
+                result = OpenTree((STRPTR)"", forceTool, forceBrowse, forceEdit, forceInfo, forcePrint, forceMail, showAll);
+            }
+            
+            /* REPORT and no files - only print the usage aggregates */
+            if (fileCount == 0 && g_usageReport) {
+                fileCount++;
+            }
+            
+            /* RESOLVE and no files - report on the current directory */
+            if (fileCount == 0 && g_resolveOnly) {
+                fileCount++;
+                result = OpenItem((STRPTR)"", forceTool, forceBrowse, forceEdit, forceInfo, forcePrint, forceMail, showAll);
+            }
+            
             /* If no files were provided, open current directory */
             if (fileCount == 0) {
                 /* No arguments - open current directory */
@@ -297,20 +1094,25 @@ int main(int argc, char *argv[])
                         }
                         tags[tagIndex].ti_Tag = TAG_DONE;
                         
-                        /* Open the current directory as a drawer */
+                        /* Open the current directory as a drawer, or bring it to front */
                         SetIoErr(0);
-                        result = OpenWorkbenchObjectA(currentDirName, tags) ? RETURN_OK : RETURN_FAIL;
+                        if (!showAll && ShowOpenDrawer(currentDirLock)) {
+                            result = RETURN_OK;
+                        } else {
+                            StatCount(COUNT_WBOPEN);
+                            result = OpenWorkbenchObjectA(currentDirName, tags) ? RETURN_OK : RETURN_FAIL;
+                        }
                         if (result != RETURN_OK) {
                             LONG errorCode = IoErr();
                             if (errorCode != 0) {
-                                PrintFault(errorCode, "Open");
+                                PrintError(errorCode);
                             } else {
-                                Printf("Open: Failed to open current directory\n");
+                                FPrintf(MessageOutput(), "Open: Failed to open current directory\n");
                             }
                         }
                     } else {
                         /* Failed to get directory name */
-                        Printf("Open: Could not get current directory name\n");
+                        FPrintf(MessageOutput(), "Open: Could not get current directory name\n");
                         result = RETURN_FAIL;
                     }
                 } else {
@@ -326,13 +1128,14 @@ int main(int argc, char *argv[])
                     tags[tagIndex].ti_Tag = TAG_DONE;
                     
                     SetIoErr(0);
+                    StatCount(COUNT_WBOPEN);
                     result = OpenWorkbenchObjectA("", tags) ? RETURN_OK : RETURN_FAIL;
                     if (result != RETURN_OK) {
                         LONG errorCode = IoErr();
                         if (errorCode != 0) {
-                            PrintFault(errorCode, "Open");
+                            PrintError(errorCode);
                         } else {
-                            Printf("Open: Failed to open root directory\n");
+                            FPrintf(MessageOutput(), "Open: Failed to open root directory\n");
                         }
                     }
                 }
@@ -340,10 +1143,25 @@ int main(int argc, char *argv[])
         }
         
         /* Cleanup */
+        if (process) {
+            process->pr_WindowPtr = oldWindowPtr;
+        }
+        
         if (rda) {
             FreeArgs(rda);
         }
         
+        /* STATS: totals for the whole run */
+        if (g_statsEnabled) {
+            PrintStats();
+        }
+        
+        /* $Open/Monitor: add this run to ENVARC:Open/Usage, REPORT: show it */
+        SaveUsage();
+        if (g_usageReport && PrintUsageReport() != RETURN_OK && result == RETURN_OK) {
+            result = RETURN_WARN;
+        }
+        
         Cleanup();
         
         return result;
@@ -351,10 +1169,13 @@ int main(int argc, char *argv[])
 }
 
 /* Initialize required libraries */
-BOOL InitializeLibraries(VOID)
+/* Without launching (RESOLVE), intuition, workbench and datatypes are */
+/* optional - identification then falls back to DefIcons, the header and */
+/* the name, e.g. when run under a user-space emulator */
+BOOL InitializeLibraries(BOOL launching)
 {
     IntuitionBase = (struct IntuitionBase *)OpenLibrary("intuition.library", 39L);
-    if (!IntuitionBase) {
+    if (!IntuitionBase && launching) {
         SetIoErr(ERROR_OBJECT_NOT_FOUND);
         return FALSE;
     }
@@ -362,13 +1183,15 @@ BOOL InitializeLibraries(VOID)
     UtilityBase = OpenLibrary("utility.library", 39L);
     if (!UtilityBase) {
         SetIoErr(ERROR_OBJECT_NOT_FOUND);
-        CloseLibrary((struct Library *)IntuitionBase);
-        IntuitionBase = NULL;
+        if (IntuitionBase) {
+            CloseLibrary((struct Library *)IntuitionBase);
+            IntuitionBase = NULL;
+        }
         return FALSE;
     }
     
     WorkbenchBase = OpenLibrary("workbench.library", 44L);
-    if (!WorkbenchBase) {
+    if (!WorkbenchBase && launching) {
         SetIoErr(ERROR_OBJECT_NOT_FOUND);
         CloseLibrary(UtilityBase);
         UtilityBase = NULL;
@@ -378,7 +1201,7 @@ BOOL InitializeLibraries(VOID)
     }
     
     DataTypesBase = OpenLibrary("datatypes.library", 45L);
-    if (!DataTypesBase) {
+    if (!DataTypesBase && launching) {
         SetIoErr(ERROR_OBJECT_NOT_FOUND);
         CloseLibrary(WorkbenchBase);
         WorkbenchBase = NULL;
@@ -419,6 +1242,22 @@ BOOL InitializeApplication(VOID)
 /* Cleanup libraries */
 VOID Cleanup(VOID)
 {
+    /* Free the compiled rules, write the TRACE log and free the timer */
+    FreeRules();
+    FreeDTMatch();
+    FreeTrace();
+    FreeStats();
+    FreeReadAhead();
+    
+    /* Keep what was learned about the resolution stages and tool paths */
+    if (g_benchCount == 0) {
+        /* BENCH repeats items - that would skew what was learned */
+        SaveStageStats();
+    }
+    SaveToolPaths();
+    SaveSegCache();
+    DetachSharedCache();
+    
     /* Close Reaction classes first */
     if (RequesterClass != NULL) {
         /* For Reaction classes, we don't call FreeClass - just clear the pointer */
@@ -460,7 +1299,7 @@ VOID Cleanup(VOID)
 /* Show usage information */
 VOID ShowUsage(VOID)
 {
-    Printf("Usage: Open FILE=<filename> [TOOL=<toolname>] [VIEW=BROWSE] [EDIT] [INFO] [PRINT] [MAIL]\n");
+    Printf("Usage: Open FILE=<filename> [TOOL=<toolname>] [VIEW=BROWSE] [EDIT] [INFO] [PRINT] [MAIL] [SHOWALL] [ALL] [FROM=<listfile>] [DEADLINE=<ms>] [FAST] [BATCH] [RESOLVE] [SETVAR] [STATS] [TRACE=<file>] [REPORT] [BENCH=<n>] [COLD]\n");
     Printf("\n");
     Printf("Options:\n");
     Printf("  FILE=<filename>  - File, drawer, or executable to open (required)\n");
@@ -471,11 +1310,26 @@ VOID ShowUsage(VOID)
     Printf("  PRINT            - Force PRINT tool for data files\n");
     Printf("  MAIL             - Force MAIL tool for data files\n");
     Printf("  SHOWALL          - Show all files when opening drawers\n");
+    Printf("  ALL              - Open every file in the drawer tree\n");
+    Printf("  FROM=<listfile>  - Read names to open from a file, one per line (* = stdin)\n");
+    Printf("  DEADLINE=<ms>    - Identify by name only once a file takes longer than this\n");
+    Printf("  FAST             - Identify files by name only (see ENV:Open/Volumes)\n");
+    Printf("  BATCH            - Never show DOS requesters, fail fast on missing volumes\n");
+    Printf("  RESOLVE          - Print what would be done with each item, launch nothing\n");
+    Printf("  SETVAR           - With RESOLVE, set local variables OpenKind, OpenTool, ...\n");
+    Printf("  STATS            - Print the time spent in each stage per file and at exit\n");
+    Printf("  TRACE=<file>     - Write begin/end events of every stage to a timeline log\n");
+    Printf("  REPORT           - Print the counters and histograms in ENVARC:Open/Usage\n");
+    Printf("  BENCH=<n>        - Resolve each item n times, print p50/p90/p99/max per stage\n");
+    Printf("  COLD             - With BENCH, forget cached results between runs\n");
+    Printf("\n");
+    Printf("File names may end in /EDIT, /PRINT, ... or /TOOL=<tool> for that file only\n");
     Printf("\n");
     Printf("Open intelligently opens files, drawers, and executables:\n");
     Printf("  - Drawers are opened in Workbench\n");
     Printf("  - Executables are launched (binary assets like .library are skipped)\n");
     Printf("  - Data files are opened with the most appropriate tool\n");
+    Printf("  - Patterns in ENV:Open/Rules pick a tool without identification\n");
     Printf("\n");
     Printf("Examples:\n");
     Printf("  Open RAM:                    - Open RAM: drawer\n");
@@ -483,6 +1337,11 @@ VOID ShowUsage(VOID)
     Printf("  Open test.txt                - Open with default tool\n");
     Printf("  Open test.txt BROWSE         - Force BROWSE tool\n");
     Printf("  Open test.txt TOOL=MultiView - Force specific tool\n");
+    Printf("  Open a.txt/EDIT b.txt/PRINT  - Edit one file, print the other\n");
+    Printf("  Open Work:Docs ALL PRINT     - Print every file below Work:Docs\n");
+    Printf("  List Work:Pics FILES LFORMAT=%%p%%n >T:files\n");
+    Printf("  Open FROM=T:files            - Open every file named in T:files\n");
+    Printf("  Open Work:Docs ALL RESOLVE   - List the tool for every file, start none\n");
 }
 
 /* Show error dialog using Reaction requester */
@@ -512,6 +1371,55 @@ VOID ShowErrorDialog(STRPTR title, STRPTR message)
     }
 }
 
+/* Note an item that failed in Workbench mode, for ShowErrorSummary() */
+VOID NoteItemError(STRPTR fileName, LONG errorCode)
+{
+    UBYTE reason[80];
+    UBYTE line[160];
+    
+    g_errorCount++;
+    if (g_errorCount > ERROR_SUMMARY_LINES) {
+        return;
+    }
+    
+    if (errorCode == 0 || Fault(errorCode, NULL, reason, sizeof(reason)) <= 0) {
+        strcpy(reason, "could not be opened");
+    }
+    SNPrintf(line, sizeof(line), "%s: %s\n", fileName, reason);
+    Strlcat(g_errorSummary, line, sizeof(g_errorSummary));
+}
+
+/* Show the items noted by NoteItemError() in a single requester */
+VOID ShowErrorSummary(VOID)
+{
+    UBYTE *message;
+    
+    if (g_errorCount == 0) {
+        return;
+    }
+    
+    message = AllocVec(ERROR_SUMMARY_SIZE + 80, MEMF_ANY);
+    if (message == NULL) {
+        return;
+    }
+    
+    if (g_errorCount == 1) {
+        strcpy(message, "1 item could not be opened:\n\n");
+    } else {
+        SNPrintf(message, ERROR_SUMMARY_SIZE + 80, "%ld items could not be opened:\n\n", g_errorCount);
+    }
+    Strlcat(message, g_errorSummary, ERROR_SUMMARY_SIZE + 80);
+    if (g_errorCount > ERROR_SUMMARY_LINES) {
+        UBYTE more[40];
+        
+        SNPrintf(more, sizeof(more), "...and %ld more\n", g_errorCount - ERROR_SUMMARY_LINES);
+        Strlcat(message, more, ERROR_SUMMARY_SIZE + 80);
+    }
+    
+    ShowErrorDialog("Open Error", message);
+    FreeVec(message);
+}
+
 /* Main open function - determines type and opens appropriately */
 LONG OpenItem(STRPTR fileName, STRPTR forceTool, BOOL forceBrowse, BOOL forceEdit, BOOL forceInfo, BOOL forcePrint, BOOL forceMail, BOOL showAll)
 {
@@ -519,18 +1427,58 @@ LONG OpenItem(STRPTR fileName, STRPTR forceTool, BOOL forceBrowse, BOOL forceEdi
     LONG result = RETURN_FAIL;
     LONG errorCode = 0;
     
+    /* BENCH: every item is run through BenchItem(), which calls back here */
+    if (g_benchCount && !g_benchSamples) {
+        return BenchItem(fileName, forceTool, forceBrowse, forceEdit, forceInfo, forcePrint, forceMail, showAll);
+    }
+    
+    /* Start the identification clock - the Lock() itself counts against the deadline */
+    DateStamp(&g_item.started);
+    g_itemError = 0;
+    
+    ItemBegin(fileName);
+    ClaimReadAhead(fileName);
+    
+    /* BATCH: fail straight away if the item's volume is not there */
+    if (g_batchMode && !IsVolumeAvailable(fileName, TRUE)) {
+        g_itemError = IoErr();
+        ItemStats(fileName);
+        ClearItemInfo();
+        return RETURN_FAIL;
+    }
+    
     /* Lock the file/drawer */
+    StatBegin(STAT_LOCK);
+    StatCount(COUNT_LOCK);
     fileLock = Lock(fileName, ACCESS_READ);
+    StatEnd(STAT_LOCK);
     if (!fileLock) {
         errorCode = IoErr();
-        PrintFault(errorCode ? errorCode : ERROR_OBJECT_NOT_FOUND, "Open");
+        g_itemError = errorCode;
+        PrintError(errorCode ? errorCode : ERROR_OBJECT_NOT_FOUND);
+        if (g_resolveOnly && !g_aborted && (!g_benchSamples || g_benchIteration == 0)) {
+            /* Scripts reading the records still get one for this item */
+            SetResolution("missing", NULL, NULL, NULL);
+            ReportResolution(fileName, NULL);
+        }
+        ItemStats(fileName);
+        ClearItemInfo();
         return RETURN_FAIL;
     }
     
+    /* Remember the volume so a slow one is recognised without further I/O, */
+    /* and pick how deeply items on it are identified */
+    g_item.handler = ((struct FileLock *)BADDR(fileLock))->fl_Task;
+    g_item.tier = GetItemTier(g_item.handler);
+    
     /* Determine what type of item this is */
     /* Check for .info files first (before drawer check) */
-    if (IsInfoFile(fileName)) {
+    if (CheckAbort()) {
+        /* Ctrl-C - leave the item alone */
+        result = RETURN_FAIL;
+    } else if (IsInfoFile(fileName)) {
         /* It's a .info file */
+        g_resolution.kind = "info";
         if (forceTool && *forceTool) {
             /* Explicit tool specified - use it directly */
             result = OpenDataFile(fileName, fileLock, forceTool, forceBrowse, forceEdit, forceInfo, forcePrint, forceMail) ? RETURN_OK : RETURN_FAIL;
@@ -557,8 +1505,8 @@ LONG OpenItem(STRPTR fileName, STRPTR forceTool, BOOL forceBrowse, BOOL forceEdi
             }
             
             /* Check datatypes toolnodes for a tool */
-            if (DataTypesBase) {
-                datatypesTool = GetDatatypesTool(fileName, fileLock, preferredTool);
+            if (DataTypesBase && IdentifyAllowed()) {
+                datatypesTool = GetDatatypesTool(fileName, fileLock, preferredTool, NULL);
                 if (datatypesTool && *datatypesTool) {
                     toolFound = TRUE;
                 }
@@ -580,12 +1528,20 @@ LONG OpenItem(STRPTR fileName, STRPTR forceTool, BOOL forceBrowse, BOOL forceEdi
         }
     } else if (IsDrawer(fileName, fileLock)) {
         /* It's a drawer - open it */
-        result = OpenDrawer(fileName, showAll) ? RETURN_OK : RETURN_FAIL;
-    } else if (IsExecutable(fileName, fileLock)) {
+        result = OpenDrawer(fileName, fileLock, showAll) ? RETURN_OK : RETURN_FAIL;
+    } else if (!FindRuleTool(fileName, GetPreferredTool(forceBrowse, forceEdit, forceInfo, forcePrint, forceMail)) &&
+               IsExecutable(fileName, fileLock)) {
         /* It's an executable - check if it's a binary asset */
         if (IsBinaryAsset(fileName)) {
-            Printf("Open: Skipping binary asset: %s\n", fileName);
+            if (g_resolveOnly) {
+                SetResolution("asset", NULL, "skip", "asset");
+            } else {
+                Printf("Open: Skipping binary asset: %s\n", fileName);
+            }
             result = RETURN_OK; /* Not an error, just skipped */
+        } else if (g_aborted) {
+            /* Ctrl-C while identifying - don't launch */
+            result = RETURN_FAIL;
         } else {
             /* Launch the executable */
             result = OpenExecutable(fileName) ? RETURN_OK : RETURN_FAIL;
@@ -595,131 +1551,4345 @@ LONG OpenItem(STRPTR fileName, STRPTR forceTool, BOOL forceBrowse, BOOL forceEdi
         result = OpenDataFile(fileName, fileLock, forceTool, forceBrowse, forceEdit, forceInfo, forcePrint, forceMail) ? RETURN_OK : RETURN_FAIL;
     }
     
+    /* The cleanup below may change IoErr() - keep the reason for failing */
+    if (result != RETURN_OK) {
+        g_itemError = IoErr();
+    }
+    
+    /* RESOLVE: print what was decided */
+    if (g_resolveOnly && !g_aborted && (!g_benchSamples || g_benchIteration == 0)) {
+        ReportResolution(fileName, fileLock);
+    }
+    
     /* Cleanup */
     UnLock(fileLock);
+    ItemStats(fileName);
+    ClearItemInfo();
     
     return result;
 }
 
-/* Check if item is a drawer */
-BOOL IsDrawer(STRPTR fileName, BPTR fileLock)
+/* Open one argument - a single item, or with ALL a whole drawer tree */
+LONG OpenArgument(STRPTR fileName, STRPTR forceTool, BOOL forceBrowse, BOOL forceEdit, BOOL forceInfo, BOOL forcePrint, BOOL forceMail, BOOL showAll, BOOL recurseAll)
 {
-    struct FileInfoBlock *fib = NULL;
-    BOOL result = FALSE;
-    
-    if (!fileLock) {
-        return FALSE;
+    STRPTR tool = NULL;
+    UWORD verb = 0;
+    BOOL all = FALSE;
+    LONG cut;
+    UBYTE saved = 0;
+    LONG result;
+    
+    /* Qualifiers on the argument override the switches for this argument only */
+    cut = ParseQualifiers(fileName, TRUE, &tool, &verb, &all);
+    if (cut > 0) {
+        saved = fileName[cut];
+        fileName[cut] = '\0';
+        
+        if (tool != NULL) {
+            forceTool = tool;
+        }
+        if (verb != 0) {
+            forceBrowse = (BOOL)(verb == TW_BROWSE);
+            forceEdit = (BOOL)(verb == TW_EDIT);
+            forceInfo = (BOOL)(verb == TW_INFO);
+            forcePrint = (BOOL)(verb == TW_PRINT);
+            forceMail = (BOOL)(verb == TW_MAIL);
+        }
+        if (all) {
+            showAll = TRUE;
+        }
     }
     
-    fib = (struct FileInfoBlock *)AllocMem(sizeof(struct FileInfoBlock), MEMF_CLEAR);
-    if (!fib) {
-        return FALSE;
+    if (recurseAll) {
+        result = OpenTree(fileName, forceTool, forceBrowse, forceEdit, forceInfo, forcePrint, forceMail, showAll);
+    } else {
+        result = OpenItem(fileName, forceTool, forceBrowse, forceEdit, forceInfo, forcePrint, forceMail, showAll);
     }
     
-    if (Examine(fileLock, fib)) {
-        if (fib->fib_DirEntryType == ST_USERDIR) {
-            result = TRUE;
-        }
+    if (cut > 0) {
+        fileName[cut] = saved;
     }
     
-    FreeMem(fib, sizeof(struct FileInfoBlock));
-    
     return result;
 }
 
-/* Check if item is an executable */
-BOOL IsExecutable(STRPTR fileName, BPTR fileLock)
+/* Find per-argument qualifiers: name/EDIT, name/PRINT/SHOWALL, name/TOOL=x */
+/* Returns the length of the name without them, or 0 if there are none */
+/* With checkName, a name that exists as given has no qualifiers - that */
+/* costs a Lock(), so the read-ahead leaves it out and only guesses */
+LONG ParseQualifiers(STRPTR fileName, BOOL checkName, STRPTR *toolOut, UWORD *verbOut, BOOL *showAllOut)
 {
-    STRPTR defIconsType = NULL;
-    STRPTR filePart = NULL;
-    STRPTR filePartPtr = NULL;
-    BOOL isToolType = FALSE;
-    BOOL isBinaryType = FALSE;
-    BOOL isHunkFormat = FALSE;
-    BPTR fileHandle = NULL;
-    LONG bytesRead = 0;
-    BPTR parentLock = NULL;
-    BPTR oldDir = NULL;
+    LONG end;
+    LONG i;
+    BPTR lock;
     
-    if (!fileName || !fileLock) {
-        return FALSE;
-    }
+    *toolOut = NULL;
+    *verbOut = 0;
+    *showAllOut = FALSE;
     
-    /* Check DefIcons type identifier for 'tool' */
-    if (IconBase && IsDefIconsRunning()) {
-        filePartPtr = FilePart(fileName);
-        if (filePartPtr != NULL && *filePartPtr != '\0') {
-            UBYTE fileNameCopy[256];
-            STRPTR fileNamePart = NULL;
-            
-            /* Make a copy of the filename part */
-            Strncpy(fileNameCopy, filePartPtr, sizeof(fileNameCopy));
-            fileNamePart = fileNameCopy;
-            
-            parentLock = ParentDir(fileLock);
-            if (parentLock) {
-                oldDir = CurrentDir(parentLock);
-                defIconsType = GetDefIconsTypeIdentifier(fileNamePart, parentLock);
-                CurrentDir(oldDir);
-                UnLock(parentLock);
-            }
-            
-            if (defIconsType && *defIconsType != '\0') {
-                /* Check if type identifier is 'tool' (case-insensitive) */
-                if (Stricmp(defIconsType, "tool") == 0) {
-                    isToolType = TRUE;
-                }
-            }
+    if (strchr(fileName, '/') == NULL) {
+        return 0;
+    }
+    end = strlen(fileName);
+    
+    /* TOOL= must come last, as the tool name may contain / itself */
+    for (i = 1; fileName[i] != '\0'; i++) {
+        if (fileName[i] == '/' && Strnicmp(fileName + i + 1, (STRPTR)"TOOL=", 5) == 0 && fileName[i + 6] != '\0') {
+            *toolOut = fileName + i + 6;
+            end = i;
+            break;
         }
     }
     
-    /* Check datatypes for 'binary' group ID */
-    if (!isToolType && DataTypesBase) {
-        struct DataType *dtn = NULL;
+    /* Then verbs and SHOWALL, one per /, the last verb given wins */
+    while (end > 0) {
+        UBYTE word[8];
+        LONG start = end;
+        LONG length;
+        
+        while (start > 0 && fileName[start - 1] != '/') {
+            start--;
+        }
+        length = end - start;
+        if (start < 2 || length == 0 || length >= sizeof(word)) {
+            /* No / or no name left in front of it */
+            break;
+        }
+        memcpy(word, fileName + start, length);
+        word[length] = '\0';
         
-        dtn = ObtainDataTypeA(DTST_FILE, (APTR)fileLock, NULL);
-        if (dtn) {
-            /* Check if group ID is GID_BINARY */
-            if (dtn->dtn_Header->dth_GroupID == GID_BINARY) {
-                isBinaryType = TRUE;
+        if (Stricmp(word, "SHOWALL") == 0) {
+            *showAllOut = TRUE;
+        } else if (Stricmp(word, "BROWSE") == 0 || Stricmp(word, "VIEW") == 0) {
+            if (*verbOut == 0) {
+                *verbOut = TW_BROWSE;
+            }
+        } else if (Stricmp(word, "EDIT") == 0) {
+            if (*verbOut == 0) {
+                *verbOut = TW_EDIT;
+            }
+        } else if (Stricmp(word, "INFO") == 0) {
+            if (*verbOut == 0) {
+                *verbOut = TW_INFO;
+            }
+        } else if (Stricmp(word, "PRINT") == 0) {
+            if (*verbOut == 0) {
+                *verbOut = TW_PRINT;
             }
-            ReleaseDataType(dtn);
+        } else if (Stricmp(word, "MAIL") == 0) {
+            if (*verbOut == 0) {
+                *verbOut = TW_MAIL;
+            }
+        } else {
+            break;
         }
+        end = start - 1;
     }
     
-    /* If neither tool nor binary type, not an executable */
-    if (!isToolType && !isBinaryType) {
-        return FALSE;
+    if (*toolOut == NULL && *verbOut == 0 && !*showAllOut) {
+        return 0;
     }
     
-    /* Check if file is HUNK format by reading first 4 bytes */
-    fileHandle = Open((STRPTR)fileName, MODE_OLDFILE);
-    if (fileHandle) {
-        UBYTE hunkBytes[4];
-        
-        bytesRead = Read(fileHandle, hunkBytes, 4);
-        Close(fileHandle);
-        
-        if (bytesRead == 4) {
-            /* Check for HUNK_HEADER (00 00 03 F3) - executable files only */
-            /* Amiga is big-endian, so bytes are in order: [00, 00, 03, F3] */
-            /* Note: We only check for HUNK_HEADER, not HUNK_UNIT (object files) */
-            if (hunkBytes[0] == 0x00 && hunkBytes[1] == 0x00 && 
-                hunkBytes[2] == 0x03 && hunkBytes[3] == 0xF3) {
-                isHunkFormat = TRUE;
-            }
-        }
+    if (!checkName) {
+        return end;
     }
     
-    /* If not HUNK format, not an executable */
-    if (!isHunkFormat) {
-        return FALSE;
+    /* A file or drawer that really has this name is opened as it is */
+    StatCount(COUNT_LOCK);
+    lock = Lock(fileName, SHARED_LOCK);
+    if (lock) {
+        UnLock(lock);
+        *toolOut = NULL;
+        *verbOut = 0;
+        *showAllOut = FALSE;
+        return 0;
     }
     
-    /* Check if filename has a period - if it does, it's probably a library/device (not runnable) */
-    filePart = FilePart(fileName);
-    if (filePart) {
-        STRPTR periodPtr;
+    return end;
+}
+
+/* BENCH - run the whole decision for one item n times, then print percentiles */
+LONG BenchItem(STRPTR fileName, STRPTR forceTool, BOOL forceBrowse, BOOL forceEdit, BOOL forceInfo, BOOL forcePrint, BOOL forceMail, BOOL showAll)
+{
+    LONG result = RETURN_OK;
+    ULONG runs;
+    
+    g_benchSamples = (ULONG *)AllocVec(BENCH_TIMINGS * g_benchCount * sizeof(ULONG), MEMF_ANY);
+    if (!g_benchSamples) {
+        PrintError(ERROR_NO_FREE_STORE);
+        return RETURN_FAIL;
+    }
+    
+    for (runs = 0; runs < g_benchCount; runs++) {
+        if (CheckAbort()) {
+            result = RETURN_FAIL;
+            break;
+        }
+        
+        if (g_benchCold) {
+            FlushCaches();
+        }
+        
+        g_benchIteration = runs;
+        result = OpenItem(fileName, forceTool, forceBrowse, forceEdit, forceInfo, forcePrint, forceMail, showAll);
+        if (result != RETURN_OK) {
+            /* The error has been reported once - no point repeating it */
+            break;
+        }
+    }
+    
+    if (runs > 0) {
+        PrintBench(fileName, runs);
+    }
+    
+    FreeVec(g_benchSamples);
+    g_benchSamples = NULL;
+    
+    return result;
+}
+
+/* COLD - forget what this process has cached between BENCH runs */
+/* The shared cache is skipped altogether while COLD is set */
+VOID FlushCaches(VOID)
+{
+    LONG i;
+    
+    g_toolMemoCount = 0;
+    g_toolMemoNext = 0;
+    g_volumeCount = 0;
+    g_volumeCheckCount = 0;
+    
+    /* Tool paths are checked against the disk again */
+    for (i = 0; i < g_toolPathCount; i++) {
+        g_toolPaths[i].checked = FALSE;
+    }
+}
+
+/* Shell sort of microsecond values, in place */
+VOID SortMicros(ULONG *values, ULONG count)
+{
+    ULONG gap;
+    ULONG i;
+    ULONG j;
+    ULONG value;
+    
+    for (gap = count / 2; gap > 0; gap /= 2) {
+        for (i = gap; i < count; i++) {
+            value = values[i];
+            for (j = i; j >= gap && values[j - gap] > value; j -= gap) {
+                values[j] = values[j - gap];
+            }
+            values[j] = value;
+        }
+    }
+}
+
+/* Print p50/p90/p99 and worst time of each stage over the BENCH runs */
+VOID PrintBench(STRPTR fileName, ULONG runs)
+{
+    static const UWORD percents[3] = { 50, 90, 99 };
+    ULONG *values;
+    ULONG value;
+    LONG i;
+    LONG j;
+    
+    Printf("Bench: %s: %lu runs%s\n", fileName, runs, (LONG)(g_benchCold ? " (cold)" : ""));
+    Printf("Bench: stage          p50 ms      p90 ms      p99 ms      max ms\n");
+    
+    for (i = 0; i < BENCH_TIMINGS; i++) {
+        values = &g_benchSamples[i * g_benchCount];
+        SortMicros(values, runs);
+        
+        /* Stages this item never went through are left out */
+        if (values[runs - 1] == 0 && i != BENCH_ITEM) {
+            continue;
+        }
+        
+        Printf("Bench: %-10s", (i == BENCH_ITEM) ? "item" : statNames[i]);
+        for (j = 0; j < 3; j++) {
+            /* Nearest rank */
+            value = values[(runs * percents[j] + 99) / 100 - 1];
+            Printf(" %7lu.%03lu", value / 1000, value % 1000);
+        }
+        Printf(" %7lu.%03lu\n", values[runs - 1] / 1000, values[runs - 1] % 1000);
+    }
+}
+
+/* Open every name listed in a file (or stdin for "*"), one name per line */
+/* Lines are read one at a time through buffered DOS I/O, so a list of any */
+/* length is processed with constant memory */
+LONG OpenFromList(STRPTR listName, STRPTR forceTool, BOOL forceBrowse, BOOL forceEdit, BOOL forceInfo, BOOL forcePrint, BOOL forceMail, BOOL showAll, BOOL recurseAll, LONG *countOut)
+{
+    BPTR listFile = NULL;
+    BOOL fromStdin = FALSE;
+    UBYTE line[MAX_LIST_LINE];
+    LONG result = RETURN_OK;
+    LONG errorCode = 0;
+    
+    if (!listName || !*listName) {
+        return RETURN_FAIL;
+    }
+    
+    /* FROM=* reads the names from standard input */
+    if (strcmp(listName, "*") == 0) {
+        listFile = Input();
+        fromStdin = TRUE;
+    } else {
+        listFile = Open(listName, MODE_OLDFILE);
+    }
+    
+    if (!listFile) {
+        errorCode = IoErr();
+        FPrintf(MessageOutput(), "Open: Could not open list file: %s\n", listName);
+        PrintError(errorCode ? errorCode : ERROR_OBJECT_NOT_FOUND);
+        return RETURN_FAIL;
+    }
+    
+    for (;;) {
+        LONG lineLen;
+        
+        SetIoErr(0);
+        if (FGets(listFile, line, sizeof(line)) == NULL) {
+            break;
+        }
+        lineLen = strlen(line);
+        
+        if (CheckAbort()) {
+            result = RETURN_FAIL;
+            break;
+        }
+        
+        /* A line that filled the buffer without a newline is too long - skip it */
+        if (lineLen == (LONG)sizeof(line) - 1 && line[lineLen - 1] != '\n') {
+            LONG c;
+            
+            PrintError(ERROR_LINE_TOO_LONG);
+            do {
+                c = FGetC(listFile);
+            } while (c != -1 && c != '\n');
+            result = RETURN_FAIL;
+            continue;
+        }
+        
+        /* Strip the line terminator */
+        while (lineLen > 0 && (line[lineLen - 1] == '\n' || line[lineLen - 1] == '\r')) {
+            line[--lineLen] = '\0';
+        }
+        
+        /* Skip empty lines */
+        if (lineLen == 0) {
+            continue;
+        }
+        
+        if (countOut) {
+            (*countOut)++;
+        }
+        
+        if (OpenArgument(line, forceTool, forceBrowse, forceEdit, forceInfo, forcePrint, forceMail, showAll, recurseAll) != RETURN_OK) {
+            result = RETURN_FAIL;
+        }
+    }
+    
+    /* FGets() returns NULL on error as well as at end of file */
+    errorCode = IoErr();
+    if (errorCode != 0 && !g_aborted) {
+        PrintError(errorCode);
+        result = RETURN_FAIL;
+    }
+    
+    if (!fromStdin) {
+        Close(listFile);
+    }
+    
+    return result;
+}
+
+/* Open an item, or with ALL every file in the drawer tree below it */
+LONG OpenTree(STRPTR fileName, STRPTR forceTool, BOOL forceBrowse, BOOL forceEdit, BOOL forceInfo, BOOL forcePrint, BOOL forceMail, BOOL showAll)
+{
+    BPTR dirLock = NULL;
+    LONG result = RETURN_FAIL;
+    LONG errorCode = 0;
+    
+    if (!fileName) {
+        return RETURN_FAIL;
+    }
+    
+    /* BATCH: fail straight away if the volume is not there */
+    if (g_batchMode && !IsVolumeAvailable(fileName, TRUE)) {
+        return RETURN_FAIL;
+    }
+    
+    StatCount(COUNT_LOCK);
+    dirLock = Lock(fileName, ACCESS_READ);
+    if (!dirLock) {
+        errorCode = IoErr();
+        PrintError(errorCode ? errorCode : ERROR_OBJECT_NOT_FOUND);
+        return RETURN_FAIL;
+    }
+    
+    if (!ExamineItem(dirLock)) {
+        errorCode = IoErr();
+        PrintError(errorCode ? errorCode : ERROR_OBJECT_NOT_FOUND);
+        UnLock(dirLock);
+        ClearItemInfo();
+        return RETURN_FAIL;
+    }
+    
+    if (g_item.dirEntryType == ST_USERDIR || g_item.dirEntryType == ST_ROOT) {
+        /* It's a drawer - stream its contents instead of opening it */
+        ClearItemInfo();
+        result = WalkDrawer(dirLock, forceTool, forceBrowse, forceEdit, forceInfo, forcePrint, forceMail, showAll);
+        UnLock(dirLock);
+    } else {
+        /* Plain file - OpenItem reuses the information we just examined */
+        UnLock(dirLock);
+        result = OpenItem(fileName, forceTool, forceBrowse, forceEdit, forceInfo, forcePrint, forceMail, showAll);
+    }
+    
+    return result;
+}
+
+/* Walk a drawer tree with ExAll() and open every file in it */
+/* Each level owns one fixed-size ExAll() buffer, so memory use depends only */
+/* on the nesting depth, never on the number of entries in the tree; the */
+/* levels are kept in one heap array, so the depth costs no stack either */
+LONG WalkDrawer(BPTR dirLock, STRPTR forceTool, BOOL forceBrowse, BOOL forceEdit, BOOL forceInfo, BOOL forcePrint, BOOL forceMail, BOOL showAll)
+{
+    struct WalkLevel *levels = NULL;
+    struct WalkLevel *level;
+    struct ExAllData *ed;
+    BPTR oldDir;
+    LONG depth = 0;
+    LONG result = RETURN_OK;
+    LONG errorCode = 0;
+    
+    if (!dirLock) {
+        return RETURN_FAIL;
+    }
+    
+    levels = (struct WalkLevel *)AllocVec(MAX_WALK_DEPTH * sizeof(struct WalkLevel), MEMF_CLEAR);
+    if (!levels || !StartWalkLevel(&levels[0], dirLock)) {
+        PrintError(ERROR_NO_FREE_STORE);
+        if (levels) {
+            FreeVec(levels);
+        }
+        return RETURN_FAIL;
+    }
+    
+    while (depth >= 0) {
+        level = &levels[depth];
+        
+        /* Drawer done, or a Ctrl-C seen - back to its parent */
+        if (g_aborted || (level->next == NULL && !level->more)) {
+            EndWalkLevel(level, (BOOL)(depth > 0));
+            depth--;
+            continue;
+        }
+        
+        /* Buffer used up - ask for the next batch */
+        if (level->next == NULL) {
+            level->more = ExAll(level->lock, level->buffer, EXALL_BUFFER_SIZE, ED_DATE, level->eac);
+            if (!level->more) {
+                errorCode = IoErr();
+                if (errorCode != ERROR_NO_MORE_ENTRIES) {
+                    PrintError(errorCode);
+                    result = RETURN_FAIL;
+                }
+            }
+            level->next = (level->eac->eac_Entries != 0) ? level->buffer : NULL;
+            continue;
+        }
+        
+        ed = level->next;
+        level->next = ed->ed_Next;
+        
+        if (CheckAbort()) {
+            result = RETURN_FAIL;
+            continue;
+        }
+        
+        if (ed->ed_Type == ST_USERDIR) {
+            /* Descend into sub-drawers (links are not followed) */
+            BPTR subLock = NULL;
+            
+            if (depth + 1 >= MAX_WALK_DEPTH) {
+                FPrintf(MessageOutput(), "Open: Drawers nested too deeply, not descending further\n");
+                result = RETURN_FAIL;
+                continue;
+            }
+            
+            oldDir = CurrentDir(level->lock);
+            StatCount(COUNT_LOCK);
+            subLock = Lock(ed->ed_Name, ACCESS_READ);
+            CurrentDir(oldDir);
+            
+            if (!subLock) {
+                PrintError(IoErr());
+                result = RETURN_FAIL;
+            } else if (!StartWalkLevel(&levels[depth + 1], subLock)) {
+                UnLock(subLock);
+                PrintError(ERROR_NO_FREE_STORE);
+                result = RETURN_FAIL;
+            } else {
+                depth++;
+            }
+        } else if (ed->ed_Type < 0 && !IsInfoFile(ed->ed_Name)) {
+            struct ExAllData *next;
+            LONG ahead = 0;
+            
+            /* Read the next few headers in the background, up to the next sub-drawer */
+            for (next = ed->ed_Next; next != NULL && ahead < READAHEAD_DEPTH; next = next->ed_Next) {
+                if (next->ed_Type == ST_USERDIR) {
+                    break;
+                }
+                if (next->ed_Type < 0 && !IsInfoFile(next->ed_Name)) {
+                    ReadAhead(level->lock, next->ed_Name);
+                    ahead++;
+                }
+            }
+            
+            /* Plain file - classify it from what ExAll() already told us */
+            g_item.fibValid = TRUE;
+            g_item.dirEntryType = ed->ed_Type;
+            g_item.size = ed->ed_Size;
+            g_item.protection = ed->ed_Prot;
+            g_item.date.ds_Days = (LONG)ed->ed_Days;
+            g_item.date.ds_Minute = (LONG)ed->ed_Mins;
+            g_item.date.ds_Tick = (LONG)ed->ed_Ticks;
+            
+            oldDir = CurrentDir(level->lock);
+            if (OpenItem(ed->ed_Name, forceTool, forceBrowse, forceEdit, forceInfo, forcePrint, forceMail, showAll) != RETURN_OK) {
+                result = RETURN_FAIL;
+            }
+            CurrentDir(oldDir);
+        }
+    }
+    
+    FreeVec(levels);
+    
+    return result;
+}
+
+/* Get a level of the ALL walk ready to ExAll() a drawer */
+BOOL StartWalkLevel(struct WalkLevel *level, BPTR lock)
+{
+    level->buffer = (struct ExAllData *)AllocVec(EXALL_BUFFER_SIZE, MEMF_ANY);
+    level->eac = (struct ExAllControl *)AllocDosObject(DOS_EXALLCONTROL, NULL);
+    if (!level->buffer || !level->eac) {
+        if (level->eac) {
+            FreeDosObject(DOS_EXALLCONTROL, level->eac);
+            level->eac = NULL;
+        }
+        if (level->buffer) {
+            FreeVec(level->buffer);
+            level->buffer = NULL;
+        }
+        return FALSE;
+    }
+    
+    level->eac->eac_LastKey = 0;
+    level->lock = lock;
+    level->next = NULL;
+    level->more = TRUE;
+    
+    return TRUE;
+}
+
+/* Done with a level - unlock says whether its lock is the walk's own */
+VOID EndWalkLevel(struct WalkLevel *level, BOOL unlock)
+{
+    /* Tell the filesystem we are done if we stopped early */
+    if (level->more) {
+        ExAllEnd(level->lock, level->buffer, EXALL_BUFFER_SIZE, ED_DATE, level->eac);
+    }
+    
+    FreeDosObject(DOS_EXALLCONTROL, level->eac);
+    FreeVec(level->buffer);
+    level->eac = NULL;
+    level->buffer = NULL;
+    
+    if (unlock) {
+        UnLock(level->lock);
+    }
+    level->lock = NULL;
+}
+
+/* The shell's error stream, or Output() where there is none */
+BPTR ErrorOutput(VOID)
+{
+    struct Process *process = (struct Process *)FindTask(NULL);
+    
+    return process->pr_CES ? process->pr_CES : Output();
+}
+
+/* Where Open's messages go - the error stream with RESOLVE, whose output */
+/* is kept to the records for scripts */
+BPTR MessageOutput(VOID)
+{
+    return g_resolveOnly ? ErrorOutput() : Output();
+}
+
+/* PrintFault() to MessageOutput() */
+VOID PrintError(LONG errorCode)
+{
+    UBYTE text[128];
+    
+    Fault(errorCode, (STRPTR)"Open", text, sizeof(text));
+    FPrintf(MessageOutput(), "%s\n", text);
+}
+
+/* Check for Ctrl-C - SCOPTIONS builds with NOCHECKABORT, so we poll ourselves */
+/* Once a break has been seen it stays set for the rest of the run */
+BOOL CheckAbort(VOID)
+{
+    if (g_aborted) {
+        return TRUE;
+    }
+    
+    if (SetSignal(0L, SIGBREAKF_CTRL_C) & SIGBREAKF_CTRL_C) {
+        PrintError(ERROR_BREAK);
+        g_aborted = TRUE;
+        return TRUE;
+    }
+    
+    return FALSE;
+}
+
+/* Examine an item once and remember the result for the other helpers */
+BOOL ExamineItem(BPTR fileLock)
+{
+    struct FileInfoBlock *fib = NULL;
+    BOOL result = FALSE;
+    
+    if (g_item.fibValid) {
+        return TRUE;
+    }
+    
+    if (!fileLock) {
+        return FALSE;
+    }
+    
+    fib = (struct FileInfoBlock *)AllocDosObject(DOS_FIB, NULL);
+    if (!fib) {
+        return FALSE;
+    }
+    
+    StatBegin(STAT_LOCK);
+    StatCount(COUNT_EXAMINE);
+    if (Examine(fileLock, fib)) {
+        g_item.fibValid = TRUE;
+        g_item.dirEntryType = fib->fib_DirEntryType;
+        g_item.size = (ULONG)fib->fib_Size;
+        g_item.protection = (ULONG)fib->fib_Protection;
+        g_item.date = fib->fib_Date;
+        result = TRUE;
+    }
+    StatEnd(STAT_LOCK);
+    
+    FreeDosObject(DOS_FIB, fib);
+    
+    return result;
+}
+
+/* Forget what is known about the current item */
+VOID ClearItemInfo(VOID)
+{
+    g_item.fibValid = FALSE;
+    g_item.dirEntryType = 0;
+    g_item.size = 0;
+    g_item.protection = 0;
+    g_item.handler = NULL;
+    g_item.tier = TIER_FULL;
+    g_item.groupValid = FALSE;
+    g_item.groupID = 0;
+    g_item.headerValid = FALSE;
+    g_item.headerLen = 0;
+    
+    /* A header read ahead for the item is no use to the next one */
+    DropReadAhead();
+}
+
+/* Read the default identification deadline from $Open/Deadline */
+LONG GetDeadlineFromEnv(VOID)
+{
+    UBYTE varBuffer[16];
+    LONG deadline = 0;
+    
+    if (GetVar((STRPTR)"Open/Deadline", varBuffer, sizeof(varBuffer), 0) > 0) {
+        if (StrToLong(varBuffer, &deadline) < 0 || deadline < 0) {
+            deadline = 0;
+        }
+    }
+    
+    return deadline;
+}
+
+/* Milliseconds elapsed since a DateStamp (50Hz tick resolution) */
+LONG ElapsedMillis(struct DateStamp *since)
+{
+    struct DateStamp now;
+    LONG ticks;
+    
+    DateStamp(&now);
+    
+    ticks = (now.ds_Days - since->ds_Days) * (24L * 60L * TICKS_PER_SECOND * 60L)
+          + (now.ds_Minute - since->ds_Minute) * (60L * TICKS_PER_SECOND)
+          + (now.ds_Tick - since->ds_Tick);
+    
+    return ticks * (1000L / TICKS_PER_SECOND);
+}
+
+/* Decide whether another full identification stage may run */
+BOOL IdentifyAllowed(VOID)
+{
+    return IdentifyTierAllowed(TIER_FULL);
+}
+
+/* Decide whether the file header may still be read */
+BOOL HeaderAllowed(VOID)
+{
+    return IdentifyTierAllowed(TIER_HEADER);
+}
+
+/* Decide whether identification work of the given tier may run */
+/* Returns FALSE after Ctrl-C, when the volume policy (or FAST) limits */
+/* identification to a cheaper tier, or once the current item has used up */
+/* its deadline - the item then drops to the name-only FAST tier */
+BOOL IdentifyTierAllowed(UWORD tier)
+{
+    struct VolumeState *state = NULL;
+    
+    if (CheckAbort()) {
+        return FALSE;
+    }
+    
+    if (g_item.tier > tier) {
+        return FALSE;
+    }
+    
+    if (g_deadlineMillis > 0 && ElapsedMillis(&g_item.started) > g_deadlineMillis) {
+        FPrintf(MessageOutput(), "Open: Volume is responding slowly, identifying files by name only\n");
+        state = GetVolumeState(g_item.handler);
+        if (state) {
+            state->slow = TRUE;
+        }
+        g_item.tier = TIER_FAST;
+        return FALSE;
+    }
+    
+    return TRUE;
+}
+
+/* Find (or add) the state kept for a volume, keyed by its handler port */
+struct VolumeState *GetVolumeState(struct MsgPort *handler)
+{
+    struct VolumeState *state = NULL;
+    LONG i;
+    
+    if (!handler) {
+        return NULL;
+    }
+    
+    for (i = 0; i < g_volumeCount; i++) {
+        if (g_volumes[i].handler == handler) {
+            return &g_volumes[i];
+        }
+    }
+    
+    /* Table full - recycle the last slot, its tier is simply resolved again */
+    if (g_volumeCount < MAX_VOLUMES) {
+        state = &g_volumes[g_volumeCount++];
+    } else {
+        state = &g_volumes[MAX_VOLUMES - 1];
+    }
+    
+    state->handler = handler;
+    state->slow = FALSE;
+    state->tier = ResolveVolumeTier(handler);
+    
+    return state;
+}
+
+/* Pick the identification tier for the item's volume */
+UWORD GetItemTier(struct MsgPort *handler)
+{
+    struct VolumeState *state = NULL;
+    
+    if (g_forceFast) {
+        return TIER_FAST;
+    }
+    
+    state = GetVolumeState(handler);
+    if (!state) {
+        return TIER_FULL;
+    }
+    
+    return state->slow ? (UWORD)TIER_FAST : state->tier;
+}
+
+/* Look up the policy for a volume by any device or volume name it has */
+/* Only the in-memory DOS list is searched - no packets are sent */
+UWORD ResolveVolumeTier(struct MsgPort *handler)
+{
+    struct DosList *dl = NULL;
+    UWORD tier = TIER_FULL;
+    BOOL found = FALSE;
+    LONG i;
+    
+    if (!handler || g_policyCount == 0) {
+        return TIER_FULL;
+    }
+    
+    dl = LockDosList(LDF_DEVICES | LDF_VOLUMES | LDF_READ);
+    while (!found && (dl = NextDosEntry(dl, LDF_DEVICES | LDF_VOLUMES)) != NULL) {
+        if (dl->dol_Task == handler) {
+            UBYTE *bname = (UBYTE *)BADDR(dl->dol_Name);
+            LONG nameLen = bname ? bname[0] : 0;
+            
+            for (i = 0; i < g_policyCount; i++) {
+                if ((LONG)strlen(g_policies[i].name) == nameLen &&
+                    Strnicmp(g_policies[i].name, bname + 1, nameLen) == 0) {
+                    tier = g_policies[i].tier;
+                    found = TRUE;
+                    break;
+                }
+            }
+        }
+    }
+    UnLockDosList(LDF_DEVICES | LDF_VOLUMES | LDF_READ);
+    
+    return tier;
+}
+
+/* Read the per-volume identification policy from ENV:Open/Volumes */
+/* Each line holds a device or volume name and a tier, e.g. "CD0: FAST" */
+VOID LoadVolumePolicies(VOID)
+{
+    BPTR policyFile = NULL;
+    UBYTE line[128];
+    
+    g_policyCount = 0;
+    
+    policyFile = Open((STRPTR)"ENV:Open/Volumes", MODE_OLDFILE);
+    if (!policyFile) {
+        return;
+    }
+    
+    while (g_policyCount < MAX_VOLUME_POLICIES && FGets(policyFile, line, sizeof(line)) != NULL) {
+        STRPTR name = line;
+        STRPTR tierName = NULL;
+        STRPTR p = NULL;
+        LONG nameLen = 0;
+        LONG tier = -1;
+        
+        /* Skip leading blanks, empty lines and ; comments */
+        while (*name == ' ' || *name == '\t') {
+            name++;
+        }
+        if (*name == '\0' || *name == '\n' || *name == ';') {
+            continue;
+        }
+        
+        /* Split off the name */
+        for (p = name; *p && *p != ' ' && *p != '\t' && *p != '\n'; p++) {
+        }
+        if (*p == '\0' || *p == '\n') {
+            continue;
+        }
+        *p++ = '\0';
+        
+        /* Find the tier */
+        while (*p == ' ' || *p == '\t') {
+            p++;
+        }
+        tierName = p;
+        while (*p && *p != ' ' && *p != '\t' && *p != '\n') {
+            p++;
+        }
+        *p = '\0';
+        
+        if (Stricmp(tierName, "FULL") == 0) {
+            tier = TIER_FULL;
+        } else if (Stricmp(tierName, "HEADER") == 0) {
+            tier = TIER_HEADER;
+        } else if (Stricmp(tierName, "FAST") == 0) {
+            tier = TIER_FAST;
+        }
+        
+        if (tier < 0) {
+            FPrintf(MessageOutput(), "Open: Unknown identification tier in ENV:Open/Volumes: %s\n", tierName);
+            continue;
+        }
+        
+        /* Names are matched without the trailing colon */
+        nameLen = strlen(name);
+        if (nameLen > 0 && name[nameLen - 1] == ':') {
+            name[--nameLen] = '\0';
+        }
+        if (nameLen == 0) {
+            continue;
+        }
+        
+        Strncpy(g_policies[g_policyCount].name, name, sizeof(g_policies[g_policyCount].name));
+        g_policies[g_policyCount].tier = (UWORD)tier;
+        g_policyCount++;
+    }
+    
+    Close(policyFile);
+}
+
+/* Load and compile ENV:Open/Rules */
+/* Each line is "<pattern> <verb> <tool>", where verb is BROWSE (or VIEW), */
+/* EDIT, INFO, PRINT, MAIL or * for any verb, e.g. "#?.txt EDIT C:Ed" */
+VOID LoadRules(VOID)
+{
+    BPTR rulesFile = NULL;
+    UBYTE line[512];
+    LONG order = 0;
+    
+    rulesFile = Open((STRPTR)"ENV:Open/Rules", MODE_OLDFILE);
+    if (!rulesFile) {
+        return;
+    }
+    
+    while (FGets(rulesFile, line, sizeof(line)) != NULL) {
+        STRPTR pattern = line;
+        STRPTR verbName = NULL;
+        STRPTR tool = NULL;
+        STRPTR p = NULL;
+        LONG verb = -1;
+        LONG len;
+        
+        /* Skip leading blanks, empty lines and ; comments */
+        while (*pattern == ' ' || *pattern == '\t') {
+            pattern++;
+        }
+        if (*pattern == '\0' || *pattern == '\n' || *pattern == ';') {
+            continue;
+        }
+        
+        /* Pattern */
+        for (p = pattern; *p && *p != ' ' && *p != '\t' && *p != '\n'; p++) {
+        }
+        if (*p == '\0' || *p == '\n') {
+            continue;
+        }
+        *p++ = '\0';
+        
+        /* Verb */
+        while (*p == ' ' || *p == '\t') {
+            p++;
+        }
+        verbName = p;
+        while (*p && *p != ' ' && *p != '\t' && *p != '\n') {
+            p++;
+        }
+        if (*p == '\0' || *p == '\n') {
+            continue;
+        }
+        *p++ = '\0';
+        
+        /* Tool is the rest of the line */
+        while (*p == ' ' || *p == '\t') {
+            p++;
+        }
+        tool = p;
+        len = strlen(tool);
+        while (len > 0 && (tool[len - 1] == '\n' || tool[len - 1] == ' ' || tool[len - 1] == '\t')) {
+            tool[--len] = '\0';
+        }
+        if (len == 0) {
+            continue;
+        }
+        
+        if (Stricmp(verbName, "BROWSE") == 0 || Stricmp(verbName, "VIEW") == 0) {
+            verb = TW_BROWSE;
+        } else if (Stricmp(verbName, "EDIT") == 0) {
+            verb = TW_EDIT;
+        } else if (Stricmp(verbName, "INFO") == 0) {
+            verb = TW_INFO;
+        } else if (Stricmp(verbName, "PRINT") == 0) {
+            verb = TW_PRINT;
+        } else if (Stricmp(verbName, "MAIL") == 0) {
+            verb = TW_MAIL;
+        } else if (strcmp(verbName, "*") == 0 || Stricmp(verbName, "ANY") == 0) {
+            verb = 0;
+        }
+        
+        if (verb < 0) {
+            FPrintf(MessageOutput(), "Open: Unknown verb in ENV:Open/Rules: %s\n", verbName);
+            continue;
+        }
+        
+        AddRule(pattern, (UWORD)verb, tool, order++);
+    }
+    
+    Close(rulesFile);
+}
+
+/* Compile one rule into the suffix hash or the pattern list */
+VOID AddRule(STRPTR pattern, UWORD verb, STRPTR tool, LONG order)
+{
+    struct Rule *rule = NULL;
+    STRPTR suffix = NULL;
+    STRPTR p = NULL;
+    LONG patternLen = strlen(pattern);
+    LONG toolLen = strlen(tool);
+    LONG tokenLen = 0;
+    LONG parsed = 0;
+    ULONG hash;
+    
+    /* "#?.suffix" with nothing else special is a plain suffix rule; names */
+    /* are looked up by their last suffix, so "#?.tar.gz" is a pattern */
+    if (patternLen > 3 && strncmp(pattern, "#?.", 3) == 0) {
+        suffix = pattern + 2;
+        for (p = suffix + 1; *p; p++) {
+            if (strchr("#?*()|[]~%'.", *p) != NULL) {
+                suffix = NULL;
+                break;
+            }
+        }
+    }
+    
+    if (suffix) {
+        /* Rule, suffix and tool in one allocation */
+        rule = (struct Rule *)AllocVec(sizeof(struct Rule) + strlen(suffix) + 1 + toolLen + 1, MEMF_CLEAR);
+        if (!rule) {
+            return;
+        }
+        rule->suffix = (STRPTR)(rule + 1);
+        strcpy(rule->suffix, suffix);
+        rule->tool = rule->suffix + strlen(suffix) + 1;
+    } else {
+        /* Rule, pattern tokens and tool in one allocation */
+        tokenLen = patternLen * 2 + 2;
+        rule = (struct Rule *)AllocVec(sizeof(struct Rule) + tokenLen + toolLen + 1, MEMF_CLEAR);
+        if (!rule) {
+            return;
+        }
+        rule->pattern = (STRPTR)(rule + 1);
+        parsed = ParsePatternNoCase(pattern, rule->pattern, tokenLen);
+        if (parsed < 0) {
+            FPrintf(MessageOutput(), "Open: Bad pattern in ENV:Open/Rules: %s\n", pattern);
+            FreeVec(rule);
+            return;
+        }
+        if (parsed == 0) {
+            /* No wildcards - keep the plain name for a simple comparison */
+            strcpy(rule->pattern, pattern);
+        }
+        rule->isWild = (BOOL)(parsed == 1);
+        rule->tool = rule->pattern + tokenLen;
+    }
+    
+    strcpy(rule->tool, tool);
+    rule->order = order;
+    rule->verb = verb;
+    g_ruleCount++;
+    
+    if (rule->suffix) {
+        /* Append to the hash chain so earlier rules stay first */
+        struct Rule **link;
+        
+        hash = HashSuffix(rule->suffix);
+        for (link = &g_ruleHash[hash]; *link != NULL; link = &(*link)->next) {
+        }
+        *link = rule;
+    } else {
+        if (g_rulePatternsTail) {
+            g_rulePatternsTail->next = rule;
+        } else {
+            g_rulePatterns = rule;
+        }
+        g_rulePatternsTail = rule;
+    }
+}
+
+/* Free all compiled rules */
+VOID FreeRules(VOID)
+{
+    struct Rule *rule = NULL;
+    struct Rule *next = NULL;
+    LONG i;
+    
+    for (i = 0; i < RULE_HASH_SIZE; i++) {
+        for (rule = g_ruleHash[i]; rule != NULL; rule = next) {
+            next = rule->next;
+            FreeVec(rule);
+        }
+        g_ruleHash[i] = NULL;
+    }
+    
+    for (rule = g_rulePatterns; rule != NULL; rule = next) {
+        next = rule->next;
+        FreeVec(rule);
+    }
+    g_rulePatterns = NULL;
+    g_rulePatternsTail = NULL;
+    g_ruleCount = 0;
+}
+
+/* Case-insensitive hash of a suffix */
+ULONG HashSuffix(STRPTR suffix)
+{
+    ULONG hash = 0;
+    
+    while (*suffix) {
+        hash = hash * 31 + ToLower(*suffix);
+        suffix++;
+    }
+    
+    return hash % RULE_HASH_SIZE;
+}
+
+/* Find the tool the rules give for a file name and verb */
+/* Returns a pointer into the rule (do not free), or NULL if no rule matches */
+STRPTR FindRuleTool(STRPTR fileName, UWORD preferredTool)
+{
+    struct Rule *rule = NULL;
+    struct Rule *best = NULL;
+    STRPTR filePart = NULL;
+    STRPTR ext = NULL;
+    
+    if (!fileName || g_ruleCount == 0) {
+        return NULL;
+    }
+    
+    filePart = FilePart(fileName);
+    if (!filePart || !*filePart) {
+        return NULL;
+    }
+    
+    /* Suffix rules - one hash lookup */
+    ext = strrchr(filePart, '.');
+    if (ext) {
+        for (rule = g_ruleHash[HashSuffix(ext)]; rule != NULL; rule = rule->next) {
+            if ((rule->verb == 0 || rule->verb == preferredTool) && Stricmp(rule->suffix, ext) == 0) {
+                best = rule;
+                break;
+            }
+        }
+    }
+    
+    /* Pattern rules - only those earlier in the file than the suffix match */
+    for (rule = g_rulePatterns; rule != NULL; rule = rule->next) {
+        if (best && rule->order > best->order) {
+            break;
+        }
+        if (rule->verb != 0 && rule->verb != preferredTool) {
+            continue;
+        }
+        if (rule->isWild ? MatchPatternNoCase(rule->pattern, filePart) : (Stricmp(rule->pattern, filePart) == 0)) {
+            best = rule;
+            break;
+        }
+    }
+    
+    return best ? best->tool : NULL;
+}
+
+/* Map the verb switches to a datatypes tool type */
+UWORD GetPreferredTool(BOOL forceBrowse, BOOL forceEdit, BOOL forceInfo, BOOL forcePrint, BOOL forceMail)
+{
+    if (forceEdit && !forceBrowse) {
+        return TW_EDIT;
+    } else if (forceInfo && !forceBrowse) {
+        return TW_INFO;
+    } else if (forcePrint && !forceBrowse) {
+        return TW_PRINT;
+    } else if (forceMail && !forceBrowse) {
+        return TW_MAIL;
+    }
+    
+    return TW_BROWSE;
+}
+
+/* Load size routes from ENV:Open/LargeFiles */
+/* Each line is "<group or type> <size> <tool>", the size in bytes with an */
+/* optional K or M suffix, e.g. "picture 4M SYS:Utilities/BigPic" */
+VOID LoadSizeRoutes(VOID)
+{
+    BPTR routeFile = NULL;
+    UBYTE line[512];
+    
+    routeFile = Open((STRPTR)"ENV:Open/LargeFiles", MODE_OLDFILE);
+    if (!routeFile) {
+        return;
+    }
+    
+    while (g_sizeRouteCount < MAX_SIZE_ROUTES && FGets(routeFile, line, sizeof(line)) != NULL) {
+        struct SizeRoute *route = &g_sizeRoutes[g_sizeRouteCount];
+        STRPTR name = line;
+        STRPTR sizeText = NULL;
+        STRPTR tool = NULL;
+        STRPTR p = NULL;
+        LONG number = 0;
+        LONG used;
+        LONG len;
+        LONG i;
+        
+        /* Skip leading blanks, empty lines and ; comments */
+        while (*name == ' ' || *name == '\t') {
+            name++;
+        }
+        if (*name == '\0' || *name == '\n' || *name == ';') {
+            continue;
+        }
+        
+        /* Group or type name */
+        for (p = name; *p && *p != ' ' && *p != '\t' && *p != '\n'; p++) {
+        }
+        if (*p == '\0' || *p == '\n') {
+            continue;
+        }
+        *p++ = '\0';
+        
+        /* Size limit */
+        while (*p == ' ' || *p == '\t') {
+            p++;
+        }
+        sizeText = p;
+        used = StrToLong(sizeText, &number);
+        if (used <= 0 || number <= 0) {
+            FPrintf(MessageOutput(), "Open: Bad size in ENV:Open/LargeFiles: %s\n", name);
+            continue;
+        }
+        p = sizeText + used;
+        if (*p == 'K' || *p == 'k') {
+            number *= 1024;
+            p++;
+        } else if (*p == 'M' || *p == 'm') {
+            number *= 1024 * 1024;
+            p++;
+        }
+        
+        /* Tool is the rest of the line */
+        while (*p == ' ' || *p == '\t') {
+            p++;
+        }
+        tool = p;
+        len = strlen(tool);
+        while (len > 0 && (tool[len - 1] == '\n' || tool[len - 1] == ' ' || tool[len - 1] == '\t')) {
+            tool[--len] = '\0';
+        }
+        if (len == 0) {
+            continue;
+        }
+        
+        Strncpy(route->name, name, sizeof(route->name));
+        Strncpy(route->tool, tool, sizeof(route->tool));
+        route->limit = (ULONG)number;
+        route->groupID = 0;
+        for (i = 0; groupNames[i].name != NULL; i++) {
+            if (Stricmp(name, (STRPTR)groupNames[i].name) == 0) {
+                route->groupID = groupNames[i].groupID;
+                g_sizeRouteGroups = TRUE;
+                break;
+            }
+        }
+        
+        if (g_sizeRouteCount == 0 || route->limit < g_sizeRouteMin) {
+            g_sizeRouteMin = route->limit;
+        }
+        g_sizeRouteCount++;
+    }
+    
+    Close(routeFile);
+}
+
+/* Find the size route for the current item */
+/* Returns a pointer into the route table (do not free), or NULL */
+STRPTR GetLargeFileTool(STRPTR fileName, BPTR fileLock, STRPTR typeIdentifier)
+{
+    ULONG groupID = 0;
+    BOOL groupKnown = FALSE;
+    STRPTR tool = NULL;
+    LONG i;
+    
+    /* The size comes from the FIB we already have - no I/O for small files */
+    if (g_sizeRouteCount == 0 || !g_item.fibValid || g_item.size < g_sizeRouteMin) {
+        return NULL;
+    }
+    
+    for (i = 0; i < g_sizeRouteCount && !tool; i++) {
+        struct SizeRoute *route = &g_sizeRoutes[i];
+        
+        if (g_item.size < route->limit) {
+            continue;
+        }
+        
+        if (route->groupID == 0) {
+            if (typeIdentifier && Stricmp(route->name, typeIdentifier) == 0) {
+                tool = route->tool;
+            }
+            continue;
+        }
+        
+        /* Look the group up once, and only where datatypes may be asked */
+        if (!groupKnown) {
+            groupKnown = TRUE;
+            if (g_sizeRouteGroups && (g_item.groupValid || IdentifyAllowed())) {
+                groupID = GetItemGroup(fileName, fileLock);
+            }
+        }
+        
+        if (groupID != 0 && route->groupID == groupID) {
+            tool = route->tool;
+        }
+    }
+    
+    return tool;
+}
+
+/* Load the stage statistics, ENV: first and then ENVARC: */
+/* Each line is "<suffix> <DefIcons wins> <datatypes wins> <icon wins>" */
+VOID LoadStageStats(VOID)
+{
+    BPTR statsFile = NULL;
+    UBYTE line[128];
+    
+    g_stageStatsLoaded = TRUE;
+    
+    statsFile = Open((STRPTR)"ENV:Open/Stages", MODE_OLDFILE);
+    if (!statsFile) {
+        statsFile = Open((STRPTR)"ENVARC:Open/Stages", MODE_OLDFILE);
+    }
+    if (!statsFile) {
+        return;
+    }
+    
+    while (g_stageStatCount < MAX_STAGE_STATS && FGets(statsFile, line, sizeof(line)) != NULL) {
+        struct StageStat *stat = &g_stageStats[g_stageStatCount];
+        STRPTR p = line;
+        LONG number;
+        LONG used;
+        LONG i;
+        
+        /* "# <n>" counts the changes not yet copied to ENVARC: */
+        if (*p == '#') {
+            if (StrToLong(p + 1, &number) > 0 && number >= 0) {
+                g_stageChanges = number;
+            }
+            continue;
+        }
+        if (*p != '.') {
+            continue;
+        }
+        for (i = 0; *p && *p != ' ' && *p != '\n' && i < sizeof(stat->suffix) - 1; i++) {
+            stat->suffix[i] = *p++;
+        }
+        stat->suffix[i] = '\0';
+        if (*p != ' ') {
+            continue;
+        }
+        
+        for (i = 0; i < STAGE_COUNT; i++) {
+            used = StrToLong(p, &number);
+            if (used <= 0 || number < 0) {
+                break;
+            }
+            stat->wins[i] = (ULONG)number;
+            p += used;
+        }
+        if (i == STAGE_COUNT) {
+            g_stageStatCount++;
+        }
+    }
+    
+    Close(statsFile);
+}
+
+/* Create one of Open's own files in ENV:Open or ENVARC:Open */
+/* The drawer is made the first time, as nothing else creates it */
+BPTR OpenNewEnvFile(STRPTR fileName)
+{
+    UBYTE drawer[32];
+    BPTR file = NULL;
+    BPTR drawerLock = NULL;
+    LONG drawerLen;
+    
+    file = Open(fileName, MODE_NEWFILE);
+    if (file || (IoErr() != ERROR_OBJECT_NOT_FOUND && IoErr() != ERROR_DIR_NOT_FOUND)) {
+        return file;
+    }
+    
+    drawerLen = FilePart(fileName) - fileName;
+    if (drawerLen < 2 || drawerLen > (LONG)sizeof(drawer) || fileName[drawerLen - 1] != '/') {
+        return NULL;
+    }
+    Strncpy(drawer, fileName, drawerLen);
+    
+    drawerLock = CreateDir(drawer);
+    if (!drawerLock) {
+        return NULL;
+    }
+    UnLock(drawerLock);
+    
+    return Open(fileName, MODE_NEWFILE);
+}
+
+/* Save the stage statistics if this run changed them */
+VOID SaveStageStats(VOID)
+{
+    if (!g_stageStatsDirty) {
+        return;
+    }
+    
+    /* ENVARC: is written to disk, so only every few changes */
+    if (++g_stageChanges >= STAGE_ARCHIVE_EVERY) {
+        g_stageChanges = 0;
+        WriteStageStats((STRPTR)"ENVARC:Open/Stages");
+    }
+    WriteStageStats((STRPTR)"ENV:Open/Stages");
+    g_stageStatsDirty = FALSE;
+}
+
+/* Write the stage statistics to one file */
+BOOL WriteStageStats(STRPTR fileName)
+{
+    BPTR statsFile = NULL;
+    LONG i;
+    
+    statsFile = OpenNewEnvFile(fileName);
+    if (!statsFile) {
+        return FALSE;
+    }
+    
+    FPrintf(statsFile, "# %ld\n", g_stageChanges);
+    for (i = 0; i < g_stageStatCount; i++) {
+        struct StageStat *stat = &g_stageStats[i];
+        
+        FPrintf(statsFile, "%s %lu %lu %lu\n", stat->suffix,
+                stat->wins[STAGE_DEFICONS], stat->wins[STAGE_DATATYPES], stat->wins[STAGE_ICON]);
+    }
+    
+    Close(statsFile);
+    return TRUE;
+}
+
+/* Find the statistics for a file's suffix class */
+struct StageStat *FindStageStat(STRPTR fileName, BOOL create)
+{
+    UBYTE suffix[16];
+    STRPTR filePart = NULL;
+    STRPTR ext = NULL;
+    struct StageStat *stat = NULL;
+    LONG i;
+    
+    if (!g_stageStatsLoaded) {
+        LoadStageStats();
+    }
+    
+    filePart = FilePart(fileName);
+    if (!filePart) {
+        return NULL;
+    }
+    ext = strrchr(filePart, '.');
+    if (!ext || ext[1] == '\0' || strlen(ext) >= sizeof(suffix) || strchr(ext, ' ')) {
+        return NULL;
+    }
+    
+    for (i = 0; ext[i]; i++) {
+        suffix[i] = ToLower(ext[i]);
+    }
+    suffix[i] = '\0';
+    
+    for (i = 0; i < g_stageStatCount; i++) {
+        if (strcmp(g_stageStats[i].suffix, suffix) == 0) {
+            return &g_stageStats[i];
+        }
+    }
+    
+    if (!create || g_stageStatCount >= MAX_STAGE_STATS) {
+        return NULL;
+    }
+    
+    stat = &g_stageStats[g_stageStatCount++];
+    memset(stat, 0, sizeof(struct StageStat));
+    strcpy(stat->suffix, suffix);
+    
+    return stat;
+}
+
+/* Pick the stage to try first for a file */
+/* A later stage is only moved to the front once it has won repeatedly and */
+/* every stage normally tried before it has never won for this suffix. The */
+/* first file of a suffix in each run still goes through the usual order, */
+/* so a newly installed DefIcons type or datatype is noticed */
+UWORD GetFirstStage(STRPTR fileName)
+{
+    struct StageStat *stat = NULL;
+    
+    stat = FindStageStat(fileName, FALSE);
+    if (!stat || !stat->verified) {
+        return STAGE_DEFICONS;
+    }
+    
+    return GetLearnedStage(stat);
+}
+
+/* The stage a suffix's counts put first */
+UWORD GetLearnedStage(struct StageStat *stat)
+{
+    UWORD stage;
+    
+    for (stage = STAGE_DEFICONS; stage < STAGE_COUNT; stage++) {
+        if (stat->wins[stage] != 0) {
+            return stat->wins[stage] >= STAGE_PROMOTE_MIN ? stage : STAGE_DEFICONS;
+        }
+    }
+    
+    return STAGE_DEFICONS;
+}
+
+/* Count a win for the stage that produced the tool */
+/* Only wins that still count towards a promotion, or that change the */
+/* stage put first, are worth saving - the rest would rewrite the same order */
+VOID RecordStageWin(STRPTR fileName, UWORD stage)
+{
+    struct StageStat *stat = NULL;
+    UWORD learned;
+    LONG i;
+    
+    /* BENCH keeps the order it started with, so every run does the same work */
+    if (g_benchSamples) {
+        return;
+    }
+    
+    stat = FindStageStat(fileName, TRUE);
+    if (!stat || stage >= STAGE_COUNT) {
+        return;
+    }
+    
+    learned = GetLearnedStage(stat);
+    
+    /* Halve all counts now and then so the history can change its mind */
+    if (++stat->wins[stage] > STAGE_WINS_MAX) {
+        for (i = 0; i < STAGE_COUNT; i++) {
+            stat->wins[i] /= 2;
+        }
+    }
+    stat->verified = TRUE;
+    
+    if (stat->wins[stage] <= STAGE_PROMOTE_MIN || GetLearnedStage(stat) != learned) {
+        g_stageStatsDirty = TRUE;
+    }
+}
+
+/* Load the tool path cache from ENV:Open/ToolCache */
+/* Each line is "<tool>\t<path>\t<days> <minute> <tick>" */
+VOID LoadToolPaths(VOID)
+{
+    BPTR cacheFile = NULL;
+    UBYTE line[512];
+    
+    g_toolPathsLoaded = TRUE;
+    
+    cacheFile = Open((STRPTR)"ENV:Open/ToolCache", MODE_OLDFILE);
+    if (!cacheFile) {
+        return;
+    }
+    
+    while (g_toolPathCount < MAX_TOOL_PATHS && FGets(cacheFile, line, sizeof(line)) != NULL) {
+        struct ToolPath *entry = &g_toolPaths[g_toolPathCount];
+        STRPTR name = line;
+        STRPTR path = NULL;
+        STRPTR p = NULL;
+        LONG number[3];
+        LONG used;
+        LONG i;
+        
+        path = strchr(name, '\t');
+        if (!path) {
+            continue;
+        }
+        *path++ = '\0';
+        p = strchr(path, '\t');
+        if (!p) {
+            continue;
+        }
+        *p++ = '\0';
+        
+        for (i = 0; i < 3; i++) {
+            used = StrToLong(p, &number[i]);
+            if (used <= 0) {
+                break;
+            }
+            p += used;
+        }
+        if (i < 3 || strlen(name) >= sizeof(entry->name) || strlen(path) >= sizeof(entry->path)) {
+            continue;
+        }
+        
+        strcpy(entry->name, name);
+        strcpy(entry->path, path);
+        entry->date.ds_Days = number[0];
+        entry->date.ds_Minute = number[1];
+        entry->date.ds_Tick = number[2];
+        entry->checked = FALSE;
+        g_toolPathCount++;
+    }
+    
+    Close(cacheFile);
+}
+
+/* Load the list of tools Open has made resident */
+/* A budget that was lowered or unset removes what no longer fits */
+VOID LoadSegCache(VOID)
+{
+    UBYTE varBuffer[16];
+    LONG budget = 0;
+    
+    g_segCacheBudget = 0;
+    if (GetVar((STRPTR)"Open/SegCache", varBuffer, sizeof(varBuffer), 0) > 0) {
+        if (StrToLong(varBuffer, &budget) > 0 && budget > 0) {
+            /* Bytes must stay positive, -1 means not read yet */
+            if (budget > 0x7FFFFFFF / 1024) {
+                budget = 0x7FFFFFFF / 1024;
+            }
+            g_segCacheBudget = budget * 1024;
+        }
+    }
+    
+    g_segCacheCount = ReadSegCacheFile(g_segCache);
+    if (g_segCacheCount > 0) {
+        EvictSegCache(0);
+    }
+}
+
+/* Read ENV:Open/Residents into MAX_SEG_CACHE entries, returns how many */
+LONG ReadSegCacheFile(struct SegCacheEntry *entries)
+{
+    static UBYTE line[512];   /* Static - too much for the stack */
+    BPTR cacheFile = NULL;
+    LONG count = 0;
+    
+    cacheFile = Open((STRPTR)"ENV:Open/Residents", MODE_OLDFILE);
+    if (!cacheFile) {
+        return 0;
+    }
+    
+    while (count < MAX_SEG_CACHE && FGets(cacheFile, line, sizeof(line)) != NULL) {
+        struct SegCacheEntry *entry = &entries[count];
+        STRPTR name = line;
+        STRPTR path = NULL;
+        STRPTR p = NULL;
+        LONG number[7];
+        LONG used;
+        LONG i;
+        
+        path = strchr(name, '\t');
+        if (!path) {
+            continue;
+        }
+        *path++ = '\0';
+        p = strchr(path, '\t');
+        if (!p) {
+            continue;
+        }
+        *p++ = '\0';
+        
+        for (i = 0; i < 7; i++) {
+            used = StrToLong(p, &number[i]);
+            if (used <= 0) {
+                break;
+            }
+            p += used;
+        }
+        if (i < 7 || strlen(name) >= sizeof(entry->name) || strlen(path) >= sizeof(entry->path)) {
+            continue;
+        }
+        
+        strcpy(entry->name, name);
+        strcpy(entry->path, path);
+        entry->date.ds_Days = number[0];
+        entry->date.ds_Minute = number[1];
+        entry->date.ds_Tick = number[2];
+        entry->size = (ULONG)number[3];
+        entry->used.ds_Days = number[4];
+        entry->used.ds_Minute = number[5];
+        entry->used.ds_Tick = number[6];
+        count++;
+    }
+    
+    Close(cacheFile);
+    
+    return count;
+}
+
+/* Save the resident tool list if this run changed it */
+/* Another Open may have saved meanwhile, so the file is read again and */
+/* its entries whose residents still exist are kept - under a semaphore, */
+/* so no two Opens rewrite it at once */
+VOID SaveSegCache(VOID)
+{
+    struct SignalSemaphore *fileLock = NULL;
+    struct SegCacheEntry *saved = NULL;
+    BPTR cacheFile = NULL;
+    LONG savedCount = 0;
+    LONG i;
+    LONG j;
+    
+    if (!g_segCacheDirty) {
+        return;
+    }
+    g_segCacheDirty = FALSE;
+    
+    fileLock = GetSegCacheLock();
+    if (fileLock) {
+        ObtainSemaphore(fileLock);
+    }
+    
+    /* Without the memory for it, only this run's list is written */
+    saved = (struct SegCacheEntry *)AllocVec(MAX_SEG_CACHE * sizeof(struct SegCacheEntry), MEMF_ANY);
+    if (saved) {
+        savedCount = ReadSegCacheFile(saved);
+    }
+    
+    /* Entries whose resident has gone, here or in the file, are left out */
+    Forbid();
+    for (i = 0; i < g_segCacheCount; ) {
+        if (!FindSegment(g_segCache[i].name, NULL, FALSE)) {
+            g_segCache[i] = g_segCache[--g_segCacheCount];
+        } else {
+            i++;
+        }
+    }
+    for (j = 0; j < savedCount && g_segCacheCount < MAX_SEG_CACHE; j++) {
+        for (i = 0; i < g_segCacheCount; i++) {
+            if (Stricmp(g_segCache[i].path, saved[j].path) == 0 || strcmp(g_segCache[i].name, saved[j].name) == 0) {
+                break;
+            }
+        }
+        if (i == g_segCacheCount && FindSegment(saved[j].name, NULL, FALSE)) {
+            g_segCache[g_segCacheCount++] = saved[j];
+        }
+    }
+    Permit();
+    
+    /* Both lists together may be over the budget */
+    EvictSegCache(0);
+    
+    cacheFile = OpenNewEnvFile((STRPTR)"ENV:Open/Residents");
+    if (cacheFile) {
+        for (i = 0; i < g_segCacheCount; i++) {
+            struct SegCacheEntry *entry = &g_segCache[i];
+            
+            FPrintf(cacheFile, "%s\t%s\t%ld %ld %ld %lu %ld %ld %ld\n", entry->name, entry->path,
+                    entry->date.ds_Days, entry->date.ds_Minute, entry->date.ds_Tick, entry->size,
+                    entry->used.ds_Days, entry->used.ds_Minute, entry->used.ds_Tick);
+        }
+        Close(cacheFile);
+    }
+    
+    if (fileLock) {
+        ReleaseSemaphore(fileLock);
+    }
+    if (saved) {
+        FreeVec(saved);
+    }
+}
+
+/* Find the semaphore that guards ENV:Open/Residents, publishing it if it */
+/* is the first - it stays published, as another Open may be waiting on it */
+struct SignalSemaphore *GetSegCacheLock(VOID)
+{
+    struct SignalSemaphore *found = NULL;
+    struct SegCacheLock *fresh = NULL;
+    
+    Forbid();
+    found = FindSemaphore((STRPTR)SEG_CACHE_LOCK);
+    Permit();
+    if (found) {
+        return found;
+    }
+    
+    fresh = (struct SegCacheLock *)AllocVec(sizeof(struct SegCacheLock), MEMF_PUBLIC | MEMF_CLEAR);
+    if (!fresh) {
+        return NULL;
+    }
+    strcpy(fresh->sl_Name, SEG_CACHE_LOCK);
+    fresh->sl_Semaphore.ss_Link.ln_Name = fresh->sl_Name;
+    InitSemaphore(&fresh->sl_Semaphore);
+    
+    Forbid();
+    found = FindSemaphore((STRPTR)SEG_CACHE_LOCK);
+    if (!found) {
+        AddSemaphore(&fresh->sl_Semaphore);
+        found = &fresh->sl_Semaphore;
+        fresh = NULL;
+    }
+    Permit();
+    
+    if (fresh) {
+        FreeVec(fresh);
+    }
+    
+    return found;
+}
+
+/* Forget a resident tool entry (the segment itself is handled by the caller) */
+VOID DropSegCacheEntry(LONG index)
+{
+    g_segCache[index] = g_segCache[--g_segCacheCount];
+    g_segCacheDirty = TRUE;
+}
+
+/* Make room for a tool of the given size, oldest launch first */
+/* A size of 0 only brings the list down to the budget */
+/* Segments in use can't be removed, so this may fail */
+BOOL EvictSegCache(ULONG needed)
+{
+    struct Segment *seg;
+    ULONG total = 0;
+    LONG oldest;
+    LONG i;
+    BOOL removed;
+    BOOL tried[MAX_SEG_CACHE];
+    
+    memset(tried, 0, sizeof(tried));
+    
+    for (;;) {
+        total = 0;
+        for (i = 0; i < g_segCacheCount; i++) {
+            total += g_segCache[i].size;
+        }
+        if (total + needed <= (ULONG)g_segCacheBudget && (needed == 0 || g_segCacheCount < MAX_SEG_CACHE)) {
+            return TRUE;
+        }
+        
+        oldest = -1;
+        for (i = 0; i < g_segCacheCount; i++) {
+            if (!tried[i] && (oldest < 0 || CompareDates(&g_segCache[i].used, &g_segCache[oldest].used) > 0)) {
+                oldest = i;
+            }
+        }
+        if (oldest < 0) {
+            return FALSE;
+        }
+        
+        Forbid();
+        seg = FindSegment(g_segCache[oldest].name, NULL, FALSE);
+        removed = (BOOL)(!seg || RemSegment(seg));
+        Permit();
+        
+        if (removed) {
+            DropSegCacheEntry(oldest);
+            tried[oldest] = tried[g_segCacheCount];
+        } else {
+            tried[oldest] = TRUE;
+        }
+    }
+}
+
+/* Name to run a tool by with System() - its resident name if the tool is */
+/* pure and the resident cache is on, otherwise the path unchanged */
+/* Entries are found by path and date; the resident name only has to be */
+/* one no other program uses, so it is never the tool's bare name */
+STRPTR GetResidentCommand(STRPTR toolPath)
+{
+    struct FileInfoBlock *fib = NULL;
+    struct SegCacheEntry *entry = NULL;
+    struct Segment *seg;
+    struct DateStamp date;
+    UBYTE residentName[32];
+    STRPTR name;
+    BPTR toolLock;
+    BPTR seglist;
+    ULONG size = 0;
+    BOOL pure = FALSE;
+    BOOL current = FALSE;
+    BOOL resident = FALSE;
+    LONG i;
+    
+    if (g_segCacheBudget < 0) {
+        LoadSegCache();
+    }
+    if (g_segCacheBudget == 0 || !toolPath) {
+        return toolPath;
+    }
+    
+    name = FilePart(toolPath);
+    if (!*name || strlen(name) + 5 >= sizeof(residentName) || strchr(name, ' ')) {
+        return toolPath;
+    }
+    
+    /* Only pure tools may be shared by several processes */
+    fib = (struct FileInfoBlock *)AllocDosObject(DOS_FIB, NULL);
+    if (!fib) {
+        return toolPath;
+    }
+    StatCount(COUNT_LOCK);
+    toolLock = Lock(toolPath, ACCESS_READ);
+    if (toolLock) {
+        StatCount(COUNT_EXAMINE);
+        if (Examine(toolLock, fib) && fib->fib_DirEntryType < 0) {
+            pure = (BOOL)((fib->fib_Protection & FIBF_PURE) != 0);
+            date = fib->fib_Date;
+            size = (ULONG)fib->fib_Size;
+        }
+        UnLock(toolLock);
+    }
+    FreeDosObject(DOS_FIB, fib);
+    
+    if (!pure || size > (ULONG)g_segCacheBudget) {
+        return toolPath;
+    }
+    
+    MakeResidentName(toolPath, residentName, sizeof(residentName));
+    
+    for (i = 0; i < g_segCacheCount; i++) {
+        if (Stricmp(g_segCache[i].path, toolPath) == 0) {
+            entry = &g_segCache[i];
+            break;
+        }
+    }
+    
+    Forbid();
+    if (entry) {
+        /* An entry under an older name is replaced like a changed tool */
+        seg = FindSegment(entry->name, NULL, FALSE);
+        current = (BOOL)(strcmp(entry->name, residentName) == 0 && CompareDates(&entry->date, &date) == 0);
+        if (seg && current) {
+            resident = TRUE;
+        } else if (seg && !RemSegment(seg)) {
+            /* Old version still running - launch from disk this time */
+            Permit();
+            return toolPath;
+        }
+    }
+    Permit();
+    
+    if (resident) {
+        DateStamp(&entry->used);
+        g_segCacheDirty = TRUE;
+        return entry->name;
+    }
+    
+    /* Missing, replaced or moved - load it again */
+    if (entry) {
+        DropSegCacheEntry(i);
+        entry = NULL;
+    }
+    
+    if (!EvictSegCache(size)) {
+        return toolPath;
+    }
+    
+    seglist = LoadSeg(toolPath);
+    if (!seglist) {
+        return toolPath;
+    }
+    
+    /* Someone else's resident of that name is left alone */
+    Forbid();
+    if (FindSegment(residentName, NULL, FALSE) || !AddSegment(residentName, seglist, 0)) {
+        Permit();
+        UnLoadSeg(seglist);
+        return toolPath;
+    }
+    Permit();
+    
+    entry = &g_segCache[g_segCacheCount++];
+    Strncpy(entry->name, residentName, sizeof(entry->name));
+    Strncpy(entry->path, toolPath, sizeof(entry->path));
+    entry->date = date;
+    entry->size = size;
+    DateStamp(&entry->used);
+    g_segCacheDirty = TRUE;
+    
+    return entry->name;
+}
+
+/* Resident name for a tool: its file name and a hash of its whole path, */
+/* e.g. "Ed.3f2a", so it can't take the place of a resident of that name */
+VOID MakeResidentName(STRPTR toolPath, UBYTE *nameOut, LONG nameSize)
+{
+    ULONG hash = 0;
+    STRPTR p;
+    
+    for (p = toolPath; *p; p++) {
+        hash = hash * 31 + ToLower(*p);
+    }
+    
+    SNPrintf(nameOut, nameSize, "%s.%04lx", FilePart(toolPath), (hash ^ (hash >> 16)) & 0xFFFF);
+}
+
+/* Save the tool path cache if this run changed it */
+VOID SaveToolPaths(VOID)
+{
+    BPTR cacheFile = NULL;
+    LONG i;
+    
+    if (!g_toolPathsDirty) {
+        return;
+    }
+    g_toolPathsDirty = FALSE;
+    
+    cacheFile = OpenNewEnvFile((STRPTR)"ENV:Open/ToolCache");
+    if (!cacheFile) {
+        return;
+    }
+    
+    for (i = 0; i < g_toolPathCount; i++) {
+        struct ToolPath *entry = &g_toolPaths[i];
+        
+        FPrintf(cacheFile, "%s\t%s\t%ld %ld %ld\n", entry->name, entry->path,
+                entry->date.ds_Days, entry->date.ds_Minute, entry->date.ds_Tick);
+    }
+    
+    Close(cacheFile);
+}
+
+/* Check that a tool can still be found and get the path to launch it by */
+/* Returns FALSE only if the tool is known to be gone, so the caller can */
+/* move on to the next candidate; pathOut is only set on success */
+/* toolFlags are a datatypes tool's tn_Flags, 0 for any other tool */
+BOOL CheckToolPath(STRPTR tool, UWORD toolFlags, UBYTE *pathOut, LONG pathSize)
+{
+    STRPTR program;
+    STRPTR end;
+    UBYTE saved;
+    BOOL found;
+    
+    if (!tool || !*tool || !pathOut) {
+        return FALSE;
+    }
+    
+    /* Shell and ARexx tools are command lines, not programs to look for */
+    if ((toolFlags & TF_LAUNCH_MASK) == TF_SHELL || (toolFlags & TF_LAUNCH_MASK) == TF_RX) {
+        Strncpy(pathOut, tool, pathSize);
+        return TRUE;
+    }
+    
+    /* Only the first word names the program - "Work:My Tool" may be quoted */
+    program = tool;
+    if (*program == '"') {
+        program++;
+        end = strchr(program, '"');
+    } else {
+        end = strchr(program, ' ');
+    }
+    if (end == NULL) {
+        return CheckToolProgram(tool, pathOut, pathSize);
+    }
+    
+    saved = *end;
+    *end = '\0';
+    found = (BOOL)(*program != '\0' && CheckToolProgram(program, pathOut, pathSize));
+    *end = saved;
+    
+    /* With arguments the tool is launched as it was given */
+    if (found) {
+        Strncpy(pathOut, tool, pathSize);
+    }
+    
+    return found;
+}
+
+/* Look for one program, through ENV:Open/ToolCache where it is known */
+BOOL CheckToolProgram(STRPTR tool, UBYTE *pathOut, LONG pathSize)
+{
+    struct ToolPath *entry = NULL;
+    struct DateStamp date;
+    UBYTE path[256];
+    BOOL vanished = FALSE;
+    BPTR toolLock = NULL;
+    LONG i;
+    
+    if (!tool || !*tool || !pathOut) {
+        return FALSE;
+    }
+    
+    if (!g_toolPathsLoaded) {
+        LoadToolPaths();
+    }
+    
+    for (i = 0; i < g_toolPathCount; i++) {
+        if (Stricmp(g_toolPaths[i].name, tool) == 0) {
+            entry = &g_toolPaths[i];
+            break;
+        }
+    }
+    
+    if (entry) {
+        if (!entry->checked) {
+            /* Still there and the same file? One Lock and Examine per run */
+            StatCount(COUNT_LOCK);
+            toolLock = Lock(entry->path, ACCESS_READ);
+            if (toolLock && GetToolDate(toolLock, &date) && CompareDates(&date, &entry->date) == 0) {
+                entry->checked = TRUE;
+            }
+            if (toolLock) {
+                UnLock(toolLock);
+            }
+        }
+        
+        if (entry->checked) {
+            Strncpy(pathOut, entry->path, pathSize);
+            return TRUE;
+        }
+        
+        /* Gone or replaced - drop the entry and look again */
+        vanished = (BOOL)(!toolLock);
+        *entry = g_toolPaths[--g_toolPathCount];
+        entry = NULL;
+        g_toolPathsDirty = TRUE;
+    }
+    
+    if (LocateTool(tool, path, sizeof(path), &date)) {
+        if (strlen(tool) < sizeof(entry->name)) {
+            if (g_toolPathCount < MAX_TOOL_PATHS) {
+                entry = &g_toolPaths[g_toolPathCount++];
+            } else {
+                /* Table full - replace the first entry */
+                entry = &g_toolPaths[0];
+            }
+            Strncpy(entry->name, tool, sizeof(entry->name));
+            Strncpy(entry->path, path, sizeof(entry->path));
+            entry->date = date;
+            entry->checked = TRUE;
+            g_toolPathsDirty = TRUE;
+        }
+        Strncpy(pathOut, path, pathSize);
+        return TRUE;
+    }
+    
+    /* A cached or absolute tool that can't be found is really gone; */
+    /* a plain name may still be on Workbench's own path */
+    if (vanished || strchr(tool, ':') != NULL) {
+        FPrintf(MessageOutput(), "Open: Tool not found: %s\n", tool);
+        return FALSE;
+    }
+    
+    Strncpy(pathOut, tool, pathSize);
+    return TRUE;
+}
+
+/* Find a tool the way a shell would - as given, then along the command path */
+BOOL LocateTool(STRPTR tool, UBYTE *pathOut, LONG pathSize, struct DateStamp *dateOut)
+{
+    struct CommandLineInterface *cli = NULL;
+    struct CommandPathEntry *pathEntry = NULL;
+    BPTR toolLock = NULL;
+    BPTR dirLock = NULL;
+    BPTR oldDir = NULL;
+    BOOL found = FALSE;
+    LONG i;
+    
+    if (strchr(tool, ':') != NULL || strchr(tool, '/') != NULL) {
+        StatCount(COUNT_LOCK);
+        toolLock = Lock(tool, ACCESS_READ);
+    } else {
+        cli = Cli();
+        if (cli) {
+            for (pathEntry = (struct CommandPathEntry *)BADDR(cli->cli_CommandDir);
+                 pathEntry != NULL && !toolLock;
+                 pathEntry = (struct CommandPathEntry *)BADDR(pathEntry->cpe_Next)) {
+                oldDir = CurrentDir(pathEntry->cpe_Lock);
+                StatCount(COUNT_LOCK);
+                toolLock = Lock(tool, ACCESS_READ);
+                CurrentDir(oldDir);
+            }
+        }
+        
+        for (i = 0; workbenchPath[i] != NULL && !toolLock; i++) {
+            /* With a CLI path only C: is still missing */
+            if (cli && i > 0) {
+                break;
+            }
+            StatCount(COUNT_LOCK);
+            dirLock = Lock((STRPTR)workbenchPath[i], ACCESS_READ);
+            if (dirLock) {
+                oldDir = CurrentDir(dirLock);
+                StatCount(COUNT_LOCK);
+                toolLock = Lock(tool, ACCESS_READ);
+                CurrentDir(oldDir);
+                UnLock(dirLock);
+            }
+        }
+    }
+    
+    if (toolLock) {
+        found = (BOOL)(GetToolDate(toolLock, dateOut) && NameFromLock(toolLock, pathOut, pathSize));
+        UnLock(toolLock);
+    }
+    
+    return found;
+}
+
+/* Get the datestamp of a tool, failing for drawers */
+BOOL GetToolDate(BPTR toolLock, struct DateStamp *dateOut)
+{
+    struct FileInfoBlock *fib = NULL;
+    BOOL result = FALSE;
+    
+    fib = (struct FileInfoBlock *)AllocDosObject(DOS_FIB, NULL);
+    if (!fib) {
+        return FALSE;
+    }
+    
+    StatCount(COUNT_EXAMINE);
+    if (Examine(toolLock, fib) && fib->fib_DirEntryType < 0) {
+        *dateOut = fib->fib_Date;
+        result = TRUE;
+    }
+    
+    FreeDosObject(DOS_FIB, fib);
+    
+    return result;
+}
+
+/* Attach to the shared resolution cache, creating it if needed */
+/* The cache is only used while $Open/SharedCache is set; its value is the */
+/* number of minutes an unused cache is kept before it is freed */
+VOID AttachSharedCache(VOID)
+{
+    struct SharedCache *cache = NULL;
+    struct SharedCache *stale = NULL;
+    struct SharedCache *fresh = NULL;
+    UBYTE varBuffer[16];
+    LONG keepMinutes = -1;
+    
+    if (GetVar((STRPTR)"Open/SharedCache", varBuffer, sizeof(varBuffer), 0) >= 0) {
+        if (StrToLong(varBuffer, &keepMinutes) < 0 || keepMinutes < 0) {
+            keepMinutes = SHARED_CACHE_KEEP;
+        }
+    }
+    
+    Forbid();
+    cache = (struct SharedCache *)FindSemaphore((STRPTR)SHARED_CACHE_NAME);
+    if (cache && cache->sc_Version == SHARED_CACHE_VERSION) {
+        /* Nobody attached and disabled or unused for too long - free it */
+        if (cache->sc_Users == 0 && (keepMinutes < 0 || IsSharedCacheStale(cache)) &&
+            AttemptSemaphore(&cache->sc_Semaphore)) {
+            RemSemaphore(&cache->sc_Semaphore);
+            ReleaseSemaphore(&cache->sc_Semaphore);
+            stale = cache;
+            cache = NULL;
+        } else if (keepMinutes >= 0) {
+            cache->sc_Users++;
+            g_sharedCache = cache;
+        }
+    }
+    Permit();
+    
+    if (stale) {
+        FreeVec(stale);
+    }
+    
+    if (keepMinutes < 0 || g_sharedCache || cache) {
+        return;
+    }
+    
+    /* No cache yet - publish a new one */
+    fresh = (struct SharedCache *)AllocVec(sizeof(struct SharedCache), MEMF_PUBLIC | MEMF_CLEAR);
+    if (!fresh) {
+        return;
+    }
+    strcpy(fresh->sc_Name, SHARED_CACHE_NAME);
+    fresh->sc_Semaphore.ss_Link.ln_Name = fresh->sc_Name;
+    fresh->sc_Semaphore.ss_Link.ln_Pri = 0;
+    fresh->sc_Version = SHARED_CACHE_VERSION;
+    fresh->sc_Slots = SHARED_CACHE_SLOTS;
+    fresh->sc_KeepMinutes = keepMinutes;
+    fresh->sc_Users = 1;
+    DateStamp(&fresh->sc_LastUsed);
+    InitSemaphore(&fresh->sc_Semaphore);
+    
+    Forbid();
+    cache = (struct SharedCache *)FindSemaphore((STRPTR)SHARED_CACHE_NAME);
+    if (cache) {
+        /* Another Open was quicker */
+        if (cache->sc_Version == SHARED_CACHE_VERSION) {
+            cache->sc_Users++;
+            g_sharedCache = cache;
+        }
+    } else {
+        AddSemaphore(&fresh->sc_Semaphore);
+        g_sharedCache = fresh;
+    }
+    Permit();
+    
+    if (g_sharedCache != fresh) {
+        FreeVec(fresh);
+    }
+}
+
+/* Detach from the shared resolution cache */
+/* The cache stays published so the next Open can use it, unless it is */
+/* kept for 0 minutes - then the last one to leave frees it */
+VOID DetachSharedCache(VOID)
+{
+    struct SharedCache *stale = NULL;
+    
+    if (!g_sharedCache) {
+        return;
+    }
+    
+    ObtainSemaphore(&g_sharedCache->sc_Semaphore);
+    DateStamp(&g_sharedCache->sc_LastUsed);
+    ReleaseSemaphore(&g_sharedCache->sc_Semaphore);
+    
+    Forbid();
+    g_sharedCache->sc_Users--;
+    if (g_sharedCache->sc_Users == 0 && g_sharedCache->sc_KeepMinutes == 0 &&
+        AttemptSemaphore(&g_sharedCache->sc_Semaphore)) {
+        RemSemaphore(&g_sharedCache->sc_Semaphore);
+        ReleaseSemaphore(&g_sharedCache->sc_Semaphore);
+        stale = g_sharedCache;
+    }
+    Permit();
+    
+    if (stale) {
+        FreeVec(stale);
+    }
+    
+    g_sharedCache = NULL;
+}
+
+/* Check whether the shared cache has been unused for longer than it is kept */
+BOOL IsSharedCacheStale(struct SharedCache *cache)
+{
+    struct DateStamp now;
+    LONG minutes;
+    
+    DateStamp(&now);
+    minutes = (now.ds_Days - cache->sc_LastUsed.ds_Days) * 1440 +
+              (now.ds_Minute - cache->sc_LastUsed.ds_Minute);
+    
+    return (BOOL)(minutes >= cache->sc_KeepMinutes);
+}
+
+/* Look an entry up in the shared cache (shared lock, copied out) */
+BOOL GetSharedEntry(UWORD kind, STRPTR key, UWORD verb, struct SharedEntry *entryOut)
+{
+    BOOL found = FALSE;
+    ULONG i;
+    
+    if (!g_sharedCache || !key || !*key || g_benchCold) {
+        return FALSE;
+    }
+    
+    ObtainSemaphoreShared(&g_sharedCache->sc_Semaphore);
+    for (i = 0; i < g_sharedCache->sc_Slots; i++) {
+        struct SharedEntry *entry = &g_sharedCache->sc_Entries[i];
+        
+        if (entry->kind == kind && entry->verb == verb && Stricmp(entry->key, key) == 0) {
+            *entryOut = *entry;
+            found = TRUE;
+            break;
+        }
+    }
+    ReleaseSemaphore(&g_sharedCache->sc_Semaphore);
+    
+    return found;
+}
+
+/* Insert or replace an entry in the shared cache (exclusive lock) */
+/* Once all slots are used the oldest insert is overwritten */
+VOID PutSharedEntry(struct SharedEntry *entry)
+{
+    struct SharedEntry *slot = NULL;
+    ULONG i;
+    
+    if (!g_sharedCache || !entry) {
+        return;
+    }
+    
+    ObtainSemaphore(&g_sharedCache->sc_Semaphore);
+    for (i = 0; i < g_sharedCache->sc_Slots; i++) {
+        struct SharedEntry *existing = &g_sharedCache->sc_Entries[i];
+        
+        if (existing->kind == entry->kind && existing->verb == entry->verb && Stricmp(existing->key, entry->key) == 0) {
+            slot = existing;
+            break;
+        }
+    }
+    if (!slot) {
+        slot = &g_sharedCache->sc_Entries[g_sharedCache->sc_NextSlot];
+        g_sharedCache->sc_NextSlot = (g_sharedCache->sc_NextSlot + 1) % g_sharedCache->sc_Slots;
+    }
+    *slot = *entry;
+    DateStamp(&g_sharedCache->sc_LastUsed);
+    ReleaseSemaphore(&g_sharedCache->sc_Semaphore);
+}
+
+/* Build a key for the current item that doesn't depend on how it was named */
+/* Volume node and disk key from the lock, plus the name as a safeguard */
+BOOL GetFileKey(STRPTR fileName, BPTR fileLock, UBYTE *keyOut, LONG keySize)
+{
+    struct FileLock *fl = NULL;
+    
+    if (!g_sharedCache || !fileLock || !g_item.fibValid) {
+        return FALSE;
+    }
+    
+    fl = (struct FileLock *)BADDR(fileLock);
+    if (fl->fl_Key == 0 || fl->fl_Volume == 0) {
+        return FALSE;
+    }
+    
+    SNPrintf(keyOut, keySize, "%lx:%lx:%s", (ULONG)fl->fl_Volume, (ULONG)fl->fl_Key, FilePart(fileName));
+    
+    return TRUE;
+}
+
+/* Date of the def_ icon GetDefIconsDefaultTool() would load, zero if none */
+/* Shared SHARED_DEFTOOL entries are only used while this still matches */
+VOID GetDefIconDate(STRPTR defIconName, struct DateStamp *dateOut)
+{
+    UBYTE iconPath[80];
+    BPTR iconLock;
+    
+    memset(dateOut, 0, sizeof(struct DateStamp));
+    
+    SNPrintf(iconPath, sizeof(iconPath), "ENV:Sys/%s.info", defIconName);
+    StatCount(COUNT_LOCK);
+    iconLock = Lock(iconPath, SHARED_LOCK);
+    if (!iconLock) {
+        SNPrintf(iconPath, sizeof(iconPath), "ENVARC:Sys/%s.info", defIconName);
+        StatCount(COUNT_LOCK);
+        iconLock = Lock(iconPath, SHARED_LOCK);
+    }
+    if (iconLock) {
+        GetToolDate(iconLock, dateOut);
+        UnLock(iconLock);
+    }
+}
+
+/* Date of DEVS:DataTypes, examined once per run */
+/* Descriptors are added and replaced there, so it dates the compiled */
+/* descriptors and shared SHARED_DTTOOL entries */
+BOOL GetDataTypesDate(struct DateStamp *dateOut)
+{
+    struct FileInfoBlock *fib;
+    BPTR dirLock;
+    
+    if (!g_dtDirChecked) {
+        g_dtDirChecked = TRUE;
+        memset(&g_dtDirDate, 0, sizeof(g_dtDirDate));
+        
+        fib = (struct FileInfoBlock *)AllocDosObject(DOS_FIB, NULL);
+        if (fib) {
+            StatCount(COUNT_LOCK);
+            dirLock = Lock((STRPTR)"DEVS:DataTypes", ACCESS_READ);
+            if (dirLock) {
+                StatCount(COUNT_EXAMINE);
+                if (Examine(dirLock, fib) && fib->fib_DirEntryType > 0) {
+                    g_dtDirDate = fib->fib_Date;
+                }
+                UnLock(dirLock);
+            }
+            FreeDosObject(DOS_FIB, fib);
+        }
+    }
+    
+    *dateOut = g_dtDirDate;
+    
+    return (BOOL)(g_dtDirDate.ds_Days != 0 || g_dtDirDate.ds_Minute != 0 || g_dtDirDate.ds_Tick != 0);
+}
+
+/* Get the datatypes group of the current item, looking it up only once */
+ULONG GetItemGroup(STRPTR fileName, BPTR fileLock)
+{
+    struct DataType *dtn = NULL;
+    BOOL matched;
+    
+    if (!g_item.groupValid && fileLock) {
+        g_item.groupValid = TRUE;
+        g_item.groupID = 0;
+        
+        /* The compiled descriptors answer most files from the header alone */
+        StatBegin(STAT_DATATYPE);
+        matched = MatchDTHeader(fileName, &g_item.groupID);
+        StatEnd(STAT_DATATYPE);
+        
+        if (!matched && DataTypesBase) {
+            StatBegin(STAT_DATATYPE);
+            StatCount(COUNT_OBTAINDT);
+            dtn = ObtainDataTypeA(DTST_FILE, (APTR)fileLock, NULL);
+            StatEnd(STAT_DATATYPE);
+            if (dtn) {
+                g_item.groupID = dtn->dtn_Header->dth_GroupID;
+                ReleaseDataType(dtn);
+            }
+        }
+    }
+    
+    return g_item.groupID;
+}
+
+/* Load the compiled descriptors, compiling DEVS:DataTypes if they are stale */
+VOID LoadDTMatch(VOID)
+{
+    struct DateStamp dirDate;
+    LONG compiled;
+    
+    g_dtMatchLoaded = TRUE;
+    
+    if (!GetDataTypesDate(&dirDate)) {
+        return;
+    }
+    
+    if (!ReadDTMatch(&dirDate)) {
+        compiled = CompileDTMatch(&dirDate);
+        if (compiled == 0) {
+            /* Note it, so later runs don't read the whole drawer again */
+            /* until it changes - datatypes.library decides meanwhile */
+            g_dtMatchHeader.magic = DTMATCH_MAGIC;
+            g_dtMatchHeader.version = DTMATCH_VERSION;
+            g_dtMatchHeader.count = DTMATCH_FAILED;
+            g_dtMatchHeader.dirDate = dirDate;
+            g_dtMatchHeader.poolSize = 0;
+        }
+        if (compiled >= 0) {
+            WriteDTMatch();
+        }
+    }
+    
+    if (!g_dtMatch) {
+        return;
+    }
+    
+    if (!BuildDTBuckets()) {
+        FreeDTMatch();
+    }
+}
+
+/* Read ENV:Open/DTMatch if it was compiled from the current DEVS:DataTypes */
+/* Also TRUE, with g_dtMatch left NULL, if it notes that compiling failed */
+BOOL ReadDTMatch(struct DateStamp *dirDate)
+{
+    struct DTMatchEntry *entry;
+    BPTR matchFile;
+    ULONG size;
+    BOOL ok = FALSE;
+    LONG i;
+    
+    matchFile = Open((STRPTR)DTMATCH_FILE, MODE_OLDFILE);
+    if (!matchFile) {
+        return FALSE;
+    }
+    
+    if (Read(matchFile, &g_dtMatchHeader, sizeof(g_dtMatchHeader)) == sizeof(g_dtMatchHeader)
+        && g_dtMatchHeader.magic == DTMATCH_MAGIC && g_dtMatchHeader.version == DTMATCH_VERSION
+        && CompareDates(&g_dtMatchHeader.dirDate, dirDate) == 0) {
+        if (g_dtMatchHeader.count == DTMATCH_FAILED) {
+            Close(matchFile);
+            return TRUE;
+        }
+        if (g_dtMatchHeader.count <= MAX_DTMATCH && g_dtMatchHeader.poolSize <= DTMATCH_POOL) {
+            size = g_dtMatchHeader.count * sizeof(struct DTMatchEntry) + g_dtMatchHeader.poolSize;
+            g_dtMatch = (struct DTMatchEntry *)AllocVec(size, MEMF_ANY);
+            if (g_dtMatch && Read(matchFile, g_dtMatch, size) == (LONG)size) {
+                g_dtMatchPool = (UBYTE *)(g_dtMatch + g_dtMatchHeader.count);
+                ok = TRUE;
+            }
+        }
+    }
+    
+    Close(matchFile);
+    
+    /* Every mask and pattern has to lie within the pool - masks on a word */
+    /* boundary, patterns ending there too - or the file isn't ours */
+    for (i = 0; ok && i < g_dtMatchHeader.count; i++) {
+        entry = &g_dtMatch[i];
+        if (entry->maskLen != 0 && (entry->maskOffset & 1 || entry->maskOffset > g_dtMatchHeader.poolSize
+            || entry->maskLen * sizeof(WORD) > g_dtMatchHeader.poolSize - entry->maskOffset)) {
+            ok = FALSE;
+        }
+        if (entry->patternOffset != 0 && (entry->patternOffset >= g_dtMatchHeader.poolSize
+            || memchr(g_dtMatchPool + entry->patternOffset, '\0', g_dtMatchHeader.poolSize - entry->patternOffset) == NULL)) {
+            ok = FALSE;
+        }
+    }
+    
+    if (!ok) {
+        FreeDTMatch();
+    }
+    return ok;
+}
+
+/* Compile every descriptor in DEVS:DataTypes */
+/* Fails as a whole if one can't be read, so no descriptor is ever missed */
+/* Returns 1 if compiled, 0 if the drawer can't be, -1 if out of memory */
+LONG CompileDTMatch(struct DateStamp *dirDate)
+{
+    struct FileInfoBlock *fib = NULL;
+    struct DTMatchEntry *entries = NULL;
+    UBYTE *pool = NULL;
+    ULONG poolUsed = 4;       /* Offset 0 means "none" */
+    BPTR dirLock = NULL;
+    BPTR oldDir;
+    UWORD count = 0;
+    LONG nameLen;
+    LONG compiled;
+    LONG result = 0;
+    BOOL ok = FALSE;
+    
+    fib = (struct FileInfoBlock *)AllocDosObject(DOS_FIB, NULL);
+    entries = (struct DTMatchEntry *)AllocVec(MAX_DTMATCH * sizeof(struct DTMatchEntry), MEMF_CLEAR);
+    pool = (UBYTE *)AllocVec(DTMATCH_POOL, MEMF_CLEAR);
+    StatCount(COUNT_LOCK);
+    dirLock = Lock((STRPTR)"DEVS:DataTypes", ACCESS_READ);
+    
+    if (fib && entries && pool && dirLock && Examine(dirLock, fib)) {
+        oldDir = CurrentDir(dirLock);
+        ok = TRUE;
+        
+        while (ok && ExNext(dirLock, fib)) {
+            nameLen = strlen(fib->fib_FileName);
+            if (fib->fib_DirEntryType >= 0
+                || (nameLen > 5 && Stricmp(fib->fib_FileName + nameLen - 5, (STRPTR)".info") == 0)) {
+                continue;
+            }
+            
+            if (count == MAX_DTMATCH) {
+                ok = FALSE;
+                break;
+            }
+            
+            compiled = CompileDTDescriptor(fib->fib_FileName, &entries[count], pool, &poolUsed);
+            if (compiled < 0) {
+                ok = FALSE;
+            } else if (compiled > 0) {
+                count++;
+            }
+        }
+        
+        CurrentDir(oldDir);
+    }
+    
+    if (ok) {
+        /* One block - entries, then the pool - as it is kept in ENV: */
+        g_dtMatch = (struct DTMatchEntry *)AllocVec(count * sizeof(struct DTMatchEntry) + poolUsed, MEMF_ANY);
+        if (g_dtMatch) {
+            memcpy(g_dtMatch, entries, count * sizeof(struct DTMatchEntry));
+            g_dtMatchPool = (UBYTE *)(g_dtMatch + count);
+            memcpy(g_dtMatchPool, pool, poolUsed);
+            g_dtMatchHeader.magic = DTMATCH_MAGIC;
+            g_dtMatchHeader.version = DTMATCH_VERSION;
+            g_dtMatchHeader.count = count;
+            g_dtMatchHeader.dirDate = *dirDate;
+            g_dtMatchHeader.poolSize = poolUsed;
+            result = 1;
+        } else {
+            result = -1;
+        }
+    } else if (!fib || !entries || !pool) {
+        result = -1;
+    }
+    
+    if (dirLock) {
+        UnLock(dirLock);
+    }
+    if (pool) {
+        FreeVec(pool);
+    }
+    if (entries) {
+        FreeVec(entries);
+    }
+    if (fib) {
+        FreeDosObject(DOS_FIB, fib);
+    }
+    
+    return result;
+}
+
+/* Compile one descriptor (FORM DTYP with DTHD and optionally DTCD) */
+/* Returns 1 if compiled, 0 if the file is no descriptor, -1 on error */
+LONG CompileDTDescriptor(STRPTR name, struct DTMatchEntry *entry, UBYTE *pool, ULONG *poolUsed)
+{
+    struct DataTypeHeader *dth;
+    ULONG chunk[3];
+    UBYTE *dthd = NULL;
+    ULONG dthdSize = 0;
+    ULONG maskOffset;
+    ULONG patternOffset;
+    ULONG tokenLen;
+    STRPTR pattern;
+    WORD *mask;
+    BPTR file;
+    LONG result = -1;
+    LONG i;
+    
+    file = Open(name, MODE_OLDFILE);
+    if (!file) {
+        return -1;
+    }
+    
+    memset(entry, 0, sizeof(struct DTMatchEntry));
+    
+    if (Read(file, chunk, 12) != 12 || chunk[0] != ID_FORM || chunk[2] != ID_DTYP) {
+        Close(file);
+        return 0;
+    }
+    
+    /* Keep DTHD, note DTCD (recognition code), skip the rest */
+    while (Read(file, chunk, 8) == 8) {
+        if (chunk[0] == ID_DTHD && !dthd && chunk[1] >= sizeof(struct DataTypeHeader) && chunk[1] < 4096) {
+            dthdSize = chunk[1];
+            dthd = (UBYTE *)AllocVec(dthdSize + 1, MEMF_CLEAR);
+            if (!dthd || Read(file, dthd, dthdSize) != (LONG)dthdSize) {
+                break;
+            }
+            if (dthdSize & 1) {
+                Seek(file, 1, OFFSET_CURRENT);
+            }
+        } else {
+            if (chunk[0] == ID_DTCD) {
+                entry->opaque = TRUE;
+            }
+            if (Seek(file, (chunk[1] + 1) & ~1, OFFSET_CURRENT) < 0) {
+                break;
+            }
+        }
+    }
+    Close(file);
+    
+    if (dthd && dthdSize != 0) {
+        /* Pointers in the chunk are offsets from its start */
+        dth = (struct DataTypeHeader *)dthd;
+        maskOffset = (ULONG)dth->dth_Mask;
+        patternOffset = (ULONG)dth->dth_Pattern;
+        
+        entry->groupID = dth->dth_GroupID;
+        entry->priority = (WORD)dth->dth_Priority;
+        entry->flags = dth->dth_Flags;
+        entry->maskLen = (dth->dth_MaskLen > 0) ? (UWORD)dth->dth_MaskLen : 0;
+        
+        if (entry->maskLen == 0) {
+            entry->opaque = TRUE;
+        }
+        
+        if (entry->maskLen && maskOffset + entry->maskLen * sizeof(WORD) <= dthdSize
+            && *poolUsed + entry->maskLen * sizeof(WORD) <= DTMATCH_POOL) {
+            mask = (WORD *)(pool + *poolUsed);
+            memcpy(mask, dthd + maskOffset, entry->maskLen * sizeof(WORD));
+            if (!(entry->flags & DTF_CASE)) {
+                for (i = 0; i < entry->maskLen; i++) {
+                    if (mask[i] >= 'A' && mask[i] <= 'Z') {
+                        mask[i] += 'a' - 'A';
+                    }
+                }
+            }
+            entry->maskOffset = *poolUsed;
+            *poolUsed += entry->maskLen * sizeof(WORD);
+        } else if (entry->maskLen) {
+            /* Can't keep the mask - let datatypes.library decide */
+            entry->opaque = TRUE;
+        }
+        
+        /* "#?" and no pattern match any name */
+        if (patternOffset != 0 && patternOffset < dthdSize) {
+            pattern = (STRPTR)(dthd + patternOffset);
+            if (*pattern && strcmp((char *)pattern, "#?") != 0) {
+                tokenLen = strlen((char *)pattern) * 2 + 2;
+                if (*poolUsed + tokenLen <= DTMATCH_POOL
+                    && ParsePatternNoCase(pattern, pool + *poolUsed, tokenLen) >= 0) {
+                    entry->patternOffset = *poolUsed;
+                    *poolUsed += (tokenLen + 1) & ~1;
+                } else {
+                    entry->opaque = TRUE;
+                }
+            }
+        }
+        
+        result = 1;
+    }
+    
+    if (dthd) {
+        FreeVec(dthd);
+    }
+    
+    return result;
+}
+
+/* Keep the compiled descriptors, or that there are none, in ENV: for the next run */
+VOID WriteDTMatch(VOID)
+{
+    BPTR matchFile;
+    
+    matchFile = OpenNewEnvFile((STRPTR)DTMATCH_FILE);
+    if (matchFile) {
+        Write(matchFile, &g_dtMatchHeader, sizeof(g_dtMatchHeader));
+        if (g_dtMatch) {
+            Write(matchFile, g_dtMatch, g_dtMatchHeader.count * sizeof(struct DTMatchEntry) + g_dtMatchHeader.poolSize);
+        }
+        Close(matchFile);
+    }
+}
+
+/* Sort the entries into buckets by the first byte of their mask */
+/* Case-insensitive letters go into both buckets; masks starting with a */
+/* wildcard and opaque entries go into DTMATCH_ANY, which is always checked */
+BOOL BuildDTBuckets(VOID)
+{
+    static UWORD fill[DTMATCH_ANY + 1];   /* Static - 514 bytes is too much for the stack */
+    struct DTMatchEntry *entry;
+    WORD first;
+    UWORD total = 0;
+    LONG pass;
+    LONG i;
+    LONG b;
+    
+    memset(g_dtBucketStart, 0, sizeof(g_dtBucketStart));
+    memset(fill, 0, sizeof(fill));
+    
+    g_dtBuckets = (UWORD *)AllocVec((2 * g_dtMatchHeader.count + 1) * sizeof(UWORD), MEMF_ANY);
+    if (!g_dtBuckets) {
+        return FALSE;
+    }
+    
+    /* Count, then place */
+    for (pass = 0; pass < 2; pass++) {
+        for (i = 0; i < g_dtMatchHeader.count; i++) {
+            entry = &g_dtMatch[i];
+            first = -1;
+            if (!entry->opaque && entry->maskLen) {
+                first = ((WORD *)(g_dtMatchPool + entry->maskOffset))[0];
+            }
+            
+            for (b = 0; b < 2; b++) {
+                LONG bucket = (first < 0) ? DTMATCH_ANY : (first & 0xFF);
+                
+                if (b == 1) {
+                    /* Upper-case twin of a folded letter */
+                    if (first < 'a' || first > 'z' || (entry->flags & DTF_CASE)) {
+                        break;
+                    }
+                    bucket = first - ('a' - 'A');
+                }
+                
+                if (pass == 0) {
+                    g_dtBucketStart[bucket + 1]++;
+                } else {
+                    g_dtBuckets[g_dtBucketStart[bucket] + fill[bucket]++] = (UWORD)i;
+                }
+            }
+        }
+        
+        if (pass == 0) {
+            for (b = 1; b < DTMATCH_ANY + 2; b++) {
+                total += g_dtBucketStart[b];
+                g_dtBucketStart[b] = total;
+            }
+        }
+    }
+    
+    return TRUE;
+}
+
+/* Free the compiled descriptors */
+VOID FreeDTMatch(VOID)
+{
+    if (g_dtBuckets) {
+        FreeVec(g_dtBuckets);
+        g_dtBuckets = NULL;
+    }
+    if (g_dtMatch) {
+        FreeVec(g_dtMatch);
+        g_dtMatch = NULL;
+        g_dtMatchPool = NULL;
+    }
+}
+
+/* Find the datatypes group of the current item from its header */
+/* FALSE means datatypes.library has to decide: a descriptor with */
+/* recognition code or without a mask could apply, two descriptors tie, */
+/* or a mask is longer than the header buffer */
+BOOL MatchDTHeader(STRPTR fileName, ULONG *groupOut)
+{
+    struct DTMatchEntry *entry;
+    struct DTMatchEntry *best = NULL;
+    UBYTE *header = g_item.header;
+    STRPTR filePart;
+    WORD *mask;
+    ULONG id;
+    LONG opaquePriority = -32768 - 1;
+    LONG headerLen;
+    LONG fileType;
+    LONG type;
+    BOOL tie = FALSE;
+    LONG bucket;
+    LONG pass;
+    LONG i;
+    LONG m;
+    UBYTE c;
+    
+    if (!g_dtMatchLoaded) {
+        LoadDTMatch();
+    }
+    if (!g_dtBuckets || !fileName || !ReadItemHeader(fileName)) {
+        return FALSE;
+    }
+    
+    headerLen = g_item.headerLen;
+    filePart = FilePart(fileName);
+    
+    /* What kind of descriptor can apply: IFF, text or binary */
+    id = (headerLen >= 12) ? *(ULONG *)header : 0;
+    if (id == ID_FORM || id == ID_CAT || id == ID_LIST) {
+        fileType = DTF_IFF;
+    } else if (IsTextHeader()) {
+        fileType = DTF_ASCII;
+    } else {
+        fileType = DTF_BINARY;
+    }
+    
+    for (pass = 0; pass < 2; pass++) {
+        bucket = (pass == 0) ? header[0] : DTMATCH_ANY;
+        
+        for (i = g_dtBucketStart[bucket]; i < g_dtBucketStart[bucket + 1]; i++) {
+            entry = &g_dtMatch[g_dtBuckets[i]];
+            
+            /* Text may still be matched by a binary mask, nothing else crosses */
+            type = entry->flags & DTF_TYPE_MASK;
+            if (type != fileType && !(fileType == DTF_ASCII && type == DTF_BINARY)) {
+                continue;
+            }
+            
+            if (entry->patternOffset && !MatchPatternNoCase(g_dtMatchPool + entry->patternOffset, filePart)) {
+                continue;
+            }
+            
+            if (entry->opaque || (entry->maskLen > headerLen && (!g_item.fibValid || g_item.size > (ULONG)headerLen))) {
+                if (entry->priority > opaquePriority) {
+                    opaquePriority = entry->priority;
+                }
+                continue;
+            }
+            if (entry->maskLen > headerLen) {
+                continue;
+            }
+            
+            mask = (WORD *)(g_dtMatchPool + entry->maskOffset);
+            for (m = 0; m < entry->maskLen; m++) {
+                if (mask[m] < 0) {
+                    continue;
+                }
+                c = header[m];
+                if (!(entry->flags & DTF_CASE) && c >= 'A' && c <= 'Z') {
+                    c += 'a' - 'A';
+                }
+                if (c != (UBYTE)mask[m]) {
+                    break;
+                }
+            }
+            if (m < entry->maskLen) {
+                continue;
+            }
+            
+            if (!best || entry->priority > best->priority
+                || (entry->priority == best->priority && entry->maskLen > best->maskLen)) {
+                best = entry;
+                tie = FALSE;
+            } else if (entry->priority == best->priority && entry->maskLen == best->maskLen
+                       && entry->groupID != best->groupID) {
+                tie = TRUE;
+            }
+        }
+    }
+    
+    if (best) {
+        if (tie || opaquePriority >= best->priority) {
+            return FALSE;
+        }
+        *groupOut = best->groupID;
+        return TRUE;
+    }
+    
+    /* Nothing can match - datatypes.library falls back to its built-in */
+    /* ascii or binary type; IFF files are left to the library */
+    if (opaquePriority < -32768 && fileType != DTF_IFF) {
+        *groupOut = (fileType == DTF_ASCII) ? GID_TEXT : GID_SYSTEM;
+        return TRUE;
+    }
+    
+    return FALSE;
+}
+
+/* Note what was decided for the current item (RESOLVE) */
+/* NULL arguments leave the corresponding field alone */
+VOID SetResolution(const char *kind, STRPTR tool, const char *method, const char *stage)
+{
+    if (kind) {
+        g_resolution.kind = kind;
+    }
+    if (tool) {
+        Strncpy(g_resolution.tool, tool, sizeof(g_resolution.tool));
+    }
+    if (method) {
+        g_resolution.method = method;
+    }
+    if (stage) {
+        g_resolution.stage = stage;
+    }
+}
+
+/* Name of a datatypes group */
+const char *GetGroupName(ULONG groupID)
+{
+    LONG i;
+    
+    for (i = 0; groupNames[i].name != NULL; i++) {
+        if (groupNames[i].groupID == groupID) {
+            return groupNames[i].name;
+        }
+    }
+    
+    return NULL;
+}
+
+/* Print the RESOLVE record for the current item and start afresh */
+/* Fields are tab separated: name, kind, type, group, tool, method, stage; */
+/* unknown fields are given as "-" */
+VOID ReportResolution(STRPTR fileName, BPTR fileLock)
+{
+    const char *kind = g_resolution.kind ? g_resolution.kind : "data";
+    const char *method = g_resolution.method ? g_resolution.method : "none";
+    const char *stage = g_resolution.stage ? g_resolution.stage : "none";
+    const char *group = NULL;
+    STRPTR type = g_resolution.type[0] ? g_resolution.type : (STRPTR)"-";
+    STRPTR tool = g_resolution.tool[0] ? g_resolution.tool : (STRPTR)"-";
+    
+    /* Data files get their datatypes group, where identification is allowed */
+    if (Stricmp((STRPTR)kind, "drawer") != 0 && (g_item.groupValid || IdentifyAllowed())) {
+        group = GetGroupName(GetItemGroup(fileName, fileLock));
+    }
+    if (!group) {
+        group = "-";
+    }
+    
+    Printf("%s\t%s\t%s\t%s\t%s\t%s\t%s\n", fileName, kind, type, group, tool, method, stage);
+    
+    /* SETVAR: the last record is also kept in local variables */
+    if (g_resolveVars) {
+        SetVar((STRPTR)"OpenKind", (STRPTR)kind, -1, GVF_LOCAL_ONLY);
+        SetVar((STRPTR)"OpenType", type, -1, GVF_LOCAL_ONLY);
+        SetVar((STRPTR)"OpenGroup", (STRPTR)group, -1, GVF_LOCAL_ONLY);
+        SetVar((STRPTR)"OpenTool", tool, -1, GVF_LOCAL_ONLY);
+        SetVar((STRPTR)"OpenMethod", (STRPTR)method, -1, GVF_LOCAL_ONLY);
+        SetVar((STRPTR)"OpenStage", (STRPTR)stage, -1, GVF_LOCAL_ONLY);
+    }
+    
+    memset(&g_resolution, 0, sizeof(g_resolution));
+}
+
+/* Open timer.device for EClock reads (STATS, TRACE, $Open/Monitor) */
+BOOL InitStats(VOID)
+{
+    LONG i;
+    
+    g_timerPort = CreateMsgPort();
+    if (!g_timerPort) {
+        return FALSE;
+    }
+    
+    g_timerIO = (struct timerequest *)CreateIORequest(g_timerPort, sizeof(struct timerequest));
+    if (!g_timerIO) {
+        FreeStats();
+        return FALSE;
+    }
+    
+    if (OpenDevice((STRPTR)TIMERNAME, UNIT_ECLOCK, (struct IORequest *)g_timerIO, 0) != 0) {
+        DeleteIORequest(g_timerIO);
+        g_timerIO = NULL;
+        FreeStats();
+        return FALSE;
+    }
+    
+    TimerBase = g_timerIO->tr_node.io_Device;
+    g_eclockFreq = ReadEClock(&g_statsBegin);
+    
+    for (i = 0; i < STAT_COUNT; i++) {
+        g_statTimes[i].min = 0xFFFFFFFF;
+    }
+    g_itemTimes.min = 0xFFFFFFFF;
+    
+    return TRUE;
+}
+
+/* Close timer.device */
+VOID FreeStats(VOID)
+{
+    if (g_timerIO) {
+        if (TimerBase) {
+            CloseDevice((struct IORequest *)g_timerIO);
+            TimerBase = NULL;
+        }
+        DeleteIORequest(g_timerIO);
+        g_timerIO = NULL;
+    }
+    
+    if (g_timerPort) {
+        DeleteMsgPort(g_timerPort);
+        g_timerPort = NULL;
+    }
+}
+
+/* Start timing a stage */
+VOID StatBegin(UWORD stage)
+{
+    if (!TimerBase) {
+        return;
+    }
+    
+    ReadEClock(&g_statStart[stage]);
+    TraceAdd(stage, 'B', &g_statStart[stage]);
+}
+
+/* Stop timing a stage and add the time to the item and the run */
+VOID StatEnd(UWORD stage)
+{
+    struct EClockVal now;
+    ULONG micros;
+    
+    if (!TimerBase) {
+        return;
+    }
+    
+    ReadEClock(&now);
+    TraceAdd(stage, 'E', &now);
+    
+    if (g_timingEnabled) {
+        micros = EClockMicros(&g_statStart[stage], &now);
+        g_itemMicros[stage] += micros;
+        AddTiming(&g_statTimes[stage], micros);
+        UsageSample(stage, micros);
+    }
+}
+
+/* EClock interval in microseconds, 0xFFFFFFFF if it does not fit */
+ULONG EClockMicros(struct EClockVal *from, struct EClockVal *to)
+{
+    ULONG ticks = to->ev_lo - from->ev_lo;
+    ULONG carry = (to->ev_lo < from->ev_lo) ? 1 : 0;
+    ULONG seconds;
+    
+    if (to->ev_hi - from->ev_hi != carry) {
+        return 0xFFFFFFFF;
+    }
+    
+    /* Whole seconds and the rest separately to stay within 32 bits */
+    seconds = ticks / g_eclockFreq;
+    if (seconds >= 4294) {
+        return 0xFFFFFFFF;
+    }
+    
+    return seconds * 1000000 + ((ticks % g_eclockFreq) * 1000) / (g_eclockFreq / 1000);
+}
+
+/* Count a call to an expensive API */
+VOID StatCount(UWORD counter)
+{
+    g_apiCounts[counter]++;
+    g_itemCounts[counter]++;
+}
+
+/* Add one measurement to a timing */
+VOID AddTiming(struct StatTiming *timing, ULONG micros)
+{
+    timing->calls++;
+    timing->total += micros;
+    if (micros < timing->min) {
+        timing->min = micros;
+    }
+    if (micros > timing->max) {
+        timing->max = micros;
+    }
+}
+
+/* Print the stage times of the item just finished and add them to the run */
+VOID ItemStats(STRPTR fileName)
+{
+    BPTR statsOutput = MessageOutput();
+    ULONG total = 0;
+    LONG i;
+    
+    if (g_traceItem != 0) {
+        TraceMark(TRACE_ITEM, 'E');
+        g_traceItem = 0;
+    }
+    
+    if (!g_timingEnabled) {
+        return;
+    }
+    
+    if (g_statsEnabled) {
+        FPrintf(statsOutput, "Stats: %s:", fileName);
+    }
+    for (i = 0; i < STAT_COUNT; i++) {
+        if (g_benchSamples) {
+            g_benchSamples[i * g_benchCount + g_benchIteration] = g_itemMicros[i];
+        }
+        if (g_itemMicros[i] != 0) {
+            if (g_statsEnabled) {
+                FPrintf(statsOutput, " %s %lu.%03lu", statNames[i], g_itemMicros[i] / 1000, g_itemMicros[i] % 1000);
+            }
+            total += g_itemMicros[i];
+        }
+        g_itemMicros[i] = 0;
+    }
+    if (g_statsEnabled) {
+        FPrintf(statsOutput, " total %lu.%03lu ms\n", total / 1000, total % 1000);
+        
+        /* The calls this item made */
+        FPrintf(statsOutput, "Stats: %s: calls", fileName);
+        for (i = 0; i < COUNT_COUNT; i++) {
+            if (g_itemCounts[i] != 0) {
+                FPrintf(statsOutput, " %s %lu", countNames[i], g_itemCounts[i]);
+            }
+        }
+        FPrintf(statsOutput, "\n");
+    }
+    
+    if (g_benchSamples) {
+        g_benchSamples[BENCH_ITEM * g_benchCount + g_benchIteration] = total;
+    }
+    
+    AddTiming(&g_itemTimes, total);
+    UsageSample(USAGE_ITEM, total);
+}
+
+/* Print the STATS totals for the run */
+VOID PrintStats(VOID)
+{
+    BPTR statsOutput = MessageOutput();
+    struct EClockVal now;
+    ULONG millis;
+    ULONG rate;
+    ULONG avg;
+    LONG i;
+    
+    FPrintf(statsOutput, "\nStats: stage        calls    total ms      min ms      avg ms      max ms\n");
+    for (i = 0; i < STAT_COUNT; i++) {
+        struct StatTiming *timing = &g_statTimes[i];
+        
+        if (timing->calls == 0) {
+            FPrintf(statsOutput, "Stats: %-10s %7lu\n", statNames[i], 0L);
+            continue;
+        }
+        avg = timing->total / timing->calls;
+        FPrintf(statsOutput, "Stats: %-10s %7lu %7lu.%03lu %7lu.%03lu %7lu.%03lu %7lu.%03lu\n", statNames[i], timing->calls,
+                timing->total / 1000, timing->total % 1000, timing->min / 1000, timing->min % 1000,
+                avg / 1000, avg % 1000, timing->max / 1000, timing->max % 1000);
+    }
+    
+    if (g_itemTimes.calls != 0) {
+        avg = g_itemTimes.total / g_itemTimes.calls;
+        FPrintf(statsOutput, "Stats: %-10s %7lu %7lu.%03lu %7lu.%03lu %7lu.%03lu %7lu.%03lu\n", "per item", g_itemTimes.calls,
+                g_itemTimes.total / 1000, g_itemTimes.total % 1000, g_itemTimes.min / 1000, g_itemTimes.min % 1000,
+                avg / 1000, avg % 1000, g_itemTimes.max / 1000, g_itemTimes.max % 1000);
+    }
+    
+    for (i = 0; i < COUNT_COUNT; i++) {
+        FPrintf(statsOutput, "Stats: %-20s %6lu calls\n", countNames[i], g_apiCounts[i]);
+    }
+    
+    /* Throughput over the whole run, start-up included */
+    ReadEClock(&now);
+    millis = EClockMicros(&g_statsBegin, &now) / 1000;
+    if (millis != 0 && g_itemTimes.calls < 400000) {
+        rate = (g_itemTimes.calls * 10000) / millis;
+        FPrintf(statsOutput, "Stats: %lu items in %lu.%03lu s, %lu.%lu items/s\n", g_itemTimes.calls,
+                millis / 1000, millis % 1000, rate / 10, rate % 10);
+    }
+}
+
+/* Check $Open/Monitor - anything but "0" or "OFF" turns monitoring on */
+BOOL GetMonitorFromEnv(VOID)
+{
+    UBYTE varBuffer[16];
+    
+    if (GetVar((STRPTR)"Open/Monitor", varBuffer, sizeof(varBuffer), 0) < 0) {
+        return FALSE;
+    }
+    
+    return (BOOL)(Stricmp(varBuffer, (STRPTR)"0") != 0 && Stricmp(varBuffer, (STRPTR)"OFF") != 0);
+}
+
+/* Add one measurement to this run's usage histogram */
+VOID UsageSample(UWORD timing, ULONG micros)
+{
+    ULONG value = micros >> 5;
+    UWORD bucket = 0;
+    
+    if (!g_usageEnabled) {
+        return;
+    }
+    
+    while (value != 0 && bucket < USAGE_BUCKETS - 1) {
+        value >>= 1;
+        bucket++;
+    }
+    
+    g_usageRun[timing].calls++;
+    g_usageRun[timing].buckets[bucket]++;
+    g_usageMicros[timing] += micros;
+}
+
+/* Read ENVARC:Open/Usage, FALSE if missing or of another layout */
+BOOL ReadUsage(struct UsageFile *usage)
+{
+    BPTR usageFile;
+    LONG bytes;
+    
+    usageFile = Open((STRPTR)USAGE_FILE, MODE_OLDFILE);
+    if (!usageFile) {
+        return FALSE;
+    }
+    
+    bytes = Read(usageFile, usage, sizeof(struct UsageFile));
+    Close(usageFile);
+    
+    return (BOOL)(bytes == sizeof(struct UsageFile) && usage->magic == USAGE_MAGIC
+                  && usage->version == USAGE_VERSION && usage->timings == USAGE_TIMINGS
+                  && usage->buckets == USAGE_BUCKETS && usage->counts == COUNT_COUNT);
+}
+
+/* Add this run to ENVARC:Open/Usage - one read and one write per run */
+VOID SaveUsage(VOID)
+{
+    struct UsageFile *usage;
+    struct UsageTiming *timing;
+    BPTR usageFile;
+    LONG i;
+    LONG j;
+    
+    if (!g_usageEnabled || g_benchCount != 0 || g_usageRun[USAGE_ITEM].calls == 0) {
+        return;
+    }
+    
+    usage = (struct UsageFile *)AllocVec(sizeof(struct UsageFile), MEMF_CLEAR);
+    if (!usage) {
+        return;
+    }
+    
+    if (!ReadUsage(usage)) {
+        /* First run, or an older layout - start again */
+        memset(usage, 0, sizeof(struct UsageFile));
+        usage->magic = USAGE_MAGIC;
+        usage->version = USAGE_VERSION;
+        usage->timings = USAGE_TIMINGS;
+        usage->buckets = USAGE_BUCKETS;
+        usage->counts = COUNT_COUNT;
+        DateStamp(&usage->first);
+    }
+    
+    usage->runs++;
+    DateStamp(&usage->last);
+    
+    for (i = 0; i < USAGE_TIMINGS; i++) {
+        timing = &usage->timing[i];
+        timing->calls += g_usageRun[i].calls;
+        timing->millis += g_usageMicros[i] / 1000;
+        for (j = 0; j < USAGE_BUCKETS; j++) {
+            timing->buckets[j] += g_usageRun[i].buckets[j];
+        }
+    }
+    for (i = 0; i < COUNT_COUNT; i++) {
+        usage->count[i] += g_apiCounts[i];
+    }
+    
+    usageFile = OpenNewEnvFile((STRPTR)USAGE_FILE);
+    if (usageFile) {
+        Write(usageFile, usage, sizeof(struct UsageFile));
+        Close(usageFile);
+    }
+    
+    FreeVec(usage);
+}
+
+/* REPORT - print the aggregates in ENVARC:Open/Usage */
+LONG PrintUsageReport(VOID)
+{
+    struct UsageFile *usage;
+    struct UsageTiming *timing;
+    struct DateTime dateTime;
+    UBYTE dateBuffer[LEN_DATSTRING];
+    UBYTE timeBuffer[LEN_DATSTRING];
+    ULONG avg;
+    LONG i;
+    LONG j;
+    
+    usage = (struct UsageFile *)AllocVec(sizeof(struct UsageFile), MEMF_CLEAR);
+    if (!usage) {
+        PrintError(ERROR_NO_FREE_STORE);
+        return RETURN_FAIL;
+    }
+    
+    if (!ReadUsage(usage)) {
+        Printf("Open: No usage recorded in %s (set $Open/Monitor to record)\n", (LONG)USAGE_FILE);
+        FreeVec(usage);
+        return RETURN_WARN;
+    }
+    
+    memset(&dateTime, 0, sizeof(dateTime));
+    dateTime.dat_Format = FORMAT_DOS;
+    dateTime.dat_StrDate = dateBuffer;
+    dateTime.dat_StrTime = timeBuffer;
+    dateTime.dat_Stamp = usage->first;
+    DateToStr(&dateTime);
+    Printf("Usage: %lu runs from %s %s", usage->runs, dateBuffer, timeBuffer);
+    dateTime.dat_Stamp = usage->last;
+    DateToStr(&dateTime);
+    Printf(" to %s %s\n", dateBuffer, timeBuffer);
+    
+    for (i = 0; i < USAGE_TIMINGS; i++) {
+        timing = &usage->timing[i];
+        /* Average in microseconds, coarser once the total gets large */
+        if (timing->calls == 0) {
+            avg = 0;
+        } else if (timing->millis < 4000000) {
+            avg = (timing->millis * 1000) / timing->calls;
+        } else {
+            avg = (timing->millis / timing->calls) * 1000;
+        }
+        Printf("Usage: %-10s %8lu calls  avg %lu.%03lu ms\n", (i == USAGE_ITEM) ? "item" : statNames[i],
+               timing->calls, avg / 1000, avg % 1000);
+        for (j = 0; j < USAGE_BUCKETS; j++) {
+            if (timing->buckets[j] != 0) {
+                Printf("Usage:     %-8s %8lu  %3lu%%\n", bucketNames[j], timing->buckets[j],
+                       (timing->buckets[j] * 100) / timing->calls);
+            }
+        }
+    }
+    
+    for (i = 0; i < COUNT_COUNT; i++) {
+        Printf("Usage: %-20s %8lu calls\n", countNames[i], usage->count[i]);
+    }
+    
+    FreeVec(usage);
+    return RETURN_OK;
+}
+
+/* Open the TRACE file and allocate the event ring */
+BOOL InitTrace(STRPTR traceName)
+{
+    g_traceFile = Open(traceName, MODE_NEWFILE);
+    if (!g_traceFile) {
+        return FALSE;
+    }
+    
+    g_traceEvents = (struct TraceEvent *)AllocVec(TRACE_EVENTS * sizeof(struct TraceEvent), MEMF_ANY);
+    g_traceItemNames = (char *)AllocVec(TRACE_NAMES, MEMF_ANY);
+    g_traceNameSlots = (struct TraceName *)AllocVec(TRACE_ITEMS * sizeof(struct TraceName), MEMF_CLEAR);
+    if (!g_traceEvents || !g_traceItemNames || !g_traceNameSlots) {
+        FreeTrace();
+        SetIoErr(ERROR_NO_FREE_STORE);
+        return FALSE;
+    }
+    
+    ReadEClock(&g_traceStart);
+    return TRUE;
+}
+
+/* Write the TRACE log and free the ring */
+VOID FreeTrace(VOID)
+{
+    struct TraceEvent *event;
+    struct TraceName *slot;
+    ULONG first;
+    ULONG firstItem = 0;
+    ULONG i;
+    ULONG item;
+    
+    if (g_traceFile && g_traceEvents && g_traceItemNames && g_traceNameSlots) {
+        first = (g_traceCount > TRACE_EVENTS) ? g_traceCount - TRACE_EVENTS : 0;
+        
+        FPrintf(g_traceFile, "# Open trace, times in microseconds\n");
+        FPrintf(g_traceFile, "# N <item> <name>\n");
+        FPrintf(g_traceFile, "# <time> <B|E> <stage> <item>\n");
+        if (first != 0) {
+            FPrintf(g_traceFile, "# dropped %lu oldest events\n", first);
+        }
+        
+        /* Name the items the kept events refer to, if their names are still there */
+        for (i = first; i < g_traceCount && firstItem == 0; i++) {
+            firstItem = g_traceEvents[i % TRACE_EVENTS].item;
+        }
+        for (item = firstItem; item != 0 && item <= g_traceItems; item++) {
+            slot = &g_traceNameSlots[item % TRACE_ITEMS];
+            if (slot->item == item && g_traceNamesUsed - slot->at <= TRACE_NAMES) {
+                FPrintf(g_traceFile, "N %lu %s\n", item, g_traceItemNames + slot->at % TRACE_NAMES);
+            }
+        }
+        
+        for (i = first; i < g_traceCount; i++) {
+            event = &g_traceEvents[i % TRACE_EVENTS];
+            FPrintf(g_traceFile, "%lu %lc %s %lu\n", event->micros, (LONG)event->phase,
+                    traceNames[event->kind], event->item);
+        }
+    }
+    
+    if (g_traceFile) {
+        Close(g_traceFile);
+        g_traceFile = NULL;
+    }
+    if (g_traceEvents) {
+        FreeVec(g_traceEvents);
+        g_traceEvents = NULL;
+    }
+    if (g_traceItemNames) {
+        FreeVec(g_traceItemNames);
+        g_traceItemNames = NULL;
+    }
+    if (g_traceNameSlots) {
+        FreeVec(g_traceNameSlots);
+        g_traceNameSlots = NULL;
+    }
+}
+
+/* Start an item - clear its call counts, mark it in the trace and keep its name */
+VOID ItemBegin(STRPTR fileName)
+{
+    struct TraceName *slot;
+    ULONG nameLen;
+    ULONG room;
+    
+    memset(g_itemCounts, 0, sizeof(g_itemCounts));
+    
+    if (!g_traceEvents) {
+        return;
+    }
+    
+    g_traceItem = ++g_traceItems;
+    
+    /* Names go round the ring like the events do - a name never wraps, */
+    /* one that does not fit before the end starts again at the front */
+    slot = &g_traceNameSlots[g_traceItem % TRACE_ITEMS];
+    slot->item = 0;
+    nameLen = strlen(fileName) + 1;
+    if (nameLen <= TRACE_NAME_MAX) {
+        room = TRACE_NAMES - g_traceNamesUsed % TRACE_NAMES;
+        if (nameLen > room) {
+            g_traceNamesUsed += room;
+        }
+        memcpy(g_traceItemNames + g_traceNamesUsed % TRACE_NAMES, fileName, nameLen);
+        slot->item = g_traceItem;
+        slot->at = g_traceNamesUsed;
+        g_traceNamesUsed += nameLen;
+    }
+    
+    TraceMark(TRACE_ITEM, 'B');
+}
+
+/* Add an event stamped now */
+VOID TraceMark(UWORD kind, UBYTE phase)
+{
+    struct EClockVal now;
+    
+    if (!g_traceEvents) {
+        return;
+    }
+    
+    ReadEClock(&now);
+    TraceAdd(kind, phase, &now);
+}
+
+/* Add an event to the ring - no I/O until the log is written at exit */
+VOID TraceAdd(UWORD kind, UBYTE phase, struct EClockVal *when)
+{
+    struct TraceEvent *event;
+    
+    if (!g_traceEvents) {
+        return;
+    }
+    
+    event = &g_traceEvents[g_traceCount % TRACE_EVENTS];
+    event->micros = EClockMicros(&g_traceStart, when);
+    event->item = g_traceItem;
+    event->kind = (UBYTE)kind;
+    event->phase = phase;
+    g_traceCount++;
+}
+
+/* Check that the volume an argument lives on can be reached (BATCH mode) */
+/* Each distinct device, volume or assign name is checked only once; the */
+/* failure is reported for every argument that refers to it */
+BOOL IsVolumeAvailable(STRPTR fileName, BOOL report)
+{
+    struct VolumeCheck *check = NULL;
+    STRPTR colon = NULL;
+    LONG nameLen = 0;
+    LONG i;
+    
+    if (!fileName) {
+        return FALSE;
+    }
+    
+    /* Relative names live on the current directory's volume, which is there */
+    colon = strchr(fileName, ':');
+    if (!colon) {
+        return TRUE;
+    }
+    
+    nameLen = colon - fileName + 1;
+    if (nameLen >= (LONG)sizeof(check->name)) {
+        return TRUE;
+    }
+    
+    for (i = 0; i < g_volumeCheckCount; i++) {
+        if ((LONG)strlen(g_volumeChecks[i].name) == nameLen &&
+            Strnicmp(g_volumeChecks[i].name, fileName, nameLen) == 0) {
+            check = &g_volumeChecks[i];
+            break;
+        }
+    }
+    
+    if (!check) {
+        /* Table full - recycle the last slot */
+        if (g_volumeCheckCount < MAX_VOLUME_CHECKS) {
+            check = &g_volumeChecks[g_volumeCheckCount++];
+        } else {
+            check = &g_volumeChecks[MAX_VOLUME_CHECKS - 1];
+        }
+        
+        Strncpy(check->name, fileName, nameLen + 1);
+        check->errorCode = 0;
+        TraceMark(TRACE_VOLUME, 'B');
+        check->available = CheckVolume(check->name, &check->errorCode);
+        TraceMark(TRACE_VOLUME, 'E');
+    }
+    
+    if (!check->available && report) {
+        FPrintf(MessageOutput(), "Open: Volume %s is not available for: %s\n", check->name, fileName);
+        PrintError(check->errorCode ? check->errorCode : ERROR_DEVICE_NOT_MOUNTED);
+    }
+    if (!check->available) {
+        SetIoErr(check->errorCode ? check->errorCode : ERROR_DEVICE_NOT_MOUNTED);
+    }
+    
+    return check->available;
+}
+
+/* Check a single device, volume or assign name */
+/* Must be called with pr_WindowPtr set to -1 so no requester can appear */
+BOOL CheckVolume(STRPTR volumeName, LONG *errorOut)
+{
+    struct DevProc *dvp = NULL;
+    struct InfoData *info = NULL;
+    BPTR volumeLock = NULL;
+    BOOL available = FALSE;
+    
+    /* Is the name known at all? */
+    dvp = GetDeviceProc(volumeName, NULL);
+    if (!dvp) {
+        *errorOut = IoErr();
+        return FALSE;
+    }
+    FreeDeviceProc(dvp);
+    
+    /* Is there a disk we can read? */
+    StatCount(COUNT_LOCK);
+    volumeLock = Lock(volumeName, ACCESS_READ);
+    if (!volumeLock) {
+        *errorOut = IoErr();
+        return FALSE;
+    }
+    
+    info = (struct InfoData *)AllocVec(sizeof(struct InfoData), MEMF_CLEAR);
+    if (info) {
+        if (Info(volumeLock, info)) {
+            if (info->id_DiskType == ID_NO_DISK_PRESENT) {
+                *errorOut = ERROR_NO_DISK;
+            } else if (info->id_DiskType == ID_UNREADABLE_DISK ||
+                       info->id_DiskType == ID_NOT_REALLY_DOS ||
+                       info->id_DiskType == ID_KICKSTART_DISK) {
+                *errorOut = ERROR_NOT_A_DOS_DISK;
+            } else {
+                available = TRUE;
+            }
+        } else {
+            /* Some handlers don't support Info() - the Lock() is good enough */
+            available = TRUE;
+        }
+        FreeVec(info);
+    } else {
+        available = TRUE;
+    }
+    
+    UnLock(volumeLock);
+    
+    return available;
+}
+
+/* Read the start of the current item into the shared header buffer */
+/* The header is read once per item and reused by every check that needs it */
+BOOL ReadItemHeader(STRPTR fileName)
+{
+    BPTR fileHandle = NULL;
+    LONG bytesRead = 0;
+    
+    if (g_item.headerValid) {
+        return (BOOL)(g_item.headerLen > 0);
+    }
+    
+    if (!fileName || !HeaderAllowed()) {
+        return FALSE;
+    }
+    
+    if (TakeReadAhead(g_item.header, &bytesRead)) {
+        /* Already read in the background */
+        StatCount(COUNT_READ);
+    } else {
+        fileHandle = Open(fileName, MODE_OLDFILE);
+        if (fileHandle) {
+            StatCount(COUNT_READ);
+            bytesRead = Read(fileHandle, g_item.header, ITEM_HEADER_SIZE);
+            Close(fileHandle);
+        }
+    }
+    
+    g_item.headerValid = TRUE;
+    g_item.headerLen = bytesRead > 0 ? bytesRead : 0;
+    
+    return (BOOL)(g_item.headerLen > 0);
+}
+
+/* Start reading a coming item's header in the background */
+/* dirLock is the directory the name will be opened from, NULL for the current one */
+VOID ReadAhead(BPTR dirLock, STRPTR fileName)
+{
+    STRPTR tool;
+    UWORD verb;
+    BOOL all;
+    LONG cut = 0;
+    UBYTE saved = 0;
+    
+    /* Command line names are claimed without their qualifiers, see OpenArgument() */
+    /* A name that only looks qualified is read ahead under the wrong name and */
+    /* dropped unclaimed, which is cheaper than a Lock() per name and look */
+    if (!dirLock && fileName != NULL) {
+        cut = ParseQualifiers(fileName, FALSE, &tool, &verb, &all);
+        if (cut > 0) {
+            saved = fileName[cut];
+            fileName[cut] = '\0';
+        }
+    }
+    
+    StartReadAhead(dirLock, fileName);
+    
+    if (cut > 0) {
+        fileName[cut] = saved;
+    }
+}
+
+/* Send ACTION_FINDINPUT for a name, if a slot is free and it is worth it */
+VOID StartReadAhead(BPTR dirLock, STRPTR fileName)
+{
+    struct Process *process = (struct Process *)FindTask(NULL);
+    struct ReadAhead *slot = NULL;
+    struct MsgPort *handler = NULL;
+    struct DevProc *dvp = NULL;
+    struct DosPacket *dp;
+    BPTR packetLock = NULL;
+    LONG length;
+    LONG i;
+    
+    /* BENCH times each item on its own, FAST reads no headers at all */
+    if (g_benchCount || g_forceFast || !fileName) {
+        return;
+    }
+    length = strlen(fileName);
+    if (length == 0 || length >= sizeof(slot->name)) {
+        return;
+    }
+    if (!dirLock) {
+        dirLock = process->pr_CurrentDir;
+    }
+    
+    /* Finished slots can only be reused once their replies are in */
+    PollReadAhead();
+    
+    for (i = 0; i < READAHEAD_DEPTH; i++) {
+        struct ReadAhead *other = &g_readAhead[i];
+        
+        if (other->state == RA_FREE) {
+            if (slot == NULL) {
+                slot = other;
+            }
+        } else if (!other->discard && other->dirLock == dirLock && strcmp(other->name, fileName) == 0) {
+            /* Already on its way */
+            return;
+        }
+    }
+    if (slot == NULL) {
+        return;
+    }
+    
+    if (g_readAheadPort == NULL) {
+        g_readAheadPort = CreateMsgPort();
+        if (g_readAheadPort == NULL) {
+            return;
+        }
+    }
+    if (slot->packet == NULL) {
+        slot->packet = (struct StandardPacket *)AllocDosObject(DOS_STDPKT, NULL);
+        if (slot->packet == NULL) {
+            return;
+        }
+    }
+    
+    /* Find the handler the way Open() would, but never put up a requester */
+    /* dvp_Lock of a non-binding assign is freed with the DevProc, so the */
+    /* DevProc is kept until the handler has answered ACTION_FINDINPUT */
+    if (strchr(fileName, ':') != NULL) {
+        APTR oldWindowPtr = process->pr_WindowPtr;
+        
+        process->pr_WindowPtr = (APTR)-1L;
+        dvp = GetDeviceProc(fileName, NULL);
+        process->pr_WindowPtr = oldWindowPtr;
+        if (dvp == NULL) {
+            return;
+        }
+        handler = dvp->dvp_Port;
+        packetLock = dvp->dvp_Lock;
+    } else {
+        handler = dirLock ? ((struct FileLock *)BADDR(dirLock))->fl_Task : GetFileSysTask();
+        packetLock = dirLock;
+    }
+    
+    /* Nothing to gain on volumes that are identified by name only */
+    if (handler == NULL || GetItemTier(handler) == TIER_FAST) {
+        if (dvp) {
+            FreeDeviceProc(dvp);
+        }
+        return;
+    }
+    
+    slot->handle = (struct FileHandle *)AllocDosObject(DOS_FILEHANDLE, NULL);
+    slot->bname = AllocVec(length + 1, MEMF_ANY);
+    if (slot->handle == NULL || slot->bname == NULL) {
+        if (slot->handle) {
+            FreeDosObject(DOS_FILEHANDLE, slot->handle);
+            slot->handle = NULL;
+        }
+        if (slot->bname) {
+            FreeVec(slot->bname);
+            slot->bname = NULL;
+        }
+        if (dvp) {
+            FreeDeviceProc(dvp);
+        }
+        return;
+    }
+    slot->bname[0] = (UBYTE)length;
+    memcpy(slot->bname + 1, fileName, length);
+    strcpy(slot->name, fileName);
+    
+    slot->dirLock = dirLock;
+    slot->handler = handler;
+    slot->devProc = dvp;
+    slot->length = -1;
+    slot->discard = FALSE;
+    slot->sequence = ++g_readAheadSequence;
+    slot->state = RA_OPENING;
+    
+    dp = &slot->packet->sp_Pkt;
+    dp->dp_Type = ACTION_FINDINPUT;
+    dp->dp_Arg1 = MKBADDR(slot->handle);
+    dp->dp_Arg2 = (LONG)packetLock;
+    dp->dp_Arg3 = MKBADDR(slot->bname);
+    SendPkt(dp, handler, g_readAheadPort);
+}
+
+/* Make the slot read ahead for this item the current one, and give up on */
+/* any started before it - their items have been skipped */
+VOID ClaimReadAhead(STRPTR fileName)
+{
+    BPTR dirLock;
+    LONG i;
+    
+    DropReadAhead();
+    if (g_readAheadPort == NULL) {
+        return;
+    }
+    PollReadAhead();
+    
+    dirLock = ((struct Process *)FindTask(NULL))->pr_CurrentDir;
+    for (i = 0; i < READAHEAD_DEPTH; i++) {
+        struct ReadAhead *slot = &g_readAhead[i];
+        
+        if (slot->state != RA_FREE && !slot->discard &&
+            slot->dirLock == dirLock && strcmp(slot->name, fileName) == 0) {
+            g_readAheadCurrent = i;
+            break;
+        }
+    }
+    if (g_readAheadCurrent < 0) {
+        return;
+    }
+    
+    for (i = 0; i < READAHEAD_DEPTH; i++) {
+        struct ReadAhead *slot = &g_readAhead[i];
+        
+        if (slot->state != RA_FREE && slot->sequence < g_readAhead[g_readAheadCurrent].sequence) {
+            DropReadAheadSlot(slot);
+        }
+    }
+}
+
+/* Copy the current item's header if it was read ahead */
+/* Returns FALSE if it wasn't, or could not be - then it is read as usual */
+BOOL TakeReadAhead(UBYTE *buffer, LONG *lengthOut)
+{
+    struct ReadAhead *slot;
+    BOOL taken = FALSE;
+    
+    if (g_readAheadCurrent < 0) {
+        return FALSE;
+    }
+    slot = &g_readAhead[g_readAheadCurrent];
+    
+    /* Usually already in - otherwise this is no slower than reading it now */
+    while (slot->state == RA_OPENING || slot->state == RA_READING) {
+        WaitPort(g_readAheadPort);
+        PollReadAhead();
+    }
+    
+    if (slot->length >= 0) {
+        memcpy(buffer, slot->header, slot->length);
+        *lengthOut = slot->length;
+        taken = TRUE;
+    }
+    DropReadAhead();
+    
+    return taken;
+}
+
+/* Let go of the current item's slot */
+VOID DropReadAhead(VOID)
+{
+    if (g_readAheadCurrent >= 0) {
+        DropReadAheadSlot(&g_readAhead[g_readAheadCurrent]);
+        g_readAheadCurrent = -1;
+    }
+}
+
+/* Free a slot now, or once its packets are back */
+VOID DropReadAheadSlot(struct ReadAhead *slot)
+{
+    slot->discard = TRUE;
+    if (slot->state == RA_READY) {
+        slot->state = RA_FREE;
+    }
+}
+
+/* Move every slot whose packet has come back on to its next step */
+VOID PollReadAhead(VOID)
+{
+    struct Message *msg;
+    LONG i;
+    
+    if (g_readAheadPort == NULL) {
+        return;
+    }
+    
+    while ((msg = GetMsg(g_readAheadPort)) != NULL) {
+        struct DosPacket *dp = (struct DosPacket *)msg->mn_Node.ln_Name;
+        
+        for (i = 0; i < READAHEAD_DEPTH; i++) {
+            if (g_readAhead[i].packet != NULL && &g_readAhead[i].packet->sp_Pkt == dp) {
+                ReadAheadReply(&g_readAhead[i]);
+                break;
+            }
+        }
+    }
+}
+
+/* A slot's packet has been replied - open, then read, then close */
+VOID ReadAheadReply(struct ReadAhead *slot)
+{
+    struct DosPacket *dp = &slot->packet->sp_Pkt;
+    
+    switch (slot->state) {
+        case RA_OPENING:
+            FreeVec(slot->bname);
+            slot->bname = NULL;
+            if (slot->devProc) {
+                FreeDeviceProc(slot->devProc);
+                slot->devProc = NULL;
+            }
+            if (dp->dp_Res1 == DOSFALSE) {
+                /* Not there, a drawer, ... - the item finds out for itself */
+                FreeDosObject(DOS_FILEHANDLE, slot->handle);
+                slot->handle = NULL;
+                slot->state = slot->discard ? RA_FREE : RA_READY;
+                return;
+            }
+            if (slot->discard) {
+                dp->dp_Type = ACTION_END;
+                dp->dp_Arg1 = slot->handle->fh_Arg1;
+                slot->state = RA_CLOSING;
+            } else {
+                dp->dp_Type = ACTION_READ;
+                dp->dp_Arg1 = slot->handle->fh_Arg1;
+                dp->dp_Arg2 = (LONG)slot->header;
+                dp->dp_Arg3 = ITEM_HEADER_SIZE;
+                slot->state = RA_READING;
+            }
+            SendPkt(dp, slot->handler, g_readAheadPort);
+            break;
+            
+        case RA_READING:
+            slot->length = dp->dp_Res1;
+            dp->dp_Type = ACTION_END;
+            dp->dp_Arg1 = slot->handle->fh_Arg1;
+            slot->state = RA_CLOSING;
+            SendPkt(dp, slot->handler, g_readAheadPort);
+            break;
+            
+        case RA_CLOSING:
+            FreeDosObject(DOS_FILEHANDLE, slot->handle);
+            slot->handle = NULL;
+            slot->state = slot->discard ? RA_FREE : RA_READY;
+            break;
+    }
+}
+
+/* Wait for every packet still out, then free the slots */
+VOID FreeReadAhead(VOID)
+{
+    BOOL busy;
+    LONG i;
+    
+    if (g_readAheadPort == NULL) {
+        return;
+    }
+    
+    g_readAheadCurrent = -1;
+    do {
+        busy = FALSE;
+        for (i = 0; i < READAHEAD_DEPTH; i++) {
+            DropReadAheadSlot(&g_readAhead[i]);
+            if (g_readAhead[i].state != RA_FREE) {
+                busy = TRUE;
+            }
+        }
+        if (busy) {
+            WaitPort(g_readAheadPort);
+            PollReadAhead();
+        }
+    } while (busy);
+    
+    for (i = 0; i < READAHEAD_DEPTH; i++) {
+        if (g_readAhead[i].packet != NULL) {
+            FreeDosObject(DOS_STDPKT, g_readAhead[i].packet);
+            g_readAhead[i].packet = NULL;
+        }
+    }
+    DeleteMsgPort(g_readAheadPort);
+    g_readAheadPort = NULL;
+}
+
+/* Check the shared header buffer for HUNK_HEADER */
+BOOL IsHunkHeader(VOID)
+{
+    /* Amiga is big-endian, so bytes are in order: [00, 00, 03, F3] */
+    /* Note: We only check for HUNK_HEADER, not HUNK_UNIT (object files) */
+    return (BOOL)(g_item.headerValid && g_item.headerLen >= 4 &&
+                  g_item.header[0] == 0x00 && g_item.header[1] == 0x00 &&
+                  g_item.header[2] == 0x03 && g_item.header[3] == 0xF3);
+}
+
+/* Check whether the shared header buffer looks like plain text */
+BOOL IsTextHeader(VOID)
+{
+    LONG i;
+    
+    if (!g_item.headerValid || g_item.headerLen == 0) {
+        return FALSE;
+    }
+    
+    for (i = 0; i < g_item.headerLen; i++) {
+        UBYTE c = g_item.header[i];
+        
+        if (c < 0x20 && c != '\t' && c != '\n' && c != '\r' && c != '\f' && c != 0x1B) {
+            return FALSE;
+        }
+        if (c >= 0x7F && c < 0xA0) {
+            return FALSE;
+        }
+    }
+    
+    return TRUE;
+}
+
+/* Identify the current item from its header bytes (HEADER tier) */
+/* Returns a DefIcons-style type name, or NULL if the header is not recognised */
+STRPTR GetHeaderTypeIdentifier(VOID)
+{
+    UBYTE *h = g_item.header;
+    LONG len = g_item.headerLen;
+    
+    if (!g_item.headerValid || len < 4) {
+        return (len > 0 && IsTextHeader()) ? (STRPTR)"ascii" : NULL;
+    }
+    
+    if (IsHunkHeader()) {
+        return (STRPTR)"tool";
+    }
+    
+    if (len >= 12 && memcmp(h, "FORM", 4) == 0) {
+        if (memcmp(h + 8, "ILBM", 4) == 0) {
+            return (STRPTR)"ilbm";
+        } else if (memcmp(h + 8, "8SVX", 4) == 0) {
+            return (STRPTR)"8svx";
+        } else if (memcmp(h + 8, "ANIM", 4) == 0) {
+            return (STRPTR)"anim";
+        } else if (memcmp(h + 8, "FTXT", 4) == 0) {
+            return (STRPTR)"ftxt";
+        } else if (memcmp(h + 8, "AIFF", 4) == 0) {
+            return (STRPTR)"aiff";
+        }
+        return (STRPTR)"iff";
+    }
+    
+    if (memcmp(h, "GIF8", 4) == 0) {
+        return (STRPTR)"gif";
+    }
+    if (h[0] == 0xFF && h[1] == 0xD8 && h[2] == 0xFF) {
+        return (STRPTR)"jpeg";
+    }
+    if (h[0] == 0x89 && memcmp(h + 1, "PNG", 3) == 0) {
+        return (STRPTR)"png";
+    }
+    if (memcmp(h, "%PDF", 4) == 0) {
+        return (STRPTR)"pdf";
+    }
+    if (memcmp(h, "%!PS", 4) == 0) {
+        return (STRPTR)"ps";
+    }
+    if (len >= 12 && memcmp(h, "RIFF", 4) == 0 && memcmp(h + 8, "WAVE", 4) == 0) {
+        return (STRPTR)"wave";
+    }
+    if (memcmp(h, "PK\003\004", 4) == 0) {
+        return (STRPTR)"zip";
+    }
+    if (memcmp(h, "LZX", 3) == 0) {
+        return (STRPTR)"lzx";
+    }
+    if (len >= 7 && h[2] == '-' && h[3] == 'l' && h[6] == '-') {
+        return (STRPTR)"lha";
+    }
+    if (len >= 9 && Strnicmp(h, "@database", 9) == 0) {
+        return (STRPTR)"amigaguide";
+    }
+    
+    if (IsTextHeader()) {
+        return (STRPTR)"ascii";
+    }
+    
+    return NULL;
+}
+
+/* Look up the current item's name in the suffix map (FAST tier) */
+const struct SuffixType *FindSuffixType(STRPTR fileName)
+{
+    STRPTR filePart = NULL;
+    STRPTR ext = NULL;
+    LONG i;
+    
+    if (!fileName) {
+        return NULL;
+    }
+    
+    filePart = FilePart(fileName);
+    if (!filePart) {
+        return NULL;
+    }
+    
+    ext = strrchr(filePart, '.');
+    if (!ext) {
+        return NULL;
+    }
+    
+    for (i = 0; suffixTypes[i].suffix != NULL; i++) {
+        if (Stricmp(ext, (STRPTR)suffixTypes[i].suffix) == 0) {
+            return &suffixTypes[i];
+        }
+    }
+    
+    return NULL;
+}
+
+/* Identify the current item without DefIcons or datatypes.library */
+/* HEADER tier uses the header bytes, FAST tier only the file name */
+STRPTR GetQuickTypeIdentifier(STRPTR fileName)
+{
+    const struct SuffixType *suffixType = NULL;
+    
+    if (g_item.tier == TIER_HEADER && ReadItemHeader(fileName)) {
+        return GetHeaderTypeIdentifier();
+    }
+    
+    /* The header may have been skipped if the deadline passed meanwhile */
+    if (g_item.tier == TIER_HEADER) {
+        return NULL;
+    }
+    
+    suffixType = FindSuffixType(fileName);
+    
+    return suffixType ? (STRPTR)suffixType->type : NULL;
+}
+
+/* Decide whether the current item is text without datatypes.library */
+BOOL IsTextQuick(STRPTR fileName)
+{
+    const struct SuffixType *suffixType = NULL;
+    
+    if (g_item.tier == TIER_HEADER && ReadItemHeader(fileName)) {
+        return IsTextHeader();
+    }
+    
+    suffixType = FindSuffixType(fileName);
+    
+    return (BOOL)(suffixType && suffixType->isText);
+}
+
+/* Decide from header or name alone whether the item is runnable */
+BOOL IsExecutableQuick(STRPTR fileName)
+{
+    STRPTR filePart = NULL;
+    
+    if (g_item.tier == TIER_HEADER && ReadItemHeader(fileName)) {
+        filePart = FilePart(fileName);
+        return (BOOL)(IsHunkHeader() && filePart && strchr(filePart, '.') == NULL);
+    }
+    
+    return IsExecutableFromInfo(fileName);
+}
+
+/* Guess whether a file is runnable from its name and FIB alone */
+/* Used when identification is cut short: no period in the name, the */
+/* execute bit allows running it and it is big enough for a HUNK header */
+BOOL IsExecutableFromInfo(STRPTR fileName)
+{
+    STRPTR filePart = NULL;
+    
+    if (!fileName || !g_item.fibValid || g_item.dirEntryType >= 0) {
+        return FALSE;
+    }
+    
+    filePart = FilePart(fileName);
+    if (!filePart || strchr(filePart, '.') != NULL) {
+        return FALSE;
+    }
+    
+    /* Protection bits RWED are active low */
+    if (g_item.protection & FIBF_EXECUTE) {
+        return FALSE;
+    }
+    
+    return (BOOL)(g_item.size >= 8 * 4);
+}
+
+/* Check if item is a drawer */
+BOOL IsDrawer(STRPTR fileName, BPTR fileLock)
+{
+    if (!fileLock) {
+        return FALSE;
+    }
+    
+    if (!ExamineItem(fileLock)) {
+        return FALSE;
+    }
+    
+    return (BOOL)(g_item.dirEntryType == ST_USERDIR);
+}
+
+/* Check if item is an executable */
+BOOL IsExecutable(STRPTR fileName, BPTR fileLock)
+{
+    STRPTR defIconsType = NULL;
+    STRPTR filePart = NULL;
+    STRPTR filePartPtr = NULL;
+    BOOL isToolType = FALSE;
+    BOOL isBinaryType = FALSE;
+    BOOL isHunkFormat = FALSE;
+    BPTR parentLock = NULL;
+    BPTR oldDir = NULL;
+    
+    if (!fileName || !fileLock) {
+        return FALSE;
+    }
+    
+    /* Cheaper tier or out of time - decide from the header or the name */
+    if (!IdentifyAllowed()) {
+        return IsExecutableQuick(fileName);
+    }
+    
+    /* Check DefIcons type identifier for 'tool' */
+    if (IconBase && IsDefIconsRunning()) {
+        filePartPtr = FilePart(fileName);
+        if (filePartPtr != NULL && *filePartPtr != '\0') {
+            UBYTE fileNameCopy[256];
+            STRPTR fileNamePart = NULL;
+            
+            /* Make a copy of the filename part */
+            Strncpy(fileNameCopy, filePartPtr, sizeof(fileNameCopy));
+            fileNamePart = fileNameCopy;
+            
+            StatCount(COUNT_PARENTDIR);
+            parentLock = ParentDir(fileLock);
+            if (parentLock) {
+                oldDir = CurrentDir(parentLock);
+                defIconsType = GetDefIconsTypeIdentifier(fileNamePart, parentLock);
+                CurrentDir(oldDir);
+                UnLock(parentLock);
+            }
+            
+            if (defIconsType && *defIconsType != '\0') {
+                /* Check if type identifier is 'tool' (case-insensitive) */
+                if (Stricmp(defIconsType, "tool") == 0) {
+                    isToolType = TRUE;
+                }
+            }
+        }
+    }
+    
+    /* Deadline may have passed while DefIcons was identifying */
+    if (!isToolType && !IdentifyAllowed()) {
+        return IsExecutableQuick(fileName);
+    }
+    
+    /* Check datatypes for 'binary' group ID */
+    if (!isToolType && DataTypesBase) {
+        /* Check if group ID is GID_BINARY */
+        if (GetItemGroup(fileName, fileLock) == GID_BINARY) {
+            isBinaryType = TRUE;
+        }
+    }
+    
+    /* If neither tool nor binary type, not an executable */
+    if (!isToolType && !isBinaryType) {
+        return FALSE;
+    }
+    
+    /* Out of time - trust the identification we already have */
+    if (!HeaderAllowed()) {
+        return IsExecutableFromInfo(fileName);
+    }
+    
+    /* Check if file is HUNK format using the shared header buffer */
+    if (ReadItemHeader(fileName)) {
+        /* Check for HUNK_HEADER (00 00 03 F3) - executable files only */
+        isHunkFormat = IsHunkHeader();
+    }
+    
+    /* If not HUNK format, not an executable */
+    if (!isHunkFormat) {
+        return FALSE;
+    }
+    
+    /* Check if filename has a period - if it does, it's probably a library/device (not runnable) */
+    filePart = FilePart(fileName);
+    if (filePart) {
+        STRPTR periodPtr;
         
         /* Look for period in filename (not including path) */
         periodPtr = strchr(filePart, '.');
@@ -733,6 +5903,145 @@ BOOL IsExecutable(STRPTR fileName, BPTR fileLock)
     return TRUE;
 }
 
+/* Sum up the hunk table of the HUNK_HEADER in the shared header buffer */
+/* Returns FALSE if there is no usable table */
+BOOL GetHunkNeeds(struct HunkNeeds *needs)
+{
+    ULONG *words = (ULONG *)g_item.header;
+    ULONG count = (ULONG)g_item.headerLen / 4;
+    ULONG w = 1;
+    ULONG first;
+    ULONG last;
+    ULONG i;
+    
+    memset(needs, 0, sizeof(*needs));
+    needs->complete = TRUE;
+    
+    if (!IsHunkHeader()) {
+        return FALSE;
+    }
+    
+    /* Resident library names, each a longword count and that many longwords */
+    while (w < count && words[w] != 0) {
+        if (words[w] >= count) {
+            return FALSE;
+        }
+        w += words[w] + 1;
+    }
+    w++;
+    
+    /* Table size, first and last hunk */
+    if (w + 3 > count) {
+        return FALSE;
+    }
+    first = words[w + 1];
+    last = words[w + 2];
+    w += 3;
+    if (last < first) {
+        return FALSE;
+    }
+    
+    for (i = first; i <= last; i++) {
+        ULONG size;
+        ULONG bytes;
+        ULONG memType;
+        
+        if (w >= count) {
+            needs->complete = FALSE;
+            break;
+        }
+        size = words[w++];
+        bytes = (size & 0x3FFFFFFF) << 2;
+        
+        /* Bit 30 = chip, bit 31 = fast, both = attributes in the next longword */
+        memType = MEMF_ANY;
+        if ((size & 0xC0000000) == 0xC0000000) {
+            if (w >= count) {
+                needs->complete = FALSE;
+                break;
+            }
+            memType = words[w++] & (MEMF_CHIP | MEMF_FAST);
+        } else if (size & 0x40000000) {
+            memType = MEMF_CHIP;
+        } else if (size & 0x80000000) {
+            memType = MEMF_FAST;
+        }
+        
+        if (memType & MEMF_CHIP) {
+            needs->chip = AddBytes(needs->chip, bytes);
+            if (bytes > needs->chipLargest) {
+                needs->chipLargest = bytes;
+            }
+        } else if (memType & MEMF_FAST) {
+            needs->fast = AddBytes(needs->fast, bytes);
+            if (bytes > needs->fastLargest) {
+                needs->fastLargest = bytes;
+            }
+        } else {
+            needs->any = AddBytes(needs->any, bytes);
+            if (bytes > needs->anyLargest) {
+                needs->anyLargest = bytes;
+            }
+        }
+        
+        if (i == last) {
+            break;
+        }
+    }
+    
+    return TRUE;
+}
+
+/* Add without wrapping around - a damaged table must not look small */
+ULONG AddBytes(ULONG total, ULONG bytes)
+{
+    return (total + bytes < total) ? 0xFFFFFFFF : total + bytes;
+}
+
+/* Compare an executable's hunk sizes with the free chip and fast memory */
+/* Returns FALSE, with a message, if the hunks cannot all be loaded */
+BOOL CheckLaunchMemory(STRPTR execPath)
+{
+    struct HunkNeeds needs;
+    ULONG chipFree;
+    ULONG totalFree;
+    BOOL fits = TRUE;
+    
+    /* Without the table there is nothing to go on - let LoadSeg() decide */
+    if (!ReadItemHeader(execPath) || !GetHunkNeeds(&needs)) {
+        return TRUE;
+    }
+    
+    chipFree = AvailMem(MEMF_CHIP);
+    totalFree = AvailMem(MEMF_ANY);
+    
+    /* Each hunk is one allocation, so the largest block matters as well as the total */
+    if (needs.chip > chipFree || needs.chipLargest > AvailMem(MEMF_CHIP | MEMF_LARGEST)) {
+        fits = FALSE;
+    } else if (needs.fast > AvailMem(MEMF_FAST) || needs.fastLargest > AvailMem(MEMF_FAST | MEMF_LARGEST)) {
+        fits = FALSE;
+    } else if (AddBytes(AddBytes(needs.chip, needs.fast), needs.any) > totalFree ||
+               needs.anyLargest > AvailMem(MEMF_LARGEST)) {
+        fits = FALSE;
+    }
+    
+    if (fits) {
+        return TRUE;
+    }
+    
+    if (!g_resolveOnly) {
+        Printf("Open: Not enough free memory to load: %s\n", execPath);
+        Printf("Open: Needs %s%lu KB chip and %lu KB other memory, %lu KB chip and %lu KB in all are free\n",
+               needs.complete ? "" : "at least ",
+               AddBytes(needs.chip, 1023) / 1024, AddBytes(AddBytes(needs.fast, needs.any), 1023) / 1024,
+               chipFree / 1024, totalFree / 1024);
+        PrintError(ERROR_NO_FREE_STORE);
+    }
+    SetIoErr(ERROR_NO_FREE_STORE);
+    
+    return FALSE;
+}
+
 /* Check if file is a binary asset that shouldn't be executed */
 BOOL IsBinaryAsset(STRPTR fileName)
 {
@@ -797,7 +6106,7 @@ BOOL IsInfoFile(STRPTR fileName)
 }
 
 /* Open a drawer in Workbench */
-BOOL OpenDrawer(STRPTR drawerPath, BOOL showAll)
+BOOL OpenDrawer(STRPTR drawerPath, BPTR drawerLock, BOOL showAll)
 {
     struct TagItem tags[3];
     LONG tagIndex = 0;
@@ -817,17 +6126,32 @@ BOOL OpenDrawer(STRPTR drawerPath, BOOL showAll)
     
     tags[tagIndex].ti_Tag = TAG_DONE;
     
+    /* RESOLVE: only say what would happen */
+    if (g_resolveOnly) {
+        SetResolution("drawer", NULL, "workbench", "drawer");
+        return TRUE;
+    }
+    
+    /* Already open - bring its window to front instead of rescanning it */
+    /* SHOWALL still goes through Workbench, as it changes the view */
+    if (!showAll && ShowOpenDrawer(drawerLock)) {
+        return TRUE;
+    }
+    
     /* Clear any previous error */
     SetIoErr(0);
     
     /* Open the drawer */
+    StatBegin(STAT_LAUNCH);
+    StatCount(COUNT_WBOPEN);
     success = OpenWorkbenchObjectA(drawerPath, tags);
     errorCode = IoErr();
+    StatEnd(STAT_LAUNCH);
     
     if (!success || errorCode != 0) {
         Printf("Open: Failed to open drawer: %s\n", drawerPath);
         if (errorCode != 0) {
-            PrintFault(errorCode, "Open");
+            PrintError(errorCode);
         }
         return FALSE;
     }
@@ -835,6 +6159,106 @@ BOOL OpenDrawer(STRPTR drawerPath, BOOL showAll)
     return TRUE;
 }
 
+/* Bring the Workbench window of an already open drawer to front */
+/* The open drawer list is matched by lock, so different paths to the same */
+/* drawer (assigns, volume or device names) are recognised. FALSE if the */
+/* drawer isn't open or its window can't be told apart from another one */
+BOOL ShowOpenDrawer(BPTR drawerLock)
+{
+    struct TagItem tags[2];
+    struct List *drawerList = NULL;
+    struct Node *node;
+    struct Screen *screen;
+    struct Window *window;
+    struct Window *found = NULL;
+    UBYTE drawerName[256];
+    STRPTR title;
+    STRPTR colon;
+    BPTR openLock;
+    ULONG ibaseLock;
+    LONG matches = 0;
+    
+    if (!drawerLock || !WorkbenchBase || !IntuitionBase) {
+        return FALSE;
+    }
+    
+    drawerName[0] = '\0';
+    
+    tags[0].ti_Tag = WBCTRLA_GetOpenDrawerList;
+    tags[0].ti_Data = (ULONG)&drawerList;
+    tags[1].ti_Tag = TAG_DONE;
+    if (!WorkbenchControlA(NULL, tags) || !drawerList) {
+        return FALSE;
+    }
+    
+    for (node = drawerList->lh_Head; node->ln_Succ; node = node->ln_Succ) {
+        StatCount(COUNT_LOCK);
+        openLock = Lock((STRPTR)node->ln_Name, SHARED_LOCK);
+        if (openLock) {
+            if (SameLock(openLock, drawerLock) == LOCK_SAME) {
+                Strncpy(drawerName, (STRPTR)node->ln_Name, sizeof(drawerName));
+            }
+            UnLock(openLock);
+        }
+        if (drawerName[0]) {
+            break;
+        }
+    }
+    
+    tags[0].ti_Tag = WBCTRLA_FreeOpenDrawerList;
+    tags[0].ti_Data = (ULONG)drawerList;
+    WorkbenchControlA(NULL, tags);
+    
+    if (!drawerName[0]) {
+        return FALSE;
+    }
+    
+    /* Drawer windows are titled with the drawer name, volumes without the colon */
+    title = FilePart(drawerName);
+    if (!*title) {
+        colon = strchr(drawerName, ':');
+        if (colon) {
+            *colon = '\0';
+        }
+        title = drawerName;
+    }
+    
+    screen = LockPubScreen((STRPTR)"Workbench");
+    if (!screen) {
+        return FALSE;
+    }
+    
+    ibaseLock = LockIBase(0);
+    for (window = screen->FirstWindow; window; window = window->NextWindow) {
+        if ((window->Flags & WFLG_WBENCHWINDOW) && window->Title && strcmp((char *)window->Title, (char *)title) == 0) {
+            found = window;
+            matches++;
+        }
+    }
+    UnlockIBase(ibaseLock);
+    
+    /* Intuition may not be called under LockIBase(), and once it is released */
+    /* Workbench may close the window - check it is still there under Forbid(), */
+    /* which keeps Workbench from running; both calls only queue the request */
+    if (matches == 1) {
+        Forbid();
+        for (window = screen->FirstWindow; window && window != found; window = window->NextWindow) {
+        }
+        if (window && (window->Flags & WFLG_WBENCHWINDOW) && window->Title
+            && strcmp((char *)window->Title, (char *)title) == 0) {
+            WindowToFront(found);
+            ActivateWindow(found);
+        } else {
+            matches = 0;
+        }
+        Permit();
+    }
+    
+    UnlockPubScreen(NULL, screen);
+    
+    return (BOOL)(matches == 1);
+}
+
 /* Open an executable */
 BOOL OpenExecutable(STRPTR execPath)
 {
@@ -848,17 +6272,35 @@ BOOL OpenExecutable(STRPTR execPath)
     
     tags[0].ti_Tag = TAG_DONE;
     
+    /* Don't start what cannot be loaded - it would only fail half way and fragment memory */
+    if (!CheckLaunchMemory(execPath)) {
+        if (g_resolveOnly) {
+            SetResolution("executable", execPath, "skip", "memory");
+            return TRUE;
+        }
+        return FALSE;
+    }
+    
+    /* RESOLVE: only say what would happen */
+    if (g_resolveOnly) {
+        SetResolution("executable", execPath, "workbench", "executable");
+        return TRUE;
+    }
+    
     /* Clear any previous error */
     SetIoErr(0);
     
     /* Launch the executable */
+    StatBegin(STAT_LAUNCH);
+    StatCount(COUNT_WBOPEN);
     success = OpenWorkbenchObjectA(execPath, tags);
     errorCode = IoErr();
+    StatEnd(STAT_LAUNCH);
     
     if (!success || errorCode != 0) {
         Printf("Open: Failed to launch executable: %s\n", execPath);
         if (errorCode != 0) {
-            PrintFault(errorCode, "Open");
+            PrintError(errorCode);
         }
         return FALSE;
     }
@@ -884,7 +6326,7 @@ BOOL OpenInfoFile(STRPTR fileName, BPTR fileLock)
     /* Copy the full filename path */
     nameLen = strlen(fileName);
     if (nameLen >= (LONG)sizeof(iconPath)) {
-        Printf("Open: Filename too long: %s\n", fileName);
+        FPrintf(MessageOutput(), "Open: Filename too long: %s\n", fileName);
         return FALSE;
     }
     
@@ -899,6 +6341,12 @@ BOOL OpenInfoFile(STRPTR fileName, BPTR fileLock)
     /* Build command: WBInfo <fully-qualified-path> */
     SNPrintf(command, sizeof(command), "WBInfo %s", iconPath);
     
+    /* RESOLVE: only say what would happen */
+    if (g_resolveOnly) {
+        SetResolution("info", (STRPTR)"WBInfo", "system", "info");
+        return TRUE;
+    }
+    
     /* Set up System() tags for async execution */
     /* Redirect output to NIL: to prevent any output from appearing in our console */
     sysTags[0].ti_Tag = SYS_Asynch;
@@ -913,14 +6361,17 @@ BOOL OpenInfoFile(STRPTR fileName, BPTR fileLock)
     SetIoErr(0);
     
     /* Launch WBInfo command asynchronously */
+    StatBegin(STAT_LAUNCH);
+    StatCount(COUNT_SYSTEM);
     sysResult = System((STRPTR)command, sysTags);
     errorCode = IoErr();
+    StatEnd(STAT_LAUNCH);
     
     /* System() returns 0 for success or -1 for failure in async mode */
     if (sysResult == -1 || errorCode != 0) {
         Printf("Open: Failed to launch WBInfo for: %s\n", fileName);
         if (errorCode != 0) {
-            PrintFault(errorCode, "Open");
+            PrintError(errorCode);
         }
         result = FALSE;
     } else {
@@ -938,16 +6389,35 @@ BOOL OpenDataFile(STRPTR fileName, BPTR fileLock, STRPTR forceTool, BOOL forceBr
     STRPTR defIconsTool = NULL;
     STRPTR datatypesTool = NULL;
     STRPTR iconTool = NULL;
-    BPTR parentLock = NULL;
+    STRPTR ruleTool = NULL;
+    STRPTR quickType = NULL;
+    STRPTR quickTool = NULL;
+    STRPTR largeTool = NULL;
+    STRPTR defAsciiTool = NULL;
+    struct Tool dtTool;
+    UBYTE toolPath[256];
+    UWORD stageOrder[STAGE_COUNT];
+    UWORD stage;
+    LONG i;
+    BOOL launched = FALSE;
     BOOL success = FALSE;
+    const char *stageName = "none";
     UWORD preferredTool = TW_BROWSE; /* Default to BROWSE for viewing */
     
     if (!fileName || !fileLock) {
         return FALSE;
     }
     
+    dtTool.tn_Program = NULL;
+    toolPath[0] = '\0';
+    
+    /* A matching rule decides the tool without any identification I/O */
+    if (!forceTool || !*forceTool) {
+        ruleTool = FindRuleTool(fileName, GetPreferredTool(forceBrowse, forceEdit, forceInfo, forcePrint, forceMail));
+    }
+    
     /* If the target is itself an executable binary, open it directly with OpenWorkbenchObjectA */
-    if (IsExecutable(fileName, fileLock) && !IsBinaryAsset(fileName)) {
+    if (!ruleTool && IsExecutable(fileName, fileLock) && !IsBinaryAsset(fileName) && !g_aborted) {
         /* It's an executable binary - launch it directly */
         return OpenExecutable(fileName);
     }
@@ -955,6 +6425,11 @@ BOOL OpenDataFile(STRPTR fileName, BPTR fileLock, STRPTR forceTool, BOOL forceBr
     /* If force tool specified, use it directly */
     if (forceTool && *forceTool) {
         tool = forceTool;
+        stageName = "tool";
+    } else if (ruleTool) {
+        /* Tool from ENV:Open/Rules */
+        tool = ruleTool;
+        stageName = "rule";
     } else {
         /* Determine preferred tool type from flags */
         if (forceBrowse) {
@@ -964,229 +6439,326 @@ BOOL OpenDataFile(STRPTR fileName, BPTR fileLock, STRPTR forceTool, BOOL forceBr
         } else if (forceInfo) {
             preferredTool = TW_INFO;
         } else if (forcePrint) {
-            preferredTool = TW_PRINT;
-        } else if (forceMail) {
-            preferredTool = TW_MAIL;
-        }
-        
-        /* Try DefIcons method first (if DefIcons is running) */
-        if (IconBase && IsDefIconsRunning()) {
-            STRPTR filePartPtr;
-            UBYTE fileNameCopy[256];
-            STRPTR fileNamePart = NULL;
-            
-            /* Get just the filename part */
-            filePartPtr = FilePart(fileName);
-            
-            /* Make a copy of the filename part to ensure it's valid */
-            /* FilePart returns a pointer into the original string, which may become invalid */
-            if (filePartPtr != NULL && *filePartPtr != '\0') {
-                /* Use full buffer size - Strncpy will handle truncation and null-termination */
-                Strncpy(fileNameCopy, filePartPtr, sizeof(fileNameCopy));
-                fileNamePart = fileNameCopy;
-            } else {
-                /* Fallback: use the original fileName if FilePart fails */
-                fileNamePart = fileName;
-            }
-            
-            parentLock = ParentDir(fileLock);
-            if (parentLock) {
-                defIconsType = GetDefIconsTypeIdentifier(fileNamePart, parentLock);
-                if (defIconsType && *defIconsType) {
-                    defIconsTool = GetDefIconsDefaultTool(defIconsType);
-                    if (defIconsTool && *defIconsTool) {
-                        tool = defIconsTool;
-                    }
-                }
-                UnLock(parentLock);
+            preferredTool = TW_PRINT;
+        } else if (forceMail) {
+            preferredTool = TW_MAIL;
+        }
+        
+        /* Run DefIcons, datatypes.library and the icon default tool, */
+        /* starting with the stage that has always won for this suffix; */
+        /* if it misses, the others follow in the usual order */
+        stageOrder[0] = GetFirstStage(fileName);
+        for (i = 1, stage = STAGE_DEFICONS; stage < STAGE_COUNT; stage++) {
+            if (stage != stageOrder[0]) {
+                stageOrder[i++] = stage;
             }
         }
         
-        /* If DefIcons didn't provide a tool, try datatypes.library */
-        /* Note: We'll get the tool name for display, but use ToolNode for LaunchToolA */
-        if (!tool && DataTypesBase) {
-            datatypesTool = GetDatatypesTool(fileName, fileLock, preferredTool);
-            if (datatypesTool && *datatypesTool) {
-                tool = datatypesTool;
+        for (i = 0; i < STAGE_COUNT && !tool; i++) {
+            switch (stageOrder[i]) {
+                case STAGE_DEFICONS:
+                    /* DefIcons method (if DefIcons is running) */
+                    if (IconBase && IsDefIconsRunning() && IdentifyAllowed()) {
+                        defIconsTool = GetDefIconsTool(fileName, fileLock, &defIconsType);
+                        if (defIconsTool && *defIconsTool) {
+                            tool = defIconsTool;
+                        }
+                    }
+                    break;
+                    
+                case STAGE_DATATYPES:
+                    /* datatypes.library - dtTool receives a copy of the */
+                    /* ToolNode's Tool for LaunchToolA */
+                    if (DataTypesBase && IdentifyAllowed()) {
+                        datatypesTool = GetDatatypesTool(fileName, fileLock, preferredTool, &dtTool);
+                        if (datatypesTool && *datatypesTool) {
+                            tool = datatypesTool;
+                        }
+                    }
+                    break;
+                    
+                case STAGE_ICON:
+                    /* The file's own icon default tool */
+                    if (IdentifyAllowed()) {
+                        StatBegin(STAT_ICON);
+                        iconTool = GetIconDefaultTool(fileName, fileLock);
+                        StatEnd(STAT_ICON);
+                        if (iconTool && *iconTool) {
+                            tool = iconTool;
+                        }
+                    }
+                    break;
+            }
+            
+            /* A tool that has vanished doesn't count - try the next stage */
+            if (tool && !CheckToolPath(tool, (UWORD)(tool == datatypesTool ? dtTool.tn_Flags : 0), toolPath, sizeof(toolPath))) {
+                StatCount(COUNT_MISSING);
+                tool = NULL;
+            }
+            
+            if (tool) {
+                RecordStageWin(fileName, stageOrder[i]);
+                stageName = stageNames[stageOrder[i]];
             }
         }
         
-        /* If still no tool, try icon default tool */
-        if (!tool) {
-            iconTool = GetIconDefaultTool(fileName, fileLock);
-            if (iconTool && *iconTool) {
-                tool = iconTool;
+        /* Cheaper tiers: identify from the header or the name alone and */
+        /* take the default tool of the matching DefIcons type */
+        if (!tool && !g_aborted && g_item.tier != TIER_FULL) {
+            quickType = GetQuickTypeIdentifier(fileName);
+            if (quickType && *quickType) {
+                quickTool = GetDefIconsDefaultTool(quickType);
+                if (quickTool && *quickTool && CheckToolPath(quickTool, 0, toolPath, sizeof(toolPath))) {
+                    tool = quickTool;
+                    stageName = (g_item.tier == TIER_HEADER) ? "header" : "name";
+                }
             }
         }
         
         /* If still no tool and file is text, try DefIcons def_ascii tooltype */
         if (!tool && IsTextFile(fileName, fileLock) && IconBase && IsDefIconsRunning()) {
-            STRPTR defAsciiTool;
-            
             defAsciiTool = GetDefIconsDefaultTool((STRPTR)"ascii");
-            if (defAsciiTool && *defAsciiTool) {
+            if (defAsciiTool && *defAsciiTool && CheckToolPath(defAsciiTool, 0, toolPath, sizeof(toolPath))) {
                 tool = defAsciiTool;
+                stageName = "ascii";
+            }
+        }
+        
+        /* Very large files of a configured group or type get their own tool */
+        if (!g_aborted) {
+            largeTool = GetLargeFileTool(fileName, fileLock, defIconsType ? defIconsType : quickType);
+            if (largeTool && CheckToolPath(largeTool, 0, toolPath, sizeof(toolPath))) {
+                tool = largeTool;
+                stageName = "size";
             }
         }
         
         /* If still no tool and file is text, try $Editor env var */
-        if (!tool && IsTextFile(fileName, fileLock)) {
+        if (!tool && !launched && !g_aborted && IsTextFile(fileName, fileLock)) {
             STRPTR editorPath;
             
             editorPath = GetEditorFromEnv();
             if (editorPath) {
-                success = LaunchEditorWithSystem(editorPath, fileName);
-                if (success) {
-                    FreeVec(editorPath);
-                    return TRUE;
+                if (g_resolveOnly) {
+                    SetResolution(NULL, editorPath, "system", "editor");
+                    launched = TRUE;
+                } else {
+                    launched = LaunchEditorWithSystem(editorPath, fileName);
                 }
                 FreeVec(editorPath);
             }
         }
         
         /* If still no tool and file is not text, try $Viewer env var */
-        if (!tool && !IsTextFile(fileName, fileLock)) {
+        if (!tool && !launched && !g_aborted && !IsTextFile(fileName, fileLock)) {
             STRPTR viewerPath;
             
             viewerPath = GetViewerFromEnv();
             if (viewerPath) {
-                success = LaunchViewerWithSystem(viewerPath, fileName);
-                if (success) {
-                    FreeVec(viewerPath);
-                    return TRUE;
+                if (g_resolveOnly) {
+                    SetResolution(NULL, viewerPath, "system", "viewer");
+                    launched = TRUE;
+                } else {
+                    launched = LaunchViewerWithSystem(viewerPath, fileName);
                 }
                 FreeVec(viewerPath);
             }
         }
     }
     
-    /* Launch the tool */
-    if (tool && *tool) {
-        /* Check if tool came from DefIcons or icon (use OpenWorkbenchObjectA) */
-        if (tool == defIconsTool || tool == iconTool) {
-            struct TagItem tags[3];
-            BPTR toolFileLock = NULL;
-            STRPTR toolFilePartPtr = NULL;
-            UBYTE toolFileNameCopy[256];
-            STRPTR toolFileNamePart = NULL;
+    /* RESOLVE: record the type that was found */
+    if (g_resolveOnly) {
+        if (defIconsType && *defIconsType) {
+            Strncpy(g_resolution.type, defIconsType, sizeof(g_resolution.type));
+        } else if (quickType && *quickType) {
+            Strncpy(g_resolution.type, quickType, sizeof(g_resolution.type));
+        }
+    }
+    
+    /* Ctrl-C during identification - don't start anything */
+    if (g_aborted) {
+        success = FALSE;
+    } else if (launched) {
+        /* $Editor or $Viewer already took it */
+        success = TRUE;
+    } else if (tool && *tool) {
+        BOOL fromDatatypes = (BOOL)(tool == datatypesTool && dtTool.tn_Program != NULL);
+        
+        /* Launch resolved tools by their cached absolute path */
+        if (tool != forceTool && tool != ruleTool && toolPath[0] != '\0') {
+            tool = toolPath;
+        }
+        
+        if (g_resolveOnly) {
+            /* RESOLVE: only say what would happen */
+            SetResolution(NULL, tool, fromDatatypes ? "datatypes" : "workbench", stageName);
+            success = TRUE;
+        } else if (fromDatatypes) {
+            /* Tool came from datatypes.library (use LaunchToolA) */
+            struct TagItem launchTags[1];
             
-            /* Build tags for OpenWorkbenchObjectA */
-            toolFileLock = Lock(fileName, ACCESS_READ);
-            if (toolFileLock) {
-                /* Get just the filename part */
-                toolFilePartPtr = FilePart(fileName);
-                
-                /* Make a copy of the filename part to ensure it's valid */
-                /* FilePart returns a pointer into the original string, which may become invalid */
-                if (toolFilePartPtr != NULL && *toolFilePartPtr != '\0') {
-                    /* Use full buffer size - Strncpy will handle truncation and null-termination */
-                    Strncpy(toolFileNameCopy, toolFilePartPtr, sizeof(toolFileNameCopy));
-                    toolFileNamePart = toolFileNameCopy;
-                } else {
-                    /* Fallback: use the original fileName if FilePart fails */
-                    toolFileNamePart = fileName;
-                }
-                
-                parentLock = ParentDir(toolFileLock);
-                if (parentLock) {
-                    tags[0].ti_Tag = WBOPENA_ArgLock;
-                    tags[0].ti_Data = (ULONG)parentLock;
-                    tags[1].ti_Tag = WBOPENA_ArgName;
-                    tags[1].ti_Data = (ULONG)toolFileNamePart;
-                    tags[2].ti_Tag = TAG_DONE;
-                    
-                    SetIoErr(0);
-                    success = OpenWorkbenchObjectA(tool, tags);
-                    if (!success || IoErr() != 0) {
-                        Printf("Open: Failed to launch tool: %s\n", tool);
-                        PrintFault(IoErr(), "Open");
-                    }
-                    
-                    UnLock(parentLock);
-                }
-                UnLock(toolFileLock);
+            launchTags[0].ti_Tag = TAG_DONE;
+            dtTool.tn_Program = tool;
+            
+            SetIoErr(0);
+            StatBegin(STAT_LAUNCH);
+            success = LaunchToolA(&dtTool, fileName, launchTags);
+            StatEnd(STAT_LAUNCH);
+            if (!success || IoErr() != 0) {
+                Printf("Open: Failed to launch datatypes tool: %s\n", tool);
+                PrintError(IoErr());
             }
         } else {
-            /* Tool came from datatypes.library (use LaunchToolA) */
-            struct DataType *dtn = NULL;
-            struct ToolNode *tn = NULL;
-            struct TagItem launchTags[2];
+            /* TOOL=, DefIcons, icon, rule or size route (use OpenWorkbenchObjectA) */
+            success = LaunchWorkbenchTool(tool, fileName, fileLock);
+        }
+    } else {
+        if (g_resolveOnly) {
+            SetResolution(NULL, NULL, "none", "none");
+        } else {
+            Printf("Open: No tool found to open: %s\n", fileName);
+        }
+        success = FALSE;
+    }
+    
+    /* Free allocated tool strings */
+    if (defIconsTool) {
+        FreeVec(defIconsTool);
+    }
+    if (datatypesTool) {
+        FreeVec(datatypesTool);
+    }
+    if (iconTool) {
+        FreeVec(iconTool);
+    }
+    if (quickTool) {
+        FreeVec(quickTool);
+    }
+    if (defAsciiTool) {
+        FreeVec(defAsciiTool);
+    }
+    
+    return success;
+}
+
+/* DefIcons stage - identify the file and look up the def_ icon's tool */
+/* typeOut receives the DefIcons type (static buffer), if any */
+STRPTR GetDefIconsTool(STRPTR fileName, BPTR fileLock, STRPTR *typeOut)
+{
+    static UBYTE sharedType[256];
+    struct SharedEntry *shared = &g_sharedEntry;
+    UBYTE fileKey[64];
+    BOOL haveKey = FALSE;
+    STRPTR filePartPtr;
+    UBYTE fileNameCopy[256];
+    STRPTR fileNamePart = NULL;
+    STRPTR typeIdentifier = NULL;
+    STRPTR tool = NULL;
+    BPTR parentLock = NULL;
+    
+    /* Get just the filename part */
+    filePartPtr = FilePart(fileName);
+    
+    /* Make a copy of the filename part to ensure it's valid */
+    /* FilePart returns a pointer into the original string, which may become invalid */
+    if (filePartPtr != NULL && *filePartPtr != '\0') {
+        /* Use full buffer size - Strncpy will handle truncation and null-termination */
+        Strncpy(fileNameCopy, filePartPtr, sizeof(fileNameCopy));
+        fileNamePart = fileNameCopy;
+    } else {
+        /* Fallback: use the original fileName if FilePart fails */
+        fileNamePart = fileName;
+    }
+    
+    /* The same file may have been identified by another Open recently */
+    haveKey = GetFileKey(fileName, fileLock, fileKey, sizeof(fileKey));
+    if (haveKey && GetSharedEntry(SHARED_FILETYPE, fileKey, 0, shared) &&
+        shared->size == g_item.size && CompareDates(&shared->date, &g_item.date) == 0) {
+        if (shared->found) {
+            Strncpy(sharedType, shared->value, sizeof(sharedType));
+            typeIdentifier = sharedType;
+            tool = GetDefIconsDefaultTool(typeIdentifier);
+        }
+    } else {
+        StatCount(COUNT_PARENTDIR);
+        parentLock = ParentDir(fileLock);
+        if (parentLock) {
+            typeIdentifier = GetDefIconsTypeIdentifier(fileNamePart, parentLock);
+            if (typeIdentifier && *typeIdentifier) {
+                tool = GetDefIconsDefaultTool(typeIdentifier);
+            }
+            UnLock(parentLock);
             
-            /* Get the ToolNode (this keeps the DataType locked) */
-            tn = GetDatatypesToolNode(fileName, fileLock, preferredTool, &dtn);
-            if (tn && dtn) {
-                /* LaunchToolA expects a Tool structure pointer */
-                /* The ToolNode contains the Tool structure at tn_Tool */
-                launchTags[0].ti_Tag = TAG_DONE;
-                
-                SetIoErr(0);
-                success = LaunchToolA(&tn->tn_Tool, fileName, launchTags);
-                if (!success || IoErr() != 0) {
-                    Printf("Open: Failed to launch datatypes tool: %s\n", tool);
-                    PrintFault(IoErr(), "Open");
-                }
-                
-                /* Release the DataType (ToolNode is only valid while DataType is locked) */
-                ReleaseDataType(dtn);
-            } else {
-                /* Fallback to OpenWorkbenchObjectA if we can't get ToolNode */
-                struct TagItem tags[3];
-                BPTR toolFileLock = NULL;
-                STRPTR toolFilePartPtr = NULL;
-                UBYTE toolFileNameCopy[256];
-                STRPTR toolFileNamePart = NULL;
-                
-                toolFileLock = Lock(fileName, ACCESS_READ);
-                if (toolFileLock) {
-                    /* Get just the filename part */
-                    toolFilePartPtr = FilePart(fileName);
-                    
-                    /* Make a copy of the filename part to ensure it's valid */
-                    /* FilePart returns a pointer into the original string, which may become invalid */
-                    if (toolFilePartPtr != NULL && *toolFilePartPtr != '\0') {
-                        /* Use full buffer size - Strncpy will handle truncation and null-termination */
-                        Strncpy(toolFileNameCopy, toolFilePartPtr, sizeof(toolFileNameCopy));
-                        toolFileNamePart = toolFileNameCopy;
-                    } else {
-                        /* Fallback: use the original fileName if FilePart fails */
-                        toolFileNamePart = fileName;
-                    }
-                    
-                    parentLock = ParentDir(toolFileLock);
-                    if (parentLock) {
-                        tags[0].ti_Tag = WBOPENA_ArgLock;
-                        tags[0].ti_Data = (ULONG)parentLock;
-                        tags[1].ti_Tag = WBOPENA_ArgName;
-                        tags[1].ti_Data = (ULONG)toolFileNamePart;
-                        tags[2].ti_Tag = TAG_DONE;
-                        
-                        SetIoErr(0);
-                        success = OpenWorkbenchObjectA(tool, tags);
-                        if (!success || IoErr() != 0) {
-                            Printf("Open: Failed to launch tool: %s\n", tool);
-                            PrintFault(IoErr(), "Open");
-                        }
-                        
-                        UnLock(parentLock);
-                    }
-                    UnLock(toolFileLock);
+            if (haveKey && (!typeIdentifier || strlen(typeIdentifier) < sizeof(shared->value))) {
+                memset(shared, 0, sizeof(struct SharedEntry));
+                shared->kind = SHARED_FILETYPE;
+                shared->found = (BOOL)(typeIdentifier && *typeIdentifier);
+                shared->size = g_item.size;
+                shared->date = g_item.date;
+                Strncpy(shared->key, fileKey, sizeof(shared->key));
+                if (shared->found) {
+                    Strncpy(shared->value, typeIdentifier, sizeof(shared->value));
                 }
+                PutSharedEntry(shared);
             }
         }
+    }
+    
+    if (typeOut) {
+        *typeOut = typeIdentifier;
+    }
+    
+    return tool;
+}
+
+/* Launch a tool through Workbench with the file as its argument */
+BOOL LaunchWorkbenchTool(STRPTR tool, STRPTR fileName, BPTR fileLock)
+{
+    struct TagItem tags[3];
+    BPTR parentLock = NULL;
+    STRPTR filePartPtr = NULL;
+    UBYTE fileNameCopy[256];
+    STRPTR fileNamePart = NULL;
+    BOOL success = FALSE;
+    
+    if (!tool || !fileName || !fileLock) {
+        return FALSE;
+    }
+    
+    /* Get just the filename part */
+    filePartPtr = FilePart(fileName);
+    
+    /* Make a copy of the filename part to ensure it's valid */
+    /* FilePart returns a pointer into the original string, which may become invalid */
+    if (filePartPtr != NULL && *filePartPtr != '\0') {
+        /* Use full buffer size - Strncpy will handle truncation and null-termination */
+        Strncpy(fileNameCopy, filePartPtr, sizeof(fileNameCopy));
+        fileNamePart = fileNameCopy;
+    } else {
+        /* Fallback: use the original fileName if FilePart fails */
+        fileNamePart = fileName;
+    }
+    
+    StatCount(COUNT_PARENTDIR);
+    parentLock = ParentDir(fileLock);
+    if (parentLock) {
+        tags[0].ti_Tag = WBOPENA_ArgLock;
+        tags[0].ti_Data = (ULONG)parentLock;
+        tags[1].ti_Tag = WBOPENA_ArgName;
+        tags[1].ti_Data = (ULONG)fileNamePart;
+        tags[2].ti_Tag = TAG_DONE;
         
-        /* Free allocated tool strings */
-        if (defIconsTool) {
-            FreeVec(defIconsTool);
-        }
-        if (datatypesTool) {
-            FreeVec(datatypesTool);
+        SetIoErr(0);
+        StatBegin(STAT_LAUNCH);
+        StatCount(COUNT_WBOPEN);
+        success = OpenWorkbenchObjectA(tool, tags);
+        StatEnd(STAT_LAUNCH);
+        if (!success || IoErr() != 0) {
+            Printf("Open: Failed to launch tool: %s\n", tool);
+            PrintError(IoErr());
         }
-        if (iconTool) {
-            FreeVec(iconTool);
-        }
-    } else {
-        Printf("Open: No tool found to open: %s\n", fileName);
-        success = FALSE;
+        
+        UnLock(parentLock);
     }
     
     return success;
@@ -1224,7 +6796,7 @@ STRPTR GetDefIconsTypeIdentifier(STRPTR fileName, BPTR fileLock)
     
     typeBuffer[0] = '\0';
     
-    if (fileLock != NULL) {
+    if (fileLock) {
         oldDir = CurrentDir(fileLock);
     }
     
@@ -1236,13 +6808,16 @@ STRPTR GetDefIconsTypeIdentifier(STRPTR fileName, BPTR fileLock)
     tags[2].ti_Data = (ULONG)&errorCode;
     tags[3].ti_Tag = TAG_DONE;
     
+    StatBegin(STAT_IDENTIFY);
+    StatCount(COUNT_ICONTAGS);
     icon = GetIconTagList(fileName, tags);
+    StatEnd(STAT_IDENTIFY);
     
     if (icon) {
         FreeDiskObject(icon);
     }
     
-    if (oldDir != NULL) {
+    if (fileLock) {
         CurrentDir(oldDir);
     }
     
@@ -1256,7 +6831,10 @@ STRPTR GetDefIconsTypeIdentifier(STRPTR fileName, BPTR fileLock)
 /* Get DefIcons default tool */
 STRPTR GetDefIconsDefaultTool(STRPTR typeIdentifier)
 {
+    struct ToolMemo *memo = NULL;
+    struct SharedEntry *shared = &g_sharedEntry;
     struct DiskObject *defaultIcon = NULL;
+    struct DateStamp iconDate;
     STRPTR defaultTool = NULL;
     UBYTE defIconName[64];
     BPTR oldDir = NULL;
@@ -1266,22 +6844,70 @@ STRPTR GetDefIconsDefaultTool(STRPTR typeIdentifier)
         return NULL;
     }
     
+    /* A type seen before in this run needs no def_ icon load */
+    memo = FindToolMemo(MEMO_DEFICONS, typeIdentifier, 0);
+    if (memo) {
+        if (memo->found) {
+            ULONG toolLen = strlen(memo->program) + 1;
+            
+            defaultTool = AllocVec(toolLen, MEMF_CLEAR);
+            if (defaultTool) {
+                Strncpy((UBYTE *)defaultTool, memo->program, toolLen);
+            }
+        }
+        return defaultTool;
+    }
+    
     SNPrintf(defIconName, sizeof(defIconName), "def_%s", typeIdentifier);
     
-    if ((envDir = Lock("ENV:Sys", SHARED_LOCK)) != NULL) {
-        oldDir = CurrentDir(envDir);
-        defaultIcon = GetDiskObject(defIconName);
-        CurrentDir(oldDir);
-        UnLock(envDir);
+    /* Another Open may have loaded this def_ icon already - used as long */
+    /* as the icon it was loaded from hasn't been replaced since */
+    memset(&iconDate, 0, sizeof(iconDate));
+    if (g_sharedCache) {
+        GetDefIconDate(defIconName, &iconDate);
+    }
+    if (GetSharedEntry(SHARED_DEFTOOL, typeIdentifier, 0, shared) &&
+        CompareDates(&shared->date, &iconDate) == 0) {
+        memo = AddToolMemo(MEMO_DEFICONS, typeIdentifier, 0);
+        if (shared->found) {
+            ULONG toolLen = strlen(shared->value) + 1;
+            
+            if (memo) {
+                memo->found = TRUE;
+                Strncpy(memo->program, shared->value, sizeof(memo->program));
+            }
+            defaultTool = AllocVec(toolLen, MEMF_CLEAR);
+            if (defaultTool) {
+                Strncpy((UBYTE *)defaultTool, shared->value, toolLen);
+            }
+        }
+        return defaultTool;
     }
     
-    if (!defaultIcon && (envDir = Lock("ENVARC:Sys", SHARED_LOCK)) != NULL) {
+    StatCount(COUNT_LOCK);
+    if ((envDir = Lock("ENV:Sys", SHARED_LOCK))) {
         oldDir = CurrentDir(envDir);
+        StatBegin(STAT_DEFICON);
+        StatCount(COUNT_DISKOBJECT);
         defaultIcon = GetDiskObject(defIconName);
+        StatEnd(STAT_DEFICON);
         CurrentDir(oldDir);
         UnLock(envDir);
     }
     
+    if (!defaultIcon) {
+        StatCount(COUNT_LOCK);
+        if ((envDir = Lock("ENVARC:Sys", SHARED_LOCK))) {
+            oldDir = CurrentDir(envDir);
+            StatBegin(STAT_DEFICON);
+            StatCount(COUNT_DISKOBJECT);
+            defaultIcon = GetDiskObject(defIconName);
+            StatEnd(STAT_DEFICON);
+            CurrentDir(oldDir);
+            UnLock(envDir);
+        }
+    }
+    
     if (defaultIcon) {
         if (defaultIcon->do_DefaultTool != NULL) {
             if (defaultIcon->do_DefaultTool[0] != '\0') {
@@ -1301,89 +6927,129 @@ STRPTR GetDefIconsDefaultTool(STRPTR typeIdentifier)
         FreeDiskObject(defaultIcon);
     }
     
+    /* Remember the outcome, including that there was no tool */
+    if (!defaultTool || strlen(defaultTool) < sizeof(memo->program)) {
+        memo = AddToolMemo(MEMO_DEFICONS, typeIdentifier, 0);
+        if (memo && defaultTool) {
+            memo->found = TRUE;
+            Strncpy(memo->program, defaultTool, sizeof(memo->program));
+        }
+        
+        memset(shared, 0, sizeof(struct SharedEntry));
+        shared->kind = SHARED_DEFTOOL;
+        shared->found = (BOOL)(defaultTool != NULL);
+        shared->date = iconDate;
+        Strncpy(shared->key, typeIdentifier, sizeof(shared->key));
+        if (defaultTool) {
+            Strncpy(shared->value, defaultTool, sizeof(shared->value));
+        }
+        if (g_sharedCache && strlen(typeIdentifier) < sizeof(shared->key)) {
+            PutSharedEntry(shared);
+        }
+    }
+    
     return defaultTool;
 }
 
 /* Get datatypes.library tool */
-STRPTR GetDatatypesTool(STRPTR fileName, BPTR fileLock, UWORD preferredTool)
+/* If toolOut is given it receives a copy of the Tool for LaunchToolA, */
+/* with tn_Program pointing at the returned string */
+STRPTR GetDatatypesTool(STRPTR fileName, BPTR fileLock, UWORD preferredTool, struct Tool *toolOut)
 {
     struct DataType *dtn = NULL;
     struct ToolNode *tn = NULL;
+    struct ToolMemo *memo = NULL;
+    struct SharedEntry *shared = &g_sharedEntry;
+    struct DateStamp dirDate;
     STRPTR tool = NULL;
-    UWORD toolOrder[3];
-    LONG i;
+    STRPTR program = NULL;
+    UWORD which = 0;
+    UWORD flags = 0;
     
     if (!DataTypesBase || !fileName || !fileLock) {
         return NULL;
     }
     
     /* Obtain datatype for the file */
+    StatBegin(STAT_DATATYPE);
+    StatCount(COUNT_OBTAINDT);
     dtn = ObtainDataTypeA(DTST_FILE, (APTR)fileLock, NULL);
+    StatEnd(STAT_DATATYPE);
     if (!dtn) {
         return NULL;
     }
     
-    /* Determine tool order based on preference */
-    if (preferredTool == TW_BROWSE) {
-        toolOrder[0] = TW_BROWSE;
-        toolOrder[1] = TW_EDIT;
-        toolOrder[2] = TW_INFO;
-    } else if (preferredTool == TW_EDIT) {
-        toolOrder[0] = TW_EDIT;
-        toolOrder[1] = TW_BROWSE;
-        toolOrder[2] = TW_INFO;
-    } else if (preferredTool == TW_INFO) {
-        toolOrder[0] = TW_INFO;
-        toolOrder[1] = TW_BROWSE;
-        toolOrder[2] = TW_EDIT;
-    } else if (preferredTool == TW_PRINT) {
-        toolOrder[0] = TW_PRINT;
-        toolOrder[1] = TW_BROWSE;
-        toolOrder[2] = TW_EDIT;
-    } else if (preferredTool == TW_MAIL) {
-        toolOrder[0] = TW_MAIL;
-        toolOrder[1] = TW_BROWSE;
-        toolOrder[2] = TW_EDIT;
+    /* Remember the group for the other checks on this item */
+    g_item.groupValid = TRUE;
+    g_item.groupID = dtn->dtn_Header->dth_GroupID;
+    
+    /* A datatype seen before in this run needs no ToolNode walk */
+    memo = FindToolMemo(MEMO_DATATYPES, dtn->dtn_Header->dth_Name, preferredTool);
+    if (memo) {
+        if (memo->found) {
+            program = memo->program;
+            which = memo->which;
+            flags = memo->flags;
+        }
     } else {
-        /* Default fallback */
-        toolOrder[0] = TW_BROWSE;
-        toolOrder[1] = TW_EDIT;
-        toolOrder[2] = TW_INFO;
-    }
-    
-    /* Try to find a tool in preferred order */
-    for (i = 0; i < 3; i++) {
-        struct TagItem tags[2];
-        tags[0].ti_Tag = TOOLA_Which;
-        tags[0].ti_Data = (ULONG)toolOrder[i];
-        tags[1].ti_Tag = TAG_DONE;
-        
-        tn = FindToolNodeA(&dtn->dtn_ToolList, tags);
-        if (tn) {
-            if (tn->tn_Tool.tn_Program && *tn->tn_Tool.tn_Program) {
-                ULONG toolLen = strlen(tn->tn_Tool.tn_Program) + 1;
-                tool = AllocVec(toolLen, MEMF_CLEAR);
-                if (tool) {
-                    Strncpy((UBYTE *)tool, tn->tn_Tool.tn_Program, toolLen);
-                    break;
+        /* Another Open has walked this datatype's tools already - used as */
+        /* long as no descriptor has been added or replaced since */
+        memset(&dirDate, 0, sizeof(dirDate));
+        if (g_sharedCache) {
+            GetDataTypesDate(&dirDate);
+        }
+        if (GetSharedEntry(SHARED_DTTOOL, dtn->dtn_Header->dth_Name, preferredTool, shared) &&
+            CompareDates(&shared->date, &dirDate) == 0) {
+            if (shared->found) {
+                program = shared->value;
+                which = shared->which;
+                flags = shared->flags;
+            }
+        } else {
+            tn = FindDatatypesToolNode(dtn, preferredTool);
+            if (tn) {
+                program = tn->tn_Tool.tn_Program;
+                which = tn->tn_Tool.tn_Which;
+                flags = tn->tn_Tool.tn_Flags;
+            }
+            
+            if (g_sharedCache && (!program || strlen(program) < sizeof(shared->value)) &&
+                strlen(dtn->dtn_Header->dth_Name) < sizeof(shared->key)) {
+                memset(shared, 0, sizeof(struct SharedEntry));
+                shared->kind = SHARED_DTTOOL;
+                shared->verb = preferredTool;
+                shared->found = (BOOL)(program != NULL);
+                shared->which = which;
+                shared->flags = flags;
+                shared->date = dirDate;
+                Strncpy(shared->key, dtn->dtn_Header->dth_Name, sizeof(shared->key));
+                if (program) {
+                    Strncpy(shared->value, program, sizeof(shared->value));
                 }
+                PutSharedEntry(shared);
+            }
+        }
+        
+        if (!program || strlen(program) < sizeof(memo->program)) {
+            memo = AddToolMemo(MEMO_DATATYPES, dtn->dtn_Header->dth_Name, preferredTool);
+            if (memo && program) {
+                memo->found = TRUE;
+                memo->which = which;
+                memo->flags = flags;
+                Strncpy(memo->program, program, sizeof(memo->program));
             }
         }
     }
     
-    /* If no tool found with FindToolNodeA, try manual search */
-    if (!tool) {
-        struct Node *node;
-        for (node = dtn->dtn_ToolList.lh_Head; node->ln_Succ; node = node->ln_Succ) {
-            tn = (struct ToolNode *)node;
-            if (tn->tn_Tool.tn_Program && *tn->tn_Tool.tn_Program) {
-                /* Use first available tool */
-                ULONG toolLen = strlen(tn->tn_Tool.tn_Program) + 1;
-                tool = AllocVec(toolLen, MEMF_CLEAR);
-                if (tool) {
-                    Strncpy((UBYTE *)tool, tn->tn_Tool.tn_Program, toolLen);
-                    break;
-                }
+    if (program) {
+        ULONG toolLen = strlen(program) + 1;
+        tool = AllocVec(toolLen, MEMF_CLEAR);
+        if (tool) {
+            Strncpy((UBYTE *)tool, program, toolLen);
+            if (toolOut) {
+                toolOut->tn_Which = which;
+                toolOut->tn_Flags = flags;
+                toolOut->tn_Program = tool;
             }
         }
     }
@@ -1393,22 +7059,15 @@ STRPTR GetDatatypesTool(STRPTR fileName, BPTR fileLock, UWORD preferredTool)
     return tool;
 }
 
-/* Get datatypes ToolNode (keeps DataType locked - caller must ReleaseDataType) */
-struct ToolNode *GetDatatypesToolNode(STRPTR fileName, BPTR fileLock, UWORD preferredTool, struct DataType **dtnOut)
+/* Find the ToolNode of a datatype best matching the preferred verb */
+/* The ToolNode is only valid while the DataType is held */
+struct ToolNode *FindDatatypesToolNode(struct DataType *dtn, UWORD preferredTool)
 {
-    struct DataType *dtn = NULL;
     struct ToolNode *tn = NULL;
+    struct Node *node;
     UWORD toolOrder[3];
     LONG i;
     
-    if (!DataTypesBase || !fileName || !fileLock || !dtnOut) {
-        return NULL;
-    }
-    
-    *dtnOut = NULL;
-    
-    /* Obtain datatype for the file */
-    dtn = ObtainDataTypeA(DTST_FILE, (APTR)fileLock, NULL);
     if (!dtn) {
         return NULL;
     }
@@ -1448,34 +7107,70 @@ struct ToolNode *GetDatatypesToolNode(STRPTR fileName, BPTR fileLock, UWORD pref
         tags[0].ti_Data = (ULONG)toolOrder[i];
         tags[1].ti_Tag = TAG_DONE;
         
+        StatCount(COUNT_FINDTOOL);
         tn = FindToolNodeA(&dtn->dtn_ToolList, tags);
-        if (tn) {
-            if (tn->tn_Tool.tn_Program && *tn->tn_Tool.tn_Program) {
-                /* Found a valid tool - return it and keep DataType locked */
-                *dtnOut = dtn;
-                return tn;
-            }
+        if (tn && tn->tn_Tool.tn_Program && *tn->tn_Tool.tn_Program) {
+            return tn;
         }
     }
     
-    /* If no tool found with FindToolNodeA, try manual search */
-    if (!tn) {
-        struct Node *node;
-        for (node = dtn->dtn_ToolList.lh_Head; node->ln_Succ; node = node->ln_Succ) {
-            tn = (struct ToolNode *)node;
-            if (tn->tn_Tool.tn_Program && *tn->tn_Tool.tn_Program) {
-                /* Found a valid tool - return it and keep DataType locked */
-                *dtnOut = dtn;
-                return tn;
-            }
+    /* If no tool found with FindToolNodeA, use the first one with a program */
+    for (node = dtn->dtn_ToolList.lh_Head; node->ln_Succ; node = node->ln_Succ) {
+        tn = (struct ToolNode *)node;
+        if (tn->tn_Tool.tn_Program && *tn->tn_Tool.tn_Program) {
+            return tn;
+        }
+    }
+    
+    return NULL;
+}
+
+/* Look up a resolved tool in the per-run memo */
+struct ToolMemo *FindToolMemo(UWORD source, STRPTR key, UWORD verb)
+{
+    LONG i;
+    
+    if (!key || !*key) {
+        return NULL;
+    }
+    
+    for (i = 0; i < g_toolMemoCount; i++) {
+        struct ToolMemo *memo = &g_toolMemos[i];
+        
+        if (memo->source == source && memo->verb == verb && Stricmp(memo->key, key) == 0) {
+            return memo;
         }
     }
     
-    /* No tool found - release DataType */
-    ReleaseDataType(dtn);
     return NULL;
 }
 
+/* Claim a memo slot for a key, reusing the oldest once the table is full */
+/* The slot is returned cleared, i.e. as a negative entry */
+struct ToolMemo *AddToolMemo(UWORD source, STRPTR key, UWORD verb)
+{
+    struct ToolMemo *memo = NULL;
+    
+    /* Keys that don't fit are not memoised rather than truncated */
+    if (!key || !*key || strlen(key) >= sizeof(memo->key)) {
+        return NULL;
+    }
+    
+    if (g_toolMemoCount < MAX_TOOL_MEMOS) {
+        memo = &g_toolMemos[g_toolMemoCount++];
+    } else {
+        memo = &g_toolMemos[g_toolMemoNext];
+        g_toolMemoNext = (g_toolMemoNext + 1) % MAX_TOOL_MEMOS;
+    }
+    
+    memset(memo, 0, sizeof(struct ToolMemo));
+    memo->source = source;
+    memo->verb = verb;
+    Strncpy(memo->key, key, sizeof(memo->key));
+    
+    return memo;
+}
+
 /* Get icon default tool */
 STRPTR GetIconDefaultTool(STRPTR fileName, BPTR fileLock)
 {
@@ -1505,10 +7200,12 @@ STRPTR GetIconDefaultTool(STRPTR fileName, BPTR fileLock)
         fileNamePart = fileName;
     }
     
+    StatCount(COUNT_PARENTDIR);
     parentLock = ParentDir(fileLock);
     
     if (parentLock) {
         oldDir = CurrentDir(parentLock);
+        StatCount(COUNT_DISKOBJECT);
         icon = GetDiskObject(fileNamePart);
         CurrentDir(oldDir);
         
@@ -1532,8 +7229,6 @@ STRPTR GetIconDefaultTool(STRPTR fileName, BPTR fileLock)
 /* Check if file is a text file using datatypes.library */
 BOOL IsTextFile(STRPTR fileName, BPTR fileLock)
 {
-    struct DataType *dtn = NULL;
-    struct FileInfoBlock *fib = NULL;
     BOOL isText = FALSE;
     
     if (!fileName || !fileLock) {
@@ -1541,28 +7236,24 @@ BOOL IsTextFile(STRPTR fileName, BPTR fileLock)
     }
     
     /* First check if file is empty (0 bytes) and not a drawer - treat as text */
-    fib = (struct FileInfoBlock *)AllocVec(sizeof(struct FileInfoBlock), MEMF_CLEAR);
-    if (fib) {
-        if (Examine(fileLock, fib)) {
-            /* If file is 0 bytes and not a drawer, treat it as text */
-            if (fib->fib_DirEntryType == ST_FILE && fib->fib_Size == 0) {
-                FreeVec(fib);
-                return TRUE;
-            }
+    if (ExamineItem(fileLock)) {
+        /* If file is 0 bytes and not a drawer, treat it as text */
+        if (g_item.dirEntryType == ST_FILE && g_item.size == 0) {
+            return TRUE;
         }
-        FreeVec(fib);
+    }
+    
+    /* Cheaper tier or out of time - decide from the header or the name */
+    if (!IdentifyAllowed()) {
+        return IsTextQuick(fileName);
     }
     
     /* If datatypes.library is available, check using it */
+    /* The group is looked up once per item and shared with the other checks */
     if (DataTypesBase) {
-        /* Try to obtain datatype for the file */
-        dtn = ObtainDataTypeA(DTST_FILE, (APTR)fileLock, NULL, NULL, 0, NULL);
-        if (dtn) {
-            /* Check if group ID is GID_TEXT */
-            if (dtn->dtn_Header->dth_GroupID == GID_TEXT) {
-                isText = TRUE;
-            }
-            ReleaseDataType(dtn);
+        /* Check if group ID is GID_TEXT */
+        if (GetItemGroup(fileName, fileLock) == GID_TEXT) {
+            isText = TRUE;
         }
     }
     
@@ -1581,12 +7272,14 @@ STRPTR GetEditorFromEnv(VOID)
     editorLen = GetVar((STRPTR)"Editor", editorBuffer, sizeof(editorBuffer), GVF_GLOBAL_ONLY);
     if (editorLen > 0 && editorLen < (LONG)sizeof(editorBuffer)) {
         /* Validate that the editor path points to a valid file */
+        StatCount(COUNT_LOCK);
         editorLock = Lock((STRPTR)editorBuffer, ACCESS_READ);
         if (editorLock) {
             struct FileInfoBlock *fib;
             
             fib = (struct FileInfoBlock *)AllocVec(sizeof(struct FileInfoBlock), MEMF_CLEAR);
             if (fib) {
+                StatCount(COUNT_EXAMINE);
                 if (Examine(editorLock, fib)) {
                     /* Check if it's a file (not a directory) */
                     if (fib->fib_DirEntryType == ST_FILE) {
@@ -1621,8 +7314,8 @@ BOOL LaunchEditorWithSystem(STRPTR editorPath, STRPTR fileName)
         return FALSE;
     }
     
-    /* Build command: editor path followed by file name */
-    SNPrintf(command, sizeof(command), "%s %s", editorPath, fileName);
+    /* Build command: editor path (or its resident name) followed by file name */
+    SNPrintf(command, sizeof(command), "%s %s", GetResidentCommand(editorPath), fileName);
     
     /* Set up System() tags for async execution */
     /* Redirect input/output to NIL: to prevent any output from appearing in our console */
@@ -1635,8 +7328,11 @@ BOOL LaunchEditorWithSystem(STRPTR editorPath, STRPTR fileName)
     sysTags[3].ti_Tag = TAG_DONE;
     
     SetIoErr(0);
+    StatBegin(STAT_LAUNCH);
+    StatCount(COUNT_SYSTEM);
     sysResult = System(command, sysTags);
     errorCode = IoErr();
+    StatEnd(STAT_LAUNCH);
     
     /* System() returns 0 for success or -1 for failure in async mode */
     if (sysResult == -1 || errorCode != 0) {
@@ -1658,12 +7354,14 @@ STRPTR GetViewerFromEnv(VOID)
     viewerLen = GetVar((STRPTR)"Viewer", viewerBuffer, sizeof(viewerBuffer), GVF_GLOBAL_ONLY);
     if (viewerLen > 0 && viewerLen < (LONG)sizeof(viewerBuffer)) {
         /* Validate that the viewer path points to a valid file */
+        StatCount(COUNT_LOCK);
         viewerLock = Lock((STRPTR)viewerBuffer, ACCESS_READ);
         if (viewerLock) {
             struct FileInfoBlock *fib;
             
             fib = (struct FileInfoBlock *)AllocVec(sizeof(struct FileInfoBlock), MEMF_CLEAR);
             if (fib) {
+                StatCount(COUNT_EXAMINE);
                 if (Examine(viewerLock, fib)) {
                     /* Check if it's a file (not a directory) */
                     if (fib->fib_DirEntryType == ST_FILE) {
@@ -1698,8 +7396,8 @@ BOOL LaunchViewerWithSystem(STRPTR viewerPath, STRPTR fileName)
         return FALSE;
     }
     
-    /* Build command: viewer path followed by file name */
-    SNPrintf(command, sizeof(command), "%s %s", viewerPath, fileName);
+    /* Build command: viewer path (or its resident name) followed by file name */
+    SNPrintf(command, sizeof(command), "%s %s", GetResidentCommand(viewerPath), fileName);
     
     /* Set up System() tags for async execution */
     /* Redirect input/output to NIL: to prevent any output from appearing in our console */
@@ -1712,8 +7410,11 @@ BOOL LaunchViewerWithSystem(STRPTR viewerPath, STRPTR fileName)
     sysTags[3].ti_Tag = TAG_DONE;
     
     SetIoErr(0);
+    StatBegin(STAT_LAUNCH);
+    StatCount(COUNT_SYSTEM);
     sysResult = System(command, sysTags);
     errorCode = IoErr();
+    StatEnd(STAT_LAUNCH);
     
     /* System() returns 0 for success or -1 for failure in async mode */
     if (sysResult == -1 || errorCode != 0) {
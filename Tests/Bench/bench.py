@@ -0,0 +1,138 @@
+#!/usr/bin/env python3
+#
+# Open - benchmark runner
+#
+# Copyright (c) 2025 amigazen project
+# Licensed under BSD 2-Clause License
+#
+
+"""Runs the m68k Open executable under vamos over a mkcorpus.py corpus.
+
+Modes:
+
+  single  one Open per file, as a script calling Open file by file would
+  multi   FILE/M arguments, --batch files per Open
+  from    one Open with FROM and a list of the files
+
+Every run passes RESOLVE, so Open identifies each file and resolves its
+tool but launches nothing; vamos has no Workbench, Intuition or
+datatypes.library, and RESOLVE is the mode that runs without them.
+Workbench-argument mode can't be driven this way (vamos can't start a
+program with a WBStartup message) and is left to the host harness.
+
+vamos doesn't count instructions, so the emulator's own CPU time, taken
+from the rusage of its process, stands in for them. Each mode prints
+files, wall time, files/s, emulator CPU time and CPU time per file.
+"""
+
+import argparse
+import os
+import shutil
+import subprocess
+import sys
+import time
+
+
+def vamos_command(args, open_args):
+    corpus = os.path.abspath(args.corpus)
+    command = [args.vamos,
+               "-V", "System:" + os.path.join(corpus, "System"),
+               "-V", "RAM:" + os.path.join(corpus, "RAM"),
+               "-V", "Work:" + os.path.join(corpus, "Work"),
+               "-a", "SYS:System:",
+               "-a", "C:System:C",
+               "-a", "DEVS:System:Devs",
+               "-a", "ENVARC:System:Prefs/Env-Archive",
+               "-a", "ENV:RAM:Env",
+               "-a", "T:RAM:T",
+               "--cwd", "Work:",
+               "-C", args.cpu]
+    return command + [os.path.abspath(args.open)] + open_args
+
+
+def run_open(args, open_args):
+    """Runs one Open; returns (wall seconds, emulator CPU seconds, output)"""
+    start = time.perf_counter()
+    process = subprocess.Popen(vamos_command(args, open_args),
+                               stdout=subprocess.PIPE, stderr=subprocess.STDOUT)
+    output = process.stdout.read()
+    _, status, usage = os.wait4(process.pid, 0)
+    wall = time.perf_counter() - start
+    if os.waitstatus_to_exitcode(status) > 5:
+        sys.stderr.write(output.decode("latin-1"))
+        raise SystemExit("Open failed: %s" % " ".join(open_args))
+    return wall, usage.ru_utime + usage.ru_stime, output.decode("latin-1")
+
+
+def reset_env(corpus):
+    """ENV: as at boot - a copy of ENVARC:, without Open's caches"""
+    env = os.path.join(corpus, "RAM", "Env")
+    shutil.rmtree(env, ignore_errors=True)
+    shutil.copytree(os.path.join(corpus, "System", "Prefs", "Env-Archive"), env)
+
+
+def invocations(mode, paths, batch):
+    extra = ["RESOLVE"]
+    if mode == "single":
+        for path in paths:
+            yield [path] + extra
+    elif mode == "multi":
+        for i in range(0, len(paths), batch):
+            yield paths[i:i + batch] + extra
+    else:
+        yield ["FROM", "Work:BenchList"] + extra
+
+
+def bench(args, mode, paths):
+    if args.cold:
+        reset_env(args.corpus)
+    elif args.prime:
+        # One run to fill ENV:Open's caches, as a running system would have
+        for open_args in invocations("from", paths, args.batch):
+            run_open(args, open_args)
+
+    wall = 0.0
+    cpu = 0.0
+    runs = 0
+    for open_args in invocations(mode, paths, args.batch):
+        run_wall, run_cpu, output = run_open(args, open_args)
+        wall += run_wall
+        cpu += run_cpu
+        runs += 1
+        if args.verbose:
+            sys.stdout.write(output)
+
+    files = len(paths)
+    print("%-6s %6d files %5d runs %9.3f s %9.1f files/s %9.3f s CPU %9.1f us/file"
+          % (mode, files, runs, wall, files / wall if wall else 0.0,
+             cpu, cpu * 1e6 / files if files else 0.0))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("corpus", help="directory written by mkcorpus.py")
+    parser.add_argument("open", help="the m68k Open executable")
+    parser.add_argument("--mode", choices=("single", "multi", "from", "all"), default="all")
+    parser.add_argument("--batch", type=int, default=50, help="files per Open in multi mode (50)")
+    parser.add_argument("--limit", type=int, default=0, help="use only the first LIMIT files")
+    parser.add_argument("--cold", action="store_true", help="start each mode without Open's ENV: caches")
+    parser.add_argument("--prime", action="store_true", help="fill Open's ENV: caches before each mode")
+    parser.add_argument("--vamos", default="vamos", help="vamos command (vamos)")
+    parser.add_argument("--cpu", default="68020", help="CPU for vamos to emulate (68020)")
+    parser.add_argument("--verbose", action="store_true", help="print Open's output")
+    args = parser.parse_args()
+
+    with open(os.path.join(args.corpus, "Work", "List")) as f:
+        paths = [line.strip() for line in f if line.strip()]
+    if args.limit:
+        paths = paths[:args.limit]
+    with open(os.path.join(args.corpus, "Work", "BenchList"), "w") as f:
+        f.write("\n".join(paths) + "\n")
+
+    modes = ("single", "multi", "from") if args.mode == "all" else (args.mode,)
+    for mode in modes:
+        bench(args, mode, paths)
+
+
+if __name__ == "__main__":
+    main()
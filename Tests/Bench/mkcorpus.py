@@ -0,0 +1,264 @@
+#!/usr/bin/env python3
+#
+# Open - benchmark corpus generator
+#
+# Copyright (c) 2025 amigazen project
+# Licensed under BSD 2-Clause License
+#
+
+"""Writes a reproducible corpus for bench.py.
+
+The output directory holds one host directory per Amiga volume:
+
+  System/   C/, Utilities/ and Tools/ with stand-in tools (valid HUNK
+            executables that only return), Devs/DataTypes/ with
+            descriptors for ILBM, 8SVX and ascii, Prefs/Env-Archive/Sys/
+            with DefIcons def_ icons pointing at the stand-in tools
+  RAM/      Env/ (a copy of Env-Archive, as at boot) and T/
+  Work/     Corpus/dNN/ with the files, and List with one Work: path
+            per line for FROM
+
+The same seed and count always give the same bytes.
+"""
+
+import argparse
+import os
+import random
+import shutil
+import struct
+
+# Kinds of file and how often each is picked
+KINDS = [
+    ("exe", 20),
+    ("library", 5),
+    ("device", 3),
+    ("text", 25),
+    ("ilbm", 15),
+    ("8svx", 7),
+    ("empty", 5),
+    ("icon", 20),
+]
+
+TOOLS = {
+    "MultiView": "Utilities",
+    "Ed": "C",
+    "Display": "Tools",
+    "Play": "Tools",
+}
+
+# DefIcons type -> tool the def_ icon names
+DEFICONS = {
+    "ascii": "SYS:Utilities/MultiView",
+    "ilbm": "SYS:Tools/Display",
+    "8svx": "SYS:Tools/Play",
+    "project": "SYS:C/Ed",
+}
+
+WORDS = ("amiga open tool drawer icon file volume assign lock packet "
+         "datatype descriptor window screen workbench shell script").split()
+
+HUNK_HEADER = 0x3F3
+HUNK_CODE = 0x3E9
+HUNK_DATA = 0x3EA
+HUNK_END = 0x3F2
+WB_DISKMAGIC = 0xE310
+WBTOOL = 3
+WBPROJECT = 4
+
+
+def hunk_executable(rng, code_longs=None, data_longs=0):
+    """HUNK_HEADER, a code hunk starting with moveq #0,d0; rts, an optional
+    data hunk, each closed by HUNK_END"""
+    if code_longs is None:
+        code_longs = rng.randint(1, 256)
+    sizes = [code_longs] + ([data_longs] if data_longs else [])
+    out = struct.pack(">LLLLL", HUNK_HEADER, 0, len(sizes), 0, len(sizes) - 1)
+    out += b"".join(struct.pack(">L", s) for s in sizes)
+    code = struct.pack(">HH", 0x7000, 0x4E75)
+    code += bytes(rng.getrandbits(8) for _ in range(code_longs * 4 - len(code)))
+    out += struct.pack(">LL", HUNK_CODE, code_longs) + code
+    out += struct.pack(">L", HUNK_END)
+    if data_longs:
+        data = bytes(rng.getrandbits(8) for _ in range(data_longs * 4))
+        out += struct.pack(">LL", HUNK_DATA, data_longs) + data
+        out += struct.pack(">L", HUNK_END)
+    return out
+
+
+def text_file(rng):
+    lines = []
+    for _ in range(rng.randint(1, 200)):
+        lines.append(" ".join(rng.choice(WORDS) for _ in range(rng.randint(1, 12))))
+    return ("\n".join(lines) + "\n").encode("ascii")
+
+
+def iff_chunk(ident, data):
+    out = ident + struct.pack(">L", len(data)) + data
+    if len(data) & 1:
+        out += b"\0"
+    return out
+
+
+def iff_form(form_type, chunks):
+    body = form_type + b"".join(chunks)
+    return b"FORM" + struct.pack(">L", len(body)) + body
+
+
+def ilbm_file(rng):
+    width = rng.choice((16, 32, 64, 320))
+    height = rng.choice((8, 16, 64, 200))
+    depth = rng.randint(1, 5)
+    bmhd = struct.pack(">HHhhBBBBHBBhh", width, height, 0, 0, depth, 0, 0, 0,
+                       0, 10, 11, width, height)
+    cmap = bytes(rng.getrandbits(8) for _ in range(3 << depth))
+    row = ((width + 15) // 16) * 2
+    body = bytes(rng.getrandbits(8) for _ in range(row * depth * height))
+    return iff_form(b"ILBM", [iff_chunk(b"BMHD", bmhd), iff_chunk(b"CMAP", cmap),
+                              iff_chunk(b"BODY", body)])
+
+
+def svx_file(rng):
+    samples = rng.randint(64, 8192)
+    vhdr = struct.pack(">LLLHBBL", samples, 0, 0, 8363, 1, 0, 0x10000)
+    body = bytes(rng.getrandbits(8) for _ in range(samples))
+    return iff_form(b"8SVX", [iff_chunk(b"VHDR", vhdr), iff_chunk(b"BODY", body)])
+
+
+def disk_object(rng, do_type, default_tool):
+    """A DiskObject with a 16x8x2 image and a default tool, as icon.library
+    writes old-style icons"""
+    width, height, depth = 16, 8, 2
+    gadget = struct.pack(">LhhhhHHHLLLLLHL",
+                         0, 0, 0, width, height, 0, 1, 1,
+                         1, 0, 0, 0, 0, 0, 1)       # GadgetRender set, UserData 1
+    out = struct.pack(">HH", WB_DISKMAGIC, 1) + gadget
+    out += struct.pack(">BBLLllLLL", do_type, 0, 1 if default_tool else 0, 0,
+                       -0x80000000, -0x80000000, 0, 0, 4096)
+    out += struct.pack(">hhhhhLBBL", 0, 0, width, height, depth, 1, 3, 0, 0)
+    out += bytes(rng.getrandbits(8) for _ in range(((width + 15) // 16) * 2 * height * depth))
+    if default_tool:
+        tool = default_tool.encode("ascii") + b"\0"
+        out += struct.pack(">L", len(tool)) + tool
+    return out
+
+
+def dt_descriptor(name, base_name, pattern, mask, group_id, ident, priority=0):
+    """FORM DTYP with a DTHD; pointers in the header are offsets from the
+    start of the chunk, as datatypes.library's descriptors keep them"""
+    header_size = 32
+    strings = b""
+    offsets = {}
+    for key, value in (("name", name), ("base", base_name), ("pattern", pattern)):
+        offsets[key] = header_size + len(strings)
+        strings += value.encode("ascii") + b"\0"
+    if len(strings) & 1:
+        strings += b"\0"
+    mask_offset = header_size + len(strings)
+    mask_data = b"".join(struct.pack(">h", m) for m in mask)
+    dthd = struct.pack(">LLLLLLhhHH", offsets["name"], offsets["base"], offsets["pattern"],
+                       mask_offset, group_id, ident, len(mask), 0, 0, priority)
+    dthd += strings + mask_data
+    return iff_form(b"DTYP", [iff_chunk(b"NAME", name.encode("ascii") + b"\0"),
+                              iff_chunk(b"DTHD", dthd)])
+
+
+def four_cc(text):
+    return struct.unpack(">L", text.encode("ascii"))[0]
+
+
+def write(path, data):
+    os.makedirs(os.path.dirname(path), exist_ok=True)
+    with open(path, "wb") as f:
+        f.write(data)
+
+
+def make_system(root, rng):
+    system = os.path.join(root, "System")
+    for tool, drawer in TOOLS.items():
+        write(os.path.join(system, drawer, tool), hunk_executable(rng, 4))
+
+    datatypes = os.path.join(system, "Devs", "DataTypes")
+    mask_form = [ord(c) for c in "FORM"] + [-1] * 4
+    write(os.path.join(datatypes, "ILBM"),
+          dt_descriptor("ILBM", "ilbm", "#?", mask_form + [ord(c) for c in "ILBM"],
+                        four_cc("pict"), four_cc("ilbm")))
+    write(os.path.join(datatypes, "8SVX"),
+          dt_descriptor("8SVX", "8svx", "#?", mask_form + [ord(c) for c in "8SVX"],
+                        four_cc("soun"), four_cc("8svx")))
+    write(os.path.join(datatypes, "ascii"),
+          dt_descriptor("ascii", "ascii", "#?.(txt|doc)", [], four_cc("text"),
+                        four_cc("asci")))
+
+    envarc = os.path.join(system, "Prefs", "Env-Archive", "Sys")
+    for kind, tool in DEFICONS.items():
+        write(os.path.join(envarc, "def_%s.info" % kind), disk_object(rng, WBPROJECT, tool))
+
+    ram = os.path.join(root, "RAM")
+    shutil.copytree(os.path.join(system, "Prefs", "Env-Archive"), os.path.join(ram, "Env"))
+    os.makedirs(os.path.join(ram, "T"), exist_ok=True)
+
+
+def make_file(rng, kind):
+    if kind == "exe":
+        return "", hunk_executable(rng, data_longs=rng.randint(0, 64))
+    if kind == "library":
+        return ".library", hunk_executable(rng, data_longs=rng.randint(1, 64))
+    if kind == "device":
+        return ".device", hunk_executable(rng, data_longs=rng.randint(1, 64))
+    if kind == "text":
+        return rng.choice((".txt", ".doc", "", ".readme")), text_file(rng)
+    if kind == "ilbm":
+        return rng.choice((".iff", ".ilbm", "")), ilbm_file(rng)
+    if kind == "8svx":
+        return rng.choice((".8svx", ".iff", "")), svx_file(rng)
+    if kind == "empty":
+        return rng.choice(("", ".txt", ".dat")), b""
+    return None, None
+
+
+def make_work(root, rng, count, per_drawer):
+    work = os.path.join(root, "Work")
+    kinds = [k for k, _ in KINDS]
+    weights = [w for _, w in KINDS]
+    paths = []
+    made = 0
+    while made < count:
+        drawer = "d%02d" % (made // per_drawer)
+        kind = rng.choices(kinds, weights)[0]
+        name = "f%05d" % made
+        if kind == "icon":
+            # A project with its icon; the icon names the tool to use
+            suffix, data = make_file(rng, rng.choice(("text", "ilbm", "empty")))
+            tool = DEFICONS[rng.choice(list(DEFICONS))]
+            write(os.path.join(work, "Corpus", drawer, name + suffix + ".info"),
+                  disk_object(rng, WBPROJECT, tool))
+        else:
+            suffix, data = make_file(rng, kind)
+        name += suffix
+        write(os.path.join(work, "Corpus", drawer, name), data)
+        paths.append("Work:Corpus/%s/%s" % (drawer, name))
+        made += 1
+
+    with open(os.path.join(work, "List"), "w") as f:
+        f.write("\n".join(paths) + "\n")
+    return paths
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("output", help="directory to create (removed first if it exists)")
+    parser.add_argument("--files", type=int, default=2000, help="files in the corpus (2000)")
+    parser.add_argument("--per-drawer", type=int, default=100, help="files per drawer (100)")
+    parser.add_argument("--seed", type=int, default=1, help="random seed (1)")
+    args = parser.parse_args()
+
+    if os.path.exists(args.output):
+        shutil.rmtree(args.output)
+    rng = random.Random(args.seed)
+    make_system(args.output, rng)
+    paths = make_work(args.output, rng, args.files, max(1, args.per_drawer))
+    print("%d files in %s" % (len(paths), args.output))
+
+
+if __name__ == "__main__":
+    main()
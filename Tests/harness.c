@@ -0,0 +1,206 @@
+/*
+ * Open - host test harness
+ *
+ * Copyright (c) 2025 amigazen project
+ * Licensed under BSD 2-Clause License
+ */
+
+/* Runs open.c's main() against the mocks, one scenario per process */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ucontext.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include "mock.h"
+
+int open_main(int argc, char **argv);
+
+/* open.c's initialised and zeroed data, renamed by objcopy so each run */
+/* starts from the state the loader would give it */
+extern char __start_open_data[];
+extern char __stop_open_data[];
+extern char __start_open_bss[];
+extern char __stop_open_bss[];
+
+static char *dataSnapshot = NULL;
+
+/* open.c runs on a stack of its own, filled with a pattern so the */
+/* deepest point it reached can be measured - 4096 bytes is what the */
+/* Amiga build asks for */
+#define RUN_STACK_SIZE (1024 * 1024)
+#define STACK_PATTERN  0xA5
+
+static UBYTE runStack[RUN_STACK_SIZE] __attribute__((aligned(16)));
+static ucontext_t harnessContext;
+static ucontext_t openContext;
+static int runArgc;
+static char **runArgv;
+static int runResult;
+static ULONG stackUsed = 0;
+
+static struct ExecBase execBase;
+static struct DosLibrary dosBase;
+static struct MockNode *currentDir = NULL;
+
+static const char *scenarioName = "";
+
+VOID MockCheck(int ok, const char *what, const char *file, int line)
+{
+    LONG i;
+
+    if (!ok) {
+        fflush(stdout);
+        fprintf(stderr, "FAIL %s: %s (%s:%d)\n", scenarioName, what, file, line);
+        if (*MockOutput()) {
+            fprintf(stderr, "--- output ---\n%s", MockOutput());
+        }
+        if (*MockErrors()) {
+            fprintf(stderr, "--- error output ---\n%s", MockErrors());
+        }
+        for (i = 0; i < MockLaunchCount(); i++) {
+            fprintf(stderr, "--- launch %s \"%s\" \"%s\"\n",
+                    MockLaunchAt(i)->how, MockLaunchAt(i)->what, MockLaunchAt(i)->arg);
+        }
+        _exit(1);
+    }
+}
+
+VOID MockCheckCalls(const char *function, ULONG expected, const char *file, int line)
+{
+    char what[160];
+
+    snprintf(what, sizeof(what), "%s() called %lu times, expected %lu",
+             function, (unsigned long)MockCalls(function), (unsigned long)expected);
+    MockCheck(MockCalls(function) == expected, what, file, line);
+}
+
+VOID MockCheckText(const char *haystack, const char *needle, const char *where, const char *file, int line)
+{
+    char what[512];
+
+    snprintf(what, sizeof(what), "%s contains \"%s\"", where, needle);
+    MockCheck(strstr(haystack, needle) != NULL, what, file, line);
+}
+
+ULONG MockStackUsed(VOID)
+{
+    return stackUsed;
+}
+
+VOID MockCurrentDir(const char *path)
+{
+    currentDir = MockDir(path);
+}
+
+static void RunOpen(void)
+{
+    runResult = open_main(runArgc, runArgv);
+}
+
+static LONG Run(int argc, char **argv, BOOL cli)
+{
+    BPTR initialDir;
+    ULONG i;
+
+    if (!dataSnapshot) {
+        dataSnapshot = malloc(__stop_open_data - __start_open_data);
+        memcpy(dataSnapshot, __start_open_data, __stop_open_data - __start_open_data);
+    }
+    memcpy(__start_open_data, dataSnapshot, __stop_open_data - __start_open_data);
+    memset(__start_open_bss, 0, __stop_open_bss - __start_open_bss);
+
+    execBase.ex_EClockFrequency = 709379;
+    SysBase = &execBase;
+    DOSBase = &dosBase;
+    MockResetExec();
+    MockResetDos(cli, currentDir ? currentDir : MockFind("Work:"));
+    MockResetLibs();
+    initialDir = mock_process.pr_CurrentDir;
+
+    memset(runStack, STACK_PATTERN, sizeof(runStack));
+    runArgc = argc;
+    runArgv = argv;
+    getcontext(&openContext);
+    openContext.uc_stack.ss_sp = runStack;
+    openContext.uc_stack.ss_size = sizeof(runStack);
+    openContext.uc_link = &harnessContext;
+    makecontext(&openContext, RunOpen, 0);
+    swapcontext(&harnessContext, &openContext);
+
+    for (i = 0; i < sizeof(runStack) && runStack[i] == STACK_PATTERN; i++) {
+    }
+    stackUsed = sizeof(runStack) - i;
+
+    MockCheckExec();
+    MockCheckDos(initialDir);
+    MockCheckLibs();
+    return runResult;
+}
+
+LONG MockRun(const char *commandLine)
+{
+    static char *argv[] = { "Open", NULL };
+
+    mock_commandLine = MockArenaString(commandLine);
+    return Run(1, argv, TRUE);
+}
+
+LONG MockRunWorkbench(const char *dir, const char **names, LONG count)
+{
+    struct WBStartup *startup = MockArenaAlloc(sizeof(struct WBStartup));
+    struct WBArg *args = MockArenaAlloc((count + 1) * sizeof(struct WBArg));
+    BPTR lock = MockNewLock(MockDir(dir), TRUE);
+    LONG i;
+
+    args[0].wa_Lock = MockNewLock(MockFind("SYS:C"), TRUE);
+    args[0].wa_Name = (BYTE *)MockArenaString("Open");
+    for (i = 0; i < count; i++) {
+        args[i + 1].wa_Lock = lock;
+        args[i + 1].wa_Name = (BYTE *)MockArenaString(names[i]);
+    }
+    startup->sm_NumArgs = count + 1;
+    startup->sm_ArgList = args;
+    mock_commandLine = NULL;
+    return Run(0, (char **)startup, FALSE);
+}
+
+int main(int argc, char **argv)
+{
+    LONG passed = 0;
+    LONG failed = 0;
+    LONG i;
+
+    for (i = 0; scenarios[i].name; i++) {
+        pid_t pid;
+        int status;
+
+        if (argc > 1 && !strstr(scenarios[i].name, argv[1])) {
+            continue;
+        }
+        fflush(stdout);
+        pid = fork();
+        if (pid == 0) {
+            scenarioName = scenarios[i].name;
+            MockInitWorld();
+            scenarios[i].run();
+            _exit(0);
+        }
+        waitpid(pid, &status, 0);
+        if (WIFEXITED(status) && WEXITSTATUS(status) == 0) {
+            printf("PASS %s\n", scenarios[i].name);
+            passed++;
+        } else {
+            if (WIFSIGNALED(status)) {
+                printf("FAIL %s: signal %d\n", scenarios[i].name, WTERMSIG(status));
+            } else {
+                printf("FAIL %s\n", scenarios[i].name);
+            }
+            failed++;
+        }
+    }
+
+    printf("%ld passed, %ld failed\n", (long)passed, (long)failed);
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,659 @@
+/*
+ * Open - host test harness
+ *
+ * Copyright (c) 2025 amigazen project
+ * Licensed under BSD 2-Clause License
+ */
+
+/* Just enough of the NDK 3.2 headers to compile open.c with the host */
+/* compiler. Types, structures and constants that open.c relies on are */
+/* given their NDK names and values; every library call is implemented by */
+/* the mocks in Tests/mock_*.c. Structure layouts only need to agree with */
+/* the mocks, not with the real system, since nothing leaves the process */
+
+#ifndef OPEN_TESTS_NDK_H
+#define OPEN_TESTS_NDK_H
+
+#include <stddef.h>
+
+/* exec/types.h */
+typedef int LONG;
+typedef unsigned int ULONG;
+typedef short WORD;
+typedef unsigned short UWORD;
+typedef signed char BYTE;
+typedef unsigned char UBYTE;
+typedef short BOOL;
+typedef short SHORT;
+typedef unsigned short USHORT;
+typedef unsigned char *STRPTR;
+typedef const unsigned char *CONST_STRPTR;
+typedef void *APTR;
+typedef long BPTR;
+typedef long BSTR;
+typedef void VOID;
+typedef ULONG Tag;
+typedef ULONG Object;
+typedef unsigned long IPTR;
+
+#define TRUE  1
+#define FALSE 0
+#undef NULL
+#define NULL 0L
+
+#define BADDR(x)  ((APTR)((x) << 2))
+#define MKBADDR(x) (((LONG)(x)) >> 2)
+#define MAKE_ID(a,b,c,d) ((ULONG)(a)<<24 | (ULONG)(b)<<16 | (ULONG)(c)<<8 | (ULONG)(d))
+
+/* exec */
+struct Node {
+    struct Node *ln_Succ;
+    struct Node *ln_Pred;
+    UBYTE ln_Type;
+    BYTE  ln_Pri;
+    char *ln_Name;
+};
+struct MinNode {
+    struct MinNode *mln_Succ;
+    struct MinNode *mln_Pred;
+};
+struct List {
+    struct Node *lh_Head;
+    struct Node *lh_Tail;
+    struct Node *lh_TailPred;
+    UBYTE lh_Type;
+    UBYTE l_pad;
+};
+struct MinList {
+    struct MinNode *mlh_Head;
+    struct MinNode *mlh_Tail;
+    struct MinNode *mlh_TailPred;
+};
+struct Library {
+    struct Node lib_Node;
+    UWORD lib_Version;
+};
+struct ClassLibrary {
+    struct Library cl_Lib;
+};
+struct ExecBase {
+    struct Library LibNode;
+    ULONG ex_EClockFrequency;
+};
+struct DosLibrary {
+    struct Library dl_lib;
+};
+struct IntuitionBase {
+    struct Library LibNode;
+};
+typedef struct IClass {
+    ULONG cl_Reserved;
+} Class;
+struct Message {
+    struct Node mn_Node;
+    struct MsgPort *mn_ReplyPort;
+    UWORD mn_Length;
+};
+struct MsgPort {
+    struct Node mp_Node;
+    UBYTE mp_Flags;
+    UBYTE mp_SigBit;
+    void *mp_SigTask;
+    struct List mp_MsgList;
+};
+struct SignalSemaphore {
+    struct Node ss_Link;
+    WORD ss_NestCount;
+    struct MinList ss_WaitQueue;
+    WORD ss_QueueCount;
+};
+struct Task {
+    struct Node tc_Node;
+};
+struct IORequest {
+    struct Message io_Message;
+    struct Device *io_Device;
+    struct Unit *io_Unit;
+    UWORD io_Command;
+    UBYTE io_Flags;
+    BYTE  io_Error;
+};
+struct Device {
+    struct Library dd_Library;
+};
+
+#define MEMF_ANY      0L
+#define MEMF_PUBLIC   (1L<<0)
+#define MEMF_CHIP     (1L<<1)
+#define MEMF_FAST     (1L<<2)
+#define MEMF_CLEAR    (1L<<16)
+#define MEMF_LARGEST  (1L<<17)
+#define MEMF_TOTAL    (1L<<19)
+
+#define SIGBREAKF_CTRL_C (1L<<12)
+#define SIGBREAKF_CTRL_D (1L<<13)
+
+/* utility/tagitem.h */
+struct TagItem {
+    Tag   ti_Tag;
+    ULONG ti_Data;
+};
+#define TAG_DONE 0L
+#define TAG_END  0L
+#define TAG_USER 0x80000000UL
+
+struct Hook {
+    struct MinNode h_MinNode;
+    ULONG (*h_Entry)();
+    ULONG (*h_SubEntry)();
+    APTR h_Data;
+};
+
+/* dos */
+struct DateStamp {
+    LONG ds_Days;
+    LONG ds_Minute;
+    LONG ds_Tick;
+};
+#define TICKS_PER_SECOND 50
+#define LEN_DATSTRING    16
+#define FORMAT_DOS       0
+struct DateTime {
+    struct DateStamp dat_Stamp;
+    UBYTE dat_Format;
+    UBYTE dat_Flags;
+    STRPTR dat_StrDay;
+    STRPTR dat_StrDate;
+    STRPTR dat_StrTime;
+};
+
+struct FileInfoBlock {
+    LONG fib_DiskKey;
+    LONG fib_DirEntryType;
+    char fib_FileName[108];
+    LONG fib_Protection;
+    LONG fib_EntryType;
+    LONG fib_Size;
+    LONG fib_NumBlocks;
+    struct DateStamp fib_Date;
+    char fib_Comment[80];
+};
+struct ExAllData {
+    struct ExAllData *ed_Next;
+    UBYTE *ed_Name;
+    LONG  ed_Type;
+    ULONG ed_Size;
+    ULONG ed_Prot;
+    ULONG ed_Days;
+    ULONG ed_Mins;
+    ULONG ed_Ticks;
+    UBYTE *ed_Comment;
+};
+struct ExAllControl {
+    ULONG eac_Entries;
+    ULONG eac_LastKey;
+    UBYTE *eac_MatchString;
+    struct Hook *eac_MatchFunc;
+};
+struct InfoData {
+    LONG id_NumSoftErrors;
+    LONG id_UnitNumber;
+    LONG id_DiskState;
+    LONG id_NumBlocks;
+    LONG id_NumBlocksUsed;
+    LONG id_BytesPerBlock;
+    LONG id_DiskType;
+    BPTR id_VolumeNode;
+    LONG id_InUse;
+};
+struct DosPacket {
+    struct Message *dp_Link;
+    struct MsgPort *dp_Port;
+    LONG dp_Type;
+    LONG dp_Res1;
+    LONG dp_Res2;
+    LONG dp_Arg1;
+    LONG dp_Arg2;
+    LONG dp_Arg3;
+    LONG dp_Arg4;
+    LONG dp_Arg5;
+    LONG dp_Arg6;
+    LONG dp_Arg7;
+};
+struct StandardPacket {
+    struct Message sp_Msg;
+    struct DosPacket sp_Pkt;
+};
+struct FileHandle {
+    struct Message *fh_Link;
+    struct MsgPort *fh_Port;
+    struct MsgPort *fh_Type;
+    LONG fh_Buf;
+    LONG fh_Pos;
+    LONG fh_End;
+    LONG fh_Funcs;
+    LONG fh_Func2;
+    LONG fh_Func3;
+    LONG fh_Arg1;
+    LONG fh_Arg2;
+};
+struct FileLock {
+    BPTR fl_Link;
+    LONG fl_Key;
+    LONG fl_Access;
+    struct MsgPort *fl_Task;
+    BPTR fl_Volume;
+};
+struct DosList {
+    BPTR dol_Next;
+    LONG dol_Type;
+    struct MsgPort *dol_Task;
+    BPTR dol_Lock;
+    BSTR dol_Name;
+};
+struct DevProc {
+    struct MsgPort *dvp_Port;
+    BPTR  dvp_Lock;
+    ULONG dvp_Flags;
+    struct DosList *dvp_DevNode;
+};
+#define DVPF_UNLOCK  (1L<<0)
+#define DVPF_ASSIGN  (1L<<1)
+struct CommandLineInterface {
+    LONG cli_Result2;
+    BSTR cli_SetName;
+    BPTR cli_CommandDir;
+    LONG cli_ReturnCode;
+    BSTR cli_CommandName;
+};
+struct Process {
+    struct Task pr_Task;
+    struct MsgPort pr_MsgPort;
+    BPTR pr_CurrentDir;
+    APTR pr_WindowPtr;
+    BPTR pr_CLI;
+    BPTR pr_CES;
+};
+struct Segment {
+    BPTR seg_Next;
+    LONG seg_UC;
+    BPTR seg_Seg;
+    UBYTE seg_Name[4];
+};
+struct RDArgs {
+    LONG RDA_Reserved;
+};
+
+#define DOSTRUE  (-1L)
+#define DOSFALSE 0L
+
+#define ACCESS_READ    (-2L)
+#define SHARED_LOCK    (-2L)
+#define ACCESS_WRITE   (-1L)
+#define MODE_OLDFILE   1005
+#define MODE_NEWFILE   1006
+#define MODE_READWRITE 1004
+#define OFFSET_BEGINNING (-1)
+#define OFFSET_CURRENT   0
+#define OFFSET_END       1
+
+#define ST_ROOT      1
+#define ST_USERDIR   2
+#define ST_SOFTLINK  3
+#define ST_LINKDIR   4
+#define ST_FILE      (-3)
+#define ST_LINKFILE  (-4)
+
+#define ED_NAME       1
+#define ED_TYPE       2
+#define ED_SIZE       3
+#define ED_PROTECTION 4
+#define ED_DATE       5
+#define ED_COMMENT    6
+
+#define DOS_FILEHANDLE   0
+#define DOS_EXALLCONTROL 1
+#define DOS_FIB          2
+#define DOS_STDPKT       3
+
+#define RETURN_OK    0
+#define RETURN_WARN  5
+#define RETURN_ERROR 10
+#define RETURN_FAIL  20
+
+#define ERROR_NO_FREE_STORE        103
+#define ERROR_BAD_TEMPLATE         114
+#define ERROR_BAD_NUMBER           115
+#define ERROR_REQUIRED_ARG_MISSING 116
+#define ERROR_KEY_NEEDS_ARG        117
+#define ERROR_TOO_MANY_ARGS        118
+#define ERROR_LINE_TOO_LONG        120
+#define ERROR_OBJECT_IN_USE        202
+#define ERROR_OBJECT_EXISTS        203
+#define ERROR_DIR_NOT_FOUND        204
+#define ERROR_OBJECT_NOT_FOUND     205
+#define ERROR_INVALID_LOCK         211
+#define ERROR_OBJECT_WRONG_TYPE    212
+#define ERROR_DEVICE_NOT_MOUNTED   218
+#define ERROR_SEEK_ERROR           219
+#define ERROR_NOT_A_DOS_DISK       225
+#define ERROR_NO_DISK              226
+#define ERROR_NO_MORE_ENTRIES      232
+#define ERROR_READ_PROTECTED       224
+#define ERROR_BREAK                304
+
+#define ID_NO_DISK_PRESENT  (-1)
+#define ID_UNREADABLE_DISK  0x42414400
+#define ID_DOS_DISK         0x444F5300
+#define ID_NOT_REALLY_DOS   0x4E444F53
+#define ID_KICKSTART_DISK   0x4B49434B
+
+#define ACTION_READ      'R'
+#define ACTION_WRITE     'W'
+#define ACTION_FINDINPUT 1005
+#define ACTION_END       1007
+#define ACTION_SEEK      1008
+
+#define LDF_READ     (1L<<0)
+#define LDF_WRITE    (1L<<1)
+#define LDF_DEVICES  (1L<<2)
+#define LDF_VOLUMES  (1L<<3)
+#define LDF_ASSIGNS  (1L<<4)
+#define LDF_ALL      (LDF_DEVICES|LDF_VOLUMES|LDF_ASSIGNS)
+
+#define DLT_DEVICE    0
+#define DLT_DIRECTORY 1
+#define DLT_VOLUME    2
+
+#define FIBF_DELETE  (1L<<0)
+#define FIBF_EXECUTE (1L<<1)
+#define FIBF_WRITE   (1L<<2)
+#define FIBF_READ    (1L<<3)
+#define FIBF_ARCHIVE (1L<<4)
+#define FIBF_PURE    (1L<<5)
+#define FIBF_SCRIPT  (1L<<6)
+
+#define CMD_SYSTEM   (-1)
+#define CMD_INTERNAL (-2)
+#define CMD_DISABLED (-999)
+
+#define LOCK_DIFFERENT   (-1)
+#define LOCK_SAME        0
+#define LOCK_SAME_VOLUME 1
+
+#define GVF_GLOBAL_ONLY (1L<<8)
+#define GVF_LOCAL_ONLY  (1L<<9)
+#define GVF_SAVE_VAR    (1L<<12)
+#define LV_VAR          0
+
+#define SYS_Dummy       (TAG_USER + 32)
+#define SYS_Input       (SYS_Dummy + 1)
+#define SYS_Output      (SYS_Dummy + 2)
+#define SYS_Asynch      (SYS_Dummy + 3)
+#define SYS_UserShell   (SYS_Dummy + 4)
+#define SYS_CustomShell (SYS_Dummy + 5)
+
+#define HUNKF_CHIP (1L<<30)
+#define HUNKF_FAST (1L<<31)
+
+/* intuition */
+struct Window {
+    struct Window *NextWindow;
+    WORD  LeftEdge;
+    ULONG Flags;
+    UBYTE *Title;
+    struct Screen *WScreen;
+};
+struct Screen {
+    struct Screen *NextScreen;
+    struct Window *FirstWindow;
+};
+#define WFLG_WBENCHWINDOW 0x02000000
+
+/* classes/requester.h */
+#define REQ_Dummy      (TAG_USER + 0x4000)
+#define REQ_Type       (REQ_Dummy + 1)
+#define REQ_TitleText  (REQ_Dummy + 2)
+#define REQ_BodyText   (REQ_Dummy + 3)
+#define REQ_GadgetText (REQ_Dummy + 4)
+#define REQ_Image      (REQ_Dummy + 9)
+#define REQTYPE_INFO   0
+#define REQIMAGE_ERROR 3
+#define RM_OPENREQ     0x650001
+
+/* workbench */
+struct WBArg {
+    BPTR  wa_Lock;
+    BYTE *wa_Name;
+};
+struct WBStartup {
+    struct Message sm_Message;
+    struct MsgPort *sm_Process;
+    BPTR  sm_Segment;
+    LONG  sm_NumArgs;
+    char *sm_ToolWindow;
+    struct WBArg *sm_ArgList;
+};
+struct DiskObject {
+    UWORD do_Magic;
+    char *do_DefaultTool;
+    char **do_ToolTypes;
+};
+#define WBA_Dummy                  (TAG_USER + 0xA000)
+#define WBOPENA_ArgLock            (WBA_Dummy + 1)
+#define WBOPENA_ArgName            (WBA_Dummy + 2)
+#define WBOPENA_Show               (WBA_Dummy + 75)
+#define WBCTRLA_GetOpenDrawerList  (WBA_Dummy + 17)
+#define WBCTRLA_FreeOpenDrawerList (WBA_Dummy + 18)
+#define DDFLAGS_SHOWALL            2
+#define ICONA_Dummy                (TAG_USER + 0x9000)
+#define ICONA_ErrorCode            (ICONA_Dummy + 1)
+#define ICONGETA_IdentifyBuffer    (ICONA_Dummy + 122)
+#define ICONGETA_IdentifyOnly      (ICONA_Dummy + 123)
+
+/* datatypes */
+struct DataTypeHeader {
+    STRPTR dth_Name;
+    STRPTR dth_BaseName;
+    STRPTR dth_Pattern;
+    WORD  *dth_Mask;
+    ULONG  dth_GroupID;
+    ULONG  dth_ID;
+    WORD   dth_MaskLen;
+    WORD   dth_Pad;
+    UWORD  dth_Flags;
+    UWORD  dth_Priority;
+};
+struct Tool {
+    UWORD  tn_Which;
+    UWORD  tn_Flags;
+    STRPTR tn_Program;
+};
+struct ToolNode {
+    struct Node tn_Node;
+    struct Tool tn_Tool;
+    ULONG tn_Length;
+};
+struct DataType {
+    struct Node dtn_Node1;
+    struct Node dtn_Node2;
+    struct DataTypeHeader *dtn_Header;
+    struct List dtn_ToolList;
+    STRPTR dtn_FunctionName;
+    struct TagItem *dtn_AttrList;
+    ULONG dtn_Length;
+};
+#define DTST_RAM       1
+#define DTST_FILE      2
+#define DTF_TYPE_MASK  0x000F
+#define DTF_BINARY     0x0000
+#define DTF_ASCII      0x0001
+#define DTF_IFF        0x0002
+#define DTF_MISC       0x0003
+#define DTF_CASE       0x0010
+#define DTF_SYSTEM1    0x1000
+#define TF_LAUNCH_MASK 0x000F
+#define TF_SHELL       0x0001
+#define TF_WORKBENCH   0x0002
+#define TF_RX          0x0003
+#define ID_DTYP MAKE_ID('D','T','Y','P')
+#define ID_DTHD MAKE_ID('D','T','H','D')
+#define ID_DTCD MAKE_ID('D','T','C','D')
+#define ID_FORM MAKE_ID('F','O','R','M')
+#define ID_CAT  MAKE_ID('C','A','T',' ')
+#define ID_LIST MAKE_ID('L','I','S','T')
+#define GID_SYSTEM     MAKE_ID('s','y','s','t')
+#define GID_DOCUMENT   MAKE_ID('d','o','c','u')
+#define GID_SOUND      MAKE_ID('s','o','u','n')
+#define GID_INSTRUMENT MAKE_ID('i','n','s','t')
+#define GID_MUSIC      MAKE_ID('m','u','s','i')
+#define GID_PICTURE    MAKE_ID('p','i','c','t')
+#define GID_ANIMATION  MAKE_ID('a','n','i','m')
+#define GID_MOVIE      MAKE_ID('m','o','v','i')
+
+/* devices/timer.h */
+#define TIMERNAME    "timer.device"
+#define UNIT_MICROHZ 0
+#define UNIT_VBLANK  1
+#define UNIT_ECLOCK  2
+struct EClockVal {
+    ULONG ev_hi;
+    ULONG ev_lo;
+};
+struct timerequest {
+    struct IORequest tr_node;
+    struct {
+        ULONG tv_secs;
+        ULONG tv_micro;
+    } tr_time;
+};
+
+/* Library bases - defined by the mocks */
+extern struct ExecBase *SysBase;
+extern struct DosLibrary *DOSBase;
+
+/* exec.library */
+APTR AllocVec(ULONG size, ULONG flags);
+VOID FreeVec(APTR block);
+ULONG AvailMem(ULONG flags);
+struct Library *OpenLibrary(CONST_STRPTR name, ULONG version);
+VOID CloseLibrary(APTR library);
+struct MsgPort *FindPort(CONST_STRPTR name);
+struct Task *FindTask(CONST_STRPTR name);
+ULONG SetSignal(ULONG newSignals, ULONG mask);
+struct MsgPort *CreateMsgPort(VOID);
+VOID DeleteMsgPort(struct MsgPort *port);
+APTR CreateIORequest(struct MsgPort *port, ULONG size);
+VOID DeleteIORequest(APTR ioReq);
+BYTE OpenDevice(CONST_STRPTR name, ULONG unit, struct IORequest *ioReq, ULONG flags);
+VOID CloseDevice(struct IORequest *ioReq);
+struct Message *GetMsg(struct MsgPort *port);
+struct Message *WaitPort(struct MsgPort *port);
+struct SignalSemaphore *FindSemaphore(CONST_STRPTR name);
+VOID AddSemaphore(struct SignalSemaphore *sem);
+VOID RemSemaphore(struct SignalSemaphore *sem);
+VOID InitSemaphore(struct SignalSemaphore *sem);
+VOID ObtainSemaphore(struct SignalSemaphore *sem);
+VOID ObtainSemaphoreShared(struct SignalSemaphore *sem);
+VOID ReleaseSemaphore(struct SignalSemaphore *sem);
+ULONG AttemptSemaphore(struct SignalSemaphore *sem);
+VOID Forbid(VOID);
+VOID Permit(VOID);
+
+/* dos.library */
+BPTR Lock(CONST_STRPTR name, LONG mode);
+VOID UnLock(BPTR lock);
+BPTR ParentDir(BPTR lock);
+BPTR CurrentDir(BPTR lock);
+BPTR GetCurrentDir(VOID);
+BPTR CreateDir(CONST_STRPTR name);
+LONG Examine(BPTR lock, struct FileInfoBlock *fib);
+LONG ExNext(BPTR lock, struct FileInfoBlock *fib);
+LONG ExAll(BPTR lock, struct ExAllData *buffer, LONG size, LONG type, struct ExAllControl *control);
+VOID ExAllEnd(BPTR lock, struct ExAllData *buffer, LONG size, LONG type, struct ExAllControl *control);
+APTR AllocDosObject(ULONG type, struct TagItem *tags);
+VOID FreeDosObject(ULONG type, APTR ptr);
+LONG IoErr(VOID);
+LONG SetIoErr(LONG result);
+LONG Fault(LONG code, CONST_STRPTR header, STRPTR buffer, LONG len);
+LONG PrintFault(LONG code, CONST_STRPTR header);
+LONG Printf(CONST_STRPTR format, ...);
+LONG FPrintf(BPTR fh, CONST_STRPTR format, ...);
+STRPTR FGets(BPTR fh, STRPTR buf, ULONG len);
+LONG FGetC(BPTR fh);
+BPTR Open(CONST_STRPTR name, LONG mode);
+LONG Close(BPTR file);
+LONG Read(BPTR file, APTR buffer, LONG length);
+LONG Write(BPTR file, const void *buffer, LONG length);
+LONG Seek(BPTR file, LONG position, LONG offset);
+BPTR Input(VOID);
+BPTR Output(VOID);
+STRPTR FilePart(CONST_STRPTR path);
+LONG NameFromLock(BPTR lock, STRPTR buffer, LONG len);
+LONG GetVar(CONST_STRPTR name, STRPTR buffer, LONG size, LONG flags);
+LONG SetVar(CONST_STRPTR name, CONST_STRPTR buffer, LONG size, LONG flags);
+struct RDArgs *ReadArgs(CONST_STRPTR arg_template, LONG *array, struct RDArgs *args);
+VOID FreeArgs(struct RDArgs *args);
+LONG System(CONST_STRPTR command, struct TagItem *tags);
+LONG ParsePatternNoCase(CONST_STRPTR pat, STRPTR patbuf, LONG patbuflen);
+LONG MatchPatternNoCase(CONST_STRPTR pat, STRPTR str);
+struct DateStamp *DateStamp(struct DateStamp *date);
+LONG CompareDates(const struct DateStamp *date1, const struct DateStamp *date2);
+LONG DateToStr(struct DateTime *datetime);
+struct DevProc *GetDeviceProc(CONST_STRPTR name, struct DevProc *dp);
+VOID FreeDeviceProc(struct DevProc *dp);
+LONG Info(BPTR lock, struct InfoData *parameterBlock);
+LONG SameLock(BPTR lock1, BPTR lock2);
+struct DosList *LockDosList(ULONG flags);
+VOID UnLockDosList(ULONG flags);
+struct DosList *NextDosEntry(struct DosList *dlist, ULONG flags);
+VOID SendPkt(struct DosPacket *dp, struct MsgPort *port, struct MsgPort *replyport);
+struct MsgPort *GetFileSysTask(VOID);
+BPTR LoadSeg(CONST_STRPTR name);
+VOID UnLoadSeg(BPTR seglist);
+struct Segment *FindSegment(CONST_STRPTR name, const struct Segment *seg, LONG system);
+LONG AddSegment(CONST_STRPTR name, BPTR seg, LONG system);
+LONG RemSegment(struct Segment *seg);
+LONG StrToLong(CONST_STRPTR string, LONG *value);
+struct CommandLineInterface *Cli(VOID);
+
+/* utility.library */
+LONG Stricmp(CONST_STRPTR string1, CONST_STRPTR string2);
+LONG Strnicmp(CONST_STRPTR string1, CONST_STRPTR string2, LONG length);
+UBYTE ToLower(ULONG character);
+UBYTE ToUpper(ULONG character);
+LONG Strncpy(STRPTR dst, CONST_STRPTR src, LONG size);
+LONG Strlcat(STRPTR dst, CONST_STRPTR src, LONG size);
+LONG SNPrintf(STRPTR buffer, LONG size, CONST_STRPTR format, ...);
+
+/* intuition.library */
+APTR NewObject(Class *classPtr, CONST_STRPTR classID, ...);
+VOID DisposeObject(APTR object);
+ULONG DoMethod(Object *obj, ULONG methodID, ...);
+struct Screen *LockPubScreen(CONST_STRPTR name);
+VOID UnlockPubScreen(CONST_STRPTR name, struct Screen *screen);
+VOID WindowToFront(struct Window *window);
+VOID ActivateWindow(struct Window *window);
+ULONG LockIBase(ULONG dontknow);
+VOID UnlockIBase(ULONG ibLock);
+
+/* icon.library */
+struct DiskObject *GetDiskObject(CONST_STRPTR name);
+VOID FreeDiskObject(struct DiskObject *diskobj);
+struct DiskObject *GetIconTagList(CONST_STRPTR name, const struct TagItem *tags);
+
+/* workbench.library */
+BOOL OpenWorkbenchObjectA(CONST_STRPTR name, const struct TagItem *tags);
+BOOL WorkbenchControlA(CONST_STRPTR name, const struct TagItem *tags);
+
+/* datatypes.library */
+struct DataType *ObtainDataTypeA(ULONG type, APTR handle, struct TagItem *attrs);
+VOID ReleaseDataType(struct DataType *dt);
+
+/* requester.class */
+Class *REQUESTER_GetClass(VOID);
+
+/* timer.device */
+ULONG ReadEClock(struct EClockVal *dest);
+
+#endif /* OPEN_TESTS_NDK_H */
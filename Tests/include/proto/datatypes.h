@@ -0,0 +1 @@
+#include "ndk.h"
@@ -0,0 +1,175 @@
+/*
+ * Open - host test harness
+ *
+ * Copyright (c) 2025 amigazen project
+ * Licensed under BSD 2-Clause License
+ */
+
+/* Mock AmigaOS for running open.c on the build host */
+/*
+ * open.c keeps pointers in LONGs (ReadArgs results, tag data, packet
+ * arguments, BPTRs), so everything it can see has to live below 2 GB:
+ * the harness is linked without PIE, all memory handed to open.c comes
+ * from a static arena, and open.c runs on a static stack of its own.
+ */
+
+#ifndef OPEN_TESTS_MOCK_H
+#define OPEN_TESTS_MOCK_H
+
+#include <stdarg.h>
+#include "include/ndk.h"
+
+/* A file or drawer of the scripted file system */
+struct MockNode {
+    char name[108];
+    struct MockNode *parent;
+    struct MockNode *child;
+    struct MockNode *next;
+    struct MockVolume *volume;
+    LONG type;                  /* ST_ROOT, ST_USERDIR or ST_FILE */
+    UBYTE *data;
+    LONG size;
+    LONG capacity;
+    LONG protection;
+    struct DateStamp date;
+    LONG key;
+    char defIconsType[32];      /* What DefIcons identifies it as */
+    char defaultTool[256];      /* For .info files: the icon's default tool */
+    struct MockDataType *dataType;
+    ULONG writes;               /* Times opened for writing */
+};
+
+/* A volume, with its handler and how long each request to it takes */
+struct MockVolume {
+    char name[32];
+    struct MsgPort port;
+    struct MockNode *root;
+    ULONG latency;              /* Virtual microseconds per request */
+    LONG diskType;
+    BOOL mounted;
+    struct DosList dosList;
+    UBYTE *bname;
+};
+
+/* A datatype as datatypes.library would report it */
+struct MockDataType {
+    char name[32];
+    ULONG group;
+    struct {
+        UWORD which;
+        UWORD flags;
+        char program[128];
+    } tools[4];
+    LONG toolCount;
+};
+
+/* One launch through Workbench, System(), LaunchToolA() or a requester */
+struct MockLaunch {
+    char how[16];               /* "workbench", "system", "datatypes", "requester" */
+    char what[256];             /* Tool, command line or requester body */
+    char arg[256];              /* File name passed as the argument */
+};
+
+#define MOCK_MAX_LAUNCHES 64
+
+/* Building the world - only between runs */
+struct MockVolume *MockVolume(const char *name, ULONG latency);
+struct MockNode *MockDir(const char *path);
+struct MockNode *MockFile(const char *path, const void *data, LONG size);
+struct MockNode *MockText(const char *path, const char *text);
+struct MockNode *MockExecutable(const char *path, ULONG codeLongs);
+struct MockNode *MockFind(const char *path);
+VOID MockAssign(const char *name, const char *target, BOOL binding);
+VOID MockIcon(const char *path, const char *defaultTool);
+VOID MockDefIcons(BOOL running);
+VOID MockType(const char *path, const char *defIconsType);
+struct MockDataType *MockDataTypeNew(const char *name, ULONG group);
+VOID MockDataTypeTool(struct MockDataType *dt, UWORD which, UWORD flags, const char *program);
+VOID MockDataTypeOf(const char *path, struct MockDataType *dt);
+VOID MockSetEnv(const char *name, const char *value);
+const char *MockGetEnv(const char *name);
+VOID MockOpenDrawer(const char *path, const char *title);
+VOID MockWindow(const char *title);
+VOID MockCloseWindowSoon(const char *title);
+VOID MockOnSystem(VOID (*hook)(VOID));
+VOID MockStdin(const char *text);
+VOID MockCommandPath(const char *path);
+VOID MockAvailMem(ULONG chip, ULONG fast);
+VOID MockBreakAfterLocks(LONG locks);
+VOID MockSetTime(LONG days, LONG minute);
+VOID MockCurrentDir(const char *path);
+
+/* Running open.c */
+LONG MockRun(const char *commandLine);
+LONG MockRunWorkbench(const char *dir, const char **names, LONG count);
+
+/* Looking at what happened in the last run */
+ULONG MockCalls(const char *function);
+const char *MockOutput(VOID);
+const char *MockErrors(VOID);
+LONG MockLaunchCount(VOID);
+const struct MockLaunch *MockLaunchAt(LONG index);
+ULONG MockStackUsed(VOID);
+ULONG MockStaleLockUses(VOID);
+const char *MockLocalVar(const char *name);
+LONG MockWrites(const char *path);
+LONG MockResidentCount(VOID);
+const char *MockResidentName(LONG index);
+
+/* Assertions - a failed one ends the scenario */
+#define CHECK(cond) MockCheck((cond) ? 1 : 0, #cond, __FILE__, __LINE__)
+#define CHECK_CALLS(fn, expected) MockCheckCalls(fn, expected, __FILE__, __LINE__)
+#define CHECK_OUTPUT(text) MockCheckText(MockOutput(), text, "output", __FILE__, __LINE__)
+#define CHECK_ERRORS(text) MockCheckText(MockErrors(), text, "error output", __FILE__, __LINE__)
+VOID MockCheck(int ok, const char *what, const char *file, int line);
+VOID MockCheckCalls(const char *function, ULONG expected, const char *file, int line);
+VOID MockCheckText(const char *haystack, const char *needle, const char *where, const char *file, int line);
+
+/* Scenarios */
+struct Scenario {
+    const char *name;
+    VOID (*run)(VOID);
+};
+extern const struct Scenario scenarios[];
+
+/* Shared between the mock sources */
+VOID MockCount(const char *function);
+VOID MockAdvance(ULONG micros);
+ULONG MockNow(VOID);
+APTR MockArenaAlloc(ULONG size);
+char *MockArenaString(const char *text);
+LONG MockFormat(char *out, LONG size, const char *format, va_list args);
+VOID MockOut(BPTR fh, const char *text, LONG length);
+struct MockNode *MockLockNode(BPTR lock);
+BPTR MockNewLock(struct MockNode *node, BOOL owned);
+struct MockNode *MockResolve(const char *path, BPTR relative, LONG *errorOut);
+VOID MockLaunchRecord(const char *how, const char *what, const char *arg);
+VOID MockResetRun(VOID);
+VOID MockEndRun(VOID);
+VOID MockInitWorld(VOID);
+VOID MockDeliverPackets(BOOL wait, struct MsgPort *port);
+VOID MockQueuePacket(struct DosPacket *dp, struct MsgPort *replyPort, ULONG due);
+BOOL MockPatternMatch(const char *pattern, const char *name);
+VOID MockBreak(VOID);
+VOID MockArenaFree(APTR memory);
+VOID MockResetExec(VOID);
+VOID MockCheckExec(VOID);
+VOID MockResetDos(BOOL cli, struct MockNode *currentDir);
+VOID MockCheckDos(BPTR initialDir);
+VOID MockResetLibs(VOID);
+VOID MockCheckLibs(VOID);
+
+extern char *mock_commandLine;
+extern struct Process mock_process;
+extern LONG mock_ioErr;
+extern LONG mock_breakAfterLocks;
+extern ULONG mock_staleLockUses;
+extern BOOL mock_defIcons;
+extern ULONG mock_chipFree;
+extern ULONG mock_fastFree;
+extern LONG mock_forbid;
+extern LONG mock_semaphores;
+extern LONG mock_dosListLocks;
+extern LONG mock_ibaseLocks;
+
+#endif /* OPEN_TESTS_MOCK_H */
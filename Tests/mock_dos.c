@@ -0,0 +1,2144 @@
+/*
+ * Open - host test harness
+ *
+ * Copyright (c) 2025 amigazen project
+ * Licensed under BSD 2-Clause License
+ */
+
+/* dos.library over a scripted file system: volumes with a handler and a */
+/* latency, assigns, locks, files, packets, variables and ReadArgs() */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include "mock.h"
+
+#define CALL(name) (MockCount(name), MockAdvance(5))
+
+
+/* Same layout as open.c's own definition */
+struct MockPathEntry {
+    BPTR cpe_Next;
+    BPTR cpe_Lock;
+};
+
+/* Volumes and assigns */
+#define MAX_VOLUMES 8
+#define MAX_ASSIGNS 16
+
+static struct MockVolume *volumes[MAX_VOLUMES];
+static LONG volumeCount = 0;
+
+static struct {
+    char name[32];
+    struct MockNode *target;
+    BOOL binding;
+    BPTR lock;
+} assigns[MAX_ASSIGNS];
+static LONG assignCount = 0;
+
+static LONG nextKey = 1000;
+
+LONG mock_ioErr = 0;
+LONG mock_dosListLocks = 0;
+ULONG mock_staleLockUses = 0;
+char *mock_commandLine = NULL;
+
+static struct CommandLineInterface mockCli;
+static BOOL cliRun = FALSE;
+
+/* Output of the run */
+#define OUTPUT_SIZE (1024 * 1024)
+
+static char outputText[OUTPUT_SIZE];
+static LONG outputLength = 0;
+static char errorText[OUTPUT_SIZE];
+static LONG errorLength = 0;
+static char stdinText[16384];
+
+/* Locks - slots are reused round robin, so a stale BPTR stays dead long */
+/* enough to be caught */
+#define MAX_LOCKS 65536
+
+struct MockLock {
+    struct FileLock fl;
+    struct MockNode *node;
+    BOOL live;
+    BOOL owned;                 /* Belongs to the mock, not to open.c */
+    LONG scan;                  /* Examine()/ExNext() position */
+};
+
+static struct MockLock locks[MAX_LOCKS];
+static LONG nextLock = 0;
+static LONG liveLocks = 0;
+
+/* File handles - the first three are the console */
+#define MAX_HANDLES 256
+#define FH_INPUT  0
+#define FH_OUTPUT 1
+#define FH_ERROR  2
+
+struct MockHandle {
+    struct FileHandle fh;
+    struct MockNode *node;
+    LONG pos;
+    BOOL live;
+    BOOL writing;
+};
+
+static struct MockHandle handles[MAX_HANDLES];
+static LONG liveHandles = 0;
+static LONG stdinPos = 0;
+
+static LONG localVarCount = 0;
+static struct {
+    char name[64];
+    char value[256];
+} localVars[32];
+
+static LONG argsOutstanding = 0;
+static LONG devProcsOutstanding = 0;
+static LONG segmentsLoaded = 0;
+static VOID (*systemHook)(VOID) = NULL;
+
+/* Nodes */
+static struct MockNode *NewNode(struct MockNode *parent, const char *name, LONG type)
+{
+    struct MockNode *node = calloc(1, sizeof(struct MockNode));
+
+    strncpy(node->name, name, sizeof(node->name) - 1);
+    node->type = type;
+    node->key = nextKey++;
+    node->protection = 0;
+    DateStamp(&node->date);
+    node->parent = parent;
+    if (parent) {
+        struct MockNode **link = &parent->child;
+
+        /* Keep directory order stable - append */
+        while (*link) {
+            link = &(*link)->next;
+        }
+        *link = node;
+        node->volume = parent->volume;
+        parent->date = node->date;
+    }
+    return node;
+}
+
+static struct MockNode *FindChild(struct MockNode *dir, const char *name, LONG length)
+{
+    struct MockNode *child;
+
+    for (child = dir->child; child; child = child->next) {
+        if ((LONG)strlen(child->name) == length && strncasecmp(child->name, name, length) == 0) {
+            return child;
+        }
+    }
+    return NULL;
+}
+
+static struct MockVolume *FindVolume(const char *name, LONG length)
+{
+    LONG i;
+
+    for (i = 0; i < volumeCount; i++) {
+        if ((LONG)strlen(volumes[i]->name) == length && strncasecmp(volumes[i]->name, name, length) == 0) {
+            return volumes[i];
+        }
+    }
+    return NULL;
+}
+
+static LONG FindAssign(const char *name, LONG length)
+{
+    LONG i;
+
+    for (i = 0; i < assignCount; i++) {
+        if ((LONG)strlen(assigns[i].name) == length && strncasecmp(assigns[i].name, name, length) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static struct MockNode *BootRoot(VOID)
+{
+    LONG i = FindAssign("SYS", 3);
+
+    if (i >= 0) {
+        return assigns[i].target;
+    }
+    return volumeCount ? volumes[0]->root : NULL;
+}
+
+/* Where a name with a device part starts; NULL if the device is not there */
+static struct MockNode *ResolveDevice(const char *path, LONG length, LONG *errorOut)
+{
+    struct MockVolume *volume = FindVolume(path, length);
+    LONG i;
+
+    if (volume) {
+        if (!volume->mounted) {
+            *errorOut = ERROR_DEVICE_NOT_MOUNTED;
+            if (mock_process.pr_WindowPtr != (APTR)-1L) {
+                MockCount("InsertVolumeRequester");
+            }
+            return NULL;
+        }
+        return volume->root;
+    }
+    i = FindAssign(path, length);
+    if (i >= 0) {
+        if (!assigns[i].target->volume->mounted) {
+            *errorOut = ERROR_DEVICE_NOT_MOUNTED;
+            return NULL;
+        }
+        return assigns[i].target;
+    }
+    if (mock_process.pr_WindowPtr != (APTR)-1L) {
+        MockCount("InsertVolumeRequester");
+    }
+    *errorOut = ERROR_DEVICE_NOT_MOUNTED;
+    return NULL;
+}
+
+static struct MockNode *WalkPath(struct MockNode *node, const char *p, LONG *errorOut);
+static struct MockNode *CreateFile(const char *name, BPTR relative, LONG *errorOut);
+
+struct MockNode *MockResolve(const char *path, BPTR relative, LONG *errorOut)
+{
+    struct MockNode *node;
+    const char *colon = strchr(path, ':');
+    const char *p;
+
+    *errorOut = 0;
+    if (colon) {
+        if (colon == path) {
+            node = relative ? MockLockNode(relative) : MockLockNode(mock_process.pr_CurrentDir);
+            node = node ? node->volume->root : BootRoot();
+        } else {
+            node = ResolveDevice(path, colon - path, errorOut);
+        }
+        p = colon + 1;
+    } else {
+        if (relative) {
+            node = MockLockNode(relative);
+        } else if (mock_process.pr_CurrentDir) {
+            node = MockLockNode(mock_process.pr_CurrentDir);
+        } else {
+            node = BootRoot();
+        }
+        if (!node && !*errorOut) {
+            *errorOut = ERROR_INVALID_LOCK;
+        }
+        p = path;
+    }
+    if (!node) {
+        return NULL;
+    }
+    return WalkPath(node, p, errorOut);
+}
+
+/* Follow the parts of a path from a drawer */
+static struct MockNode *WalkPath(struct MockNode *node, const char *p, LONG *errorOut)
+{
+    /* Leading slashes go up, so does an empty part between two slashes */
+    while (*p == '/') {
+        node = node->parent;
+        if (!node) {
+            *errorOut = ERROR_OBJECT_NOT_FOUND;
+            return NULL;
+        }
+        p++;
+    }
+    while (*p) {
+        const char *end = strchr(p, '/');
+        LONG length = end ? end - p : (LONG)strlen(p);
+
+        if (node->type == ST_FILE) {
+            *errorOut = ERROR_OBJECT_WRONG_TYPE;
+            return NULL;
+        }
+        if (length == 0) {
+            node = node->parent;
+            if (!node) {
+                *errorOut = ERROR_OBJECT_NOT_FOUND;
+                return NULL;
+            }
+        } else {
+            node = FindChild(node, p, length);
+            if (!node) {
+                *errorOut = ERROR_OBJECT_NOT_FOUND;
+                return NULL;
+            }
+        }
+        if (!end) {
+            break;
+        }
+        p = end + 1;
+    }
+    return node;
+}
+
+static VOID Latency(struct MockNode *node)
+{
+    if (node && node->volume) {
+        MockAdvance(node->volume->latency);
+    }
+}
+
+/* World building */
+struct MockVolume *MockVolume(const char *name, ULONG latency)
+{
+    struct MockVolume *volume = MockArenaAlloc(sizeof(struct MockVolume));
+    LONG length = strlen(name);
+
+    strncpy(volume->name, name, sizeof(volume->name) - 1);
+    volume->latency = latency;
+    volume->mounted = TRUE;
+    volume->diskType = ID_DOS_DISK;
+    volume->port.mp_Node.ln_Name = volume->name;
+    volume->root = NewNode(NULL, name, ST_ROOT);
+    volume->root->volume = volume;
+    volume->bname = MockArenaAlloc(length + 2);
+    volume->bname[0] = (UBYTE)length;
+    memcpy(volume->bname + 1, name, length);
+    volume->dosList.dol_Type = DLT_VOLUME;
+    volume->dosList.dol_Task = &volume->port;
+    volume->dosList.dol_Name = MKBADDR(volume->bname);
+    volumes[volumeCount++] = volume;
+    return volume;
+}
+
+struct MockNode *MockFind(const char *path)
+{
+    LONG error;
+    BPTR oldDir = mock_process.pr_CurrentDir;
+    struct MockNode *node;
+
+    mock_process.pr_CurrentDir = NULL;
+    node = MockResolve(path, NULL, &error);
+    mock_process.pr_CurrentDir = oldDir;
+    return node;
+}
+
+/* Split a path into its drawer, created as needed, and the last part */
+static struct MockNode *MakeParent(const char *path, const char **nameOut)
+{
+    char drawer[512];
+    const char *name = strrchr(path, '/');
+    const char *colon = strchr(path, ':');
+
+    if (!name || (colon && name < colon)) {
+        name = colon;
+    }
+    *nameOut = name + 1;
+    memcpy(drawer, path, name - path + (name == colon ? 1 : 0));
+    drawer[name - path + (name == colon ? 1 : 0)] = '\0';
+    return MockDir(drawer);
+}
+
+struct MockNode *MockDir(const char *path)
+{
+    struct MockNode *node = MockFind(path);
+    struct MockNode *parent;
+    const char *name;
+
+    if (node) {
+        return node;
+    }
+    parent = MakeParent(path, &name);
+    return NewNode(parent, name, ST_USERDIR);
+}
+
+struct MockNode *MockFile(const char *path, const void *data, LONG size)
+{
+    struct MockNode *node = MockFind(path);
+    const char *name;
+
+    if (!node) {
+        struct MockNode *parent = MakeParent(path, &name);
+
+        node = NewNode(parent, name, ST_FILE);
+    }
+    free(node->data);
+    node->data = malloc(size + 1);
+    memcpy(node->data, data, size);
+    node->size = size;
+    node->capacity = size + 1;
+    DateStamp(&node->date);
+    return node;
+}
+
+struct MockNode *MockText(const char *path, const char *text)
+{
+    return MockFile(path, text, strlen(text));
+}
+
+/* A HUNK executable: header, one code hunk of codeLongs longwords, end */
+/* The first longword is big-endian as on the Amiga; open.c reads the */
+/* rest of the header as native longwords */
+struct MockNode *MockExecutable(const char *path, ULONG codeLongs)
+{
+    ULONG hunk[8];
+    struct MockNode *node;
+    UBYTE *bytes = (UBYTE *)hunk;
+
+    bytes[0] = 0x00;
+    bytes[1] = 0x00;
+    bytes[2] = 0x03;
+    bytes[3] = 0xF3;
+    hunk[1] = 0;            /* No resident libraries */
+    hunk[2] = 1;            /* Table size */
+    hunk[3] = 0;            /* First hunk */
+    hunk[4] = 0;            /* Last hunk */
+    hunk[5] = codeLongs;    /* Size of hunk 0 */
+    hunk[6] = 0x3E9;
+    hunk[7] = 0;
+    node = MockFile(path, hunk, sizeof(hunk));
+    node->protection = 0;
+    return node;
+}
+
+VOID MockAssign(const char *name, const char *target, BOOL binding)
+{
+    struct MockNode *node = MockDir(target);
+    LONG i = FindAssign(name, strlen(name));
+
+    if (i < 0) {
+        i = assignCount++;
+    }
+    strncpy(assigns[i].name, name, sizeof(assigns[i].name) - 1);
+    assigns[i].target = node;
+    assigns[i].binding = binding;
+    assigns[i].lock = MockNewLock(node, TRUE);
+}
+
+VOID MockIcon(const char *path, const char *defaultTool)
+{
+    char iconPath[512];
+    static const UBYTE iconData[] = { 0xE3, 0x10, 0x00, 0x01 };
+    struct MockNode *node;
+
+    snprintf(iconPath, sizeof(iconPath), "%s.info", path);
+    node = MockFile(iconPath, iconData, sizeof(iconData));
+    strncpy(node->defaultTool, defaultTool ? defaultTool : "", sizeof(node->defaultTool) - 1);
+}
+
+VOID MockType(const char *path, const char *defIconsType)
+{
+    struct MockNode *node = MockFind(path);
+
+    if (node) {
+        strncpy(node->defIconsType, defIconsType, sizeof(node->defIconsType) - 1);
+    }
+}
+
+VOID MockSetEnv(const char *name, const char *value)
+{
+    char path[256];
+
+    snprintf(path, sizeof(path), "ENV:%s", name);
+    MockText(path, value);
+}
+
+const char *MockGetEnv(const char *name)
+{
+    static char value[8192];
+    char path[256];
+    struct MockNode *node;
+
+    snprintf(path, sizeof(path), "%s%s", strchr(name, ':') ? "" : "ENV:", name);
+    node = MockFind(path);
+    if (!node || node->type != ST_FILE) {
+        return NULL;
+    }
+    memcpy(value, node->data, node->size < (LONG)sizeof(value) - 1 ? node->size : (LONG)sizeof(value) - 1);
+    value[node->size < (LONG)sizeof(value) - 1 ? node->size : (LONG)sizeof(value) - 1] = '\0';
+    return value;
+}
+
+LONG MockWrites(const char *path)
+{
+    struct MockNode *node = MockFind(path);
+
+    return node ? (LONG)node->writes : 0;
+}
+
+VOID MockStdin(const char *text)
+{
+    strncpy(stdinText, text, sizeof(stdinText) - 1);
+    stdinPos = 0;
+}
+
+VOID MockCommandPath(const char *path)
+{
+    struct MockPathEntry *entry = MockArenaAlloc(sizeof(struct MockPathEntry));
+    struct MockPathEntry *last;
+
+    entry->cpe_Lock = MockNewLock(MockDir(path), TRUE);
+    if (!mockCli.cli_CommandDir) {
+        mockCli.cli_CommandDir = MKBADDR(entry);
+        return;
+    }
+    for (last = BADDR(mockCli.cli_CommandDir); last->cpe_Next; last = BADDR(last->cpe_Next)) {
+    }
+    last->cpe_Next = MKBADDR(entry);
+}
+
+/* The standard world: a boot volume, RAM: with ENV: and a work volume */
+VOID MockInitWorld(VOID)
+{
+    MockVolume("System", 300);
+    MockVolume("RAM", 20);
+    MockVolume("Work", 800);
+    MockDir("System:C");
+    MockDir("System:Devs/DataTypes");
+    MockDir("System:S");
+    MockDir("System:Utilities");
+    MockDir("System:Prefs/Env-Archive/Sys");
+    MockDir("RAM:Env/Sys");
+    MockDir("RAM:T");
+    MockAssign("SYS", "System:", TRUE);
+    MockAssign("C", "System:C", TRUE);
+    MockAssign("DEVS", "System:Devs", TRUE);
+    MockAssign("S", "System:S", TRUE);
+    MockAssign("ENVARC", "System:Prefs/Env-Archive", TRUE);
+    MockAssign("ENV", "RAM:Env", TRUE);
+    MockAssign("T", "RAM:T", TRUE);
+    MockExecutable("System:Utilities/MultiView", 2000);
+    MockExecutable("System:C/Ed", 3000);
+    MockExecutable("System:C/WBInfo", 1000);
+}
+
+/* Locks */
+BPTR MockNewLock(struct MockNode *node, BOOL owned)
+{
+    struct MockLock *lock;
+    LONG tries;
+
+    for (tries = 0; tries < MAX_LOCKS; tries++) {
+        lock = &locks[nextLock];
+        nextLock = (nextLock + 1) % MAX_LOCKS;
+        if (!lock->live) {
+            memset(lock, 0, sizeof(*lock));
+            lock->node = node;
+            lock->live = TRUE;
+            lock->owned = owned;
+            lock->fl.fl_Key = node->key;
+            lock->fl.fl_Access = SHARED_LOCK;
+            lock->fl.fl_Task = &node->volume->port;
+            lock->fl.fl_Volume = MKBADDR(&node->volume->dosList);
+            if (!owned) {
+                liveLocks++;
+            }
+            return MKBADDR(lock);
+        }
+    }
+    MockCheck(0, "fewer than 65536 locks", __FILE__, __LINE__);
+    return NULL;
+}
+
+static struct MockLock *LockSlot(BPTR lock)
+{
+    struct MockLock *slot = (struct MockLock *)BADDR(lock);
+
+    if (slot < locks || slot >= locks + MAX_LOCKS) {
+        return NULL;
+    }
+    return slot;
+}
+
+/* The node behind a lock; a lock that has been freed counts as stale */
+struct MockNode *MockLockNode(BPTR lock)
+{
+    struct MockLock *slot = LockSlot(lock);
+
+    if (!slot) {
+        return NULL;
+    }
+    if (!slot->live) {
+        mock_staleLockUses++;
+        return NULL;
+    }
+    return slot->node;
+}
+
+ULONG MockStaleLockUses(VOID)
+{
+    return mock_staleLockUses;
+}
+
+static VOID KillLock(struct MockLock *slot)
+{
+    slot->live = FALSE;
+    if (!slot->owned) {
+        liveLocks--;
+    }
+}
+
+BPTR Lock(CONST_STRPTR name, LONG mode)
+{
+    struct MockNode *node;
+    LONG error;
+
+    CALL("Lock");
+    if (mock_breakAfterLocks > 0 && --mock_breakAfterLocks == 0) {
+        MockBreak();
+    }
+    node = MockResolve((const char *)name, NULL, &error);
+    Latency(node);
+    if (!node) {
+        mock_ioErr = error;
+        return NULL;
+    }
+    return MockNewLock(node, FALSE);
+}
+
+VOID UnLock(BPTR lock)
+{
+    struct MockLock *slot = LockSlot(lock);
+
+    CALL("UnLock");
+    if (lock == NULL) {
+        return;
+    }
+    if (!slot || !slot->live || slot->owned) {
+        MockCheck(0, "UnLock() of a live lock of our own", __FILE__, __LINE__);
+        return;
+    }
+    KillLock(slot);
+    mock_ioErr = 0;     /* ACTION_FREE_LOCK's Res2, as DoPkt() leaves it */
+}
+
+BPTR CreateDir(CONST_STRPTR name)
+{
+    struct MockNode *node;
+    LONG error = 0;
+
+    CALL("CreateDir");
+    if (MockResolve((const char *)name, NULL, &error)) {
+        mock_ioErr = ERROR_OBJECT_EXISTS;
+        return NULL;
+    }
+    node = CreateFile((const char *)name, NULL, &error);
+    if (!node) {
+        mock_ioErr = error;
+        return NULL;
+    }
+    Latency(node);
+    node->type = ST_USERDIR;
+    return MockNewLock(node, FALSE);
+}
+
+BPTR ParentDir(BPTR lock)
+{
+    struct MockNode *node = MockLockNode(lock);
+
+    CALL("ParentDir");
+    if (!node) {
+        mock_ioErr = ERROR_INVALID_LOCK;
+        return NULL;
+    }
+    Latency(node);
+    if (!node->parent) {
+        mock_ioErr = 0;
+        return NULL;
+    }
+    return MockNewLock(node->parent, FALSE);
+}
+
+BPTR CurrentDir(BPTR lock)
+{
+    BPTR old = mock_process.pr_CurrentDir;
+
+    CALL("CurrentDir");
+    mock_process.pr_CurrentDir = lock;
+    return old;
+}
+
+BPTR GetCurrentDir(VOID)
+{
+    CALL("GetCurrentDir");
+    return mock_process.pr_CurrentDir;
+}
+
+LONG SameLock(BPTR lock1, BPTR lock2)
+{
+    struct MockNode *node1 = MockLockNode(lock1);
+    struct MockNode *node2 = MockLockNode(lock2);
+
+    CALL("SameLock");
+    if (!node1 || !node2 || node1->volume != node2->volume) {
+        return LOCK_DIFFERENT;
+    }
+    return node1 == node2 ? LOCK_SAME : LOCK_SAME_VOLUME;
+}
+
+LONG NameFromLock(BPTR lock, STRPTR buffer, LONG len)
+{
+    char path[512];
+    char part[512];
+    struct MockNode *node = lock ? MockLockNode(lock) : BootRoot();
+
+    CALL("NameFromLock");
+    if (!node) {
+        mock_ioErr = ERROR_INVALID_LOCK;
+        return DOSFALSE;
+    }
+    path[0] = '\0';
+    for (; node->parent; node = node->parent) {
+        snprintf(part, sizeof(part), "%s%s%s", node->name, path[0] ? "/" : "", path);
+        strcpy(path, part);
+    }
+    snprintf(part, sizeof(part), "%s:%s", node->volume->name, path);
+    if ((LONG)strlen(part) >= len) {
+        mock_ioErr = ERROR_LINE_TOO_LONG;
+        return DOSFALSE;
+    }
+    strcpy((char *)buffer, part);
+    return DOSTRUE;
+}
+
+static VOID FillFib(struct MockNode *node, struct FileInfoBlock *fib)
+{
+    memset(fib, 0, sizeof(*fib));
+    fib->fib_DiskKey = node->key;
+    fib->fib_DirEntryType = node->type;
+    fib->fib_EntryType = node->type;
+    strncpy(fib->fib_FileName, node->name, sizeof(fib->fib_FileName) - 1);
+    fib->fib_Protection = node->protection;
+    fib->fib_Size = node->type == ST_FILE ? node->size : 0;
+    fib->fib_NumBlocks = (fib->fib_Size + 511) / 512;
+    fib->fib_Date = node->date;
+}
+
+LONG Examine(BPTR lock, struct FileInfoBlock *fib)
+{
+    struct MockNode *node = MockLockNode(lock);
+
+    CALL("Examine");
+    if (!node) {
+        mock_ioErr = ERROR_INVALID_LOCK;
+        return DOSFALSE;
+    }
+    Latency(node);
+    FillFib(node, fib);
+    LockSlot(lock)->scan = 0;
+    return DOSTRUE;
+}
+
+LONG ExNext(BPTR lock, struct FileInfoBlock *fib)
+{
+    struct MockNode *node = MockLockNode(lock);
+    struct MockNode *child;
+    LONG i;
+
+    CALL("ExNext");
+    if (!node) {
+        mock_ioErr = ERROR_INVALID_LOCK;
+        return DOSFALSE;
+    }
+    Latency(node);
+    for (i = 0, child = node->child; child && i < LockSlot(lock)->scan; i++) {
+        child = child->next;
+    }
+    if (!child) {
+        mock_ioErr = ERROR_NO_MORE_ENTRIES;
+        return DOSFALSE;
+    }
+    LockSlot(lock)->scan++;
+    FillFib(child, fib);
+    return DOSTRUE;
+}
+
+LONG ExAll(BPTR lock, struct ExAllData *buffer, LONG size, LONG type, struct ExAllControl *control)
+{
+    struct MockNode *node = MockLockNode(lock);
+    struct MockNode *child;
+    struct ExAllData *last = NULL;
+    UBYTE *fill = (UBYTE *)buffer;
+    ULONG i;
+
+    CALL("ExAll");
+    if (!node) {
+        mock_ioErr = ERROR_INVALID_LOCK;
+        return DOSFALSE;
+    }
+    if (node->type == ST_FILE) {
+        mock_ioErr = ERROR_OBJECT_WRONG_TYPE;
+        return DOSFALSE;
+    }
+    Latency(node);
+    control->eac_Entries = 0;
+    for (i = 0, child = node->child; child && i < control->eac_LastKey; i++) {
+        child = child->next;
+    }
+    for (; child; child = child->next) {
+        struct ExAllData *ed = (struct ExAllData *)fill;
+        LONG length = (sizeof(struct ExAllData) + strlen(child->name) + 1 + 7) & ~7;
+
+        if (fill + length > (UBYTE *)buffer + size) {
+            break;
+        }
+        control->eac_LastKey++;
+        if (control->eac_MatchString && !MockPatternMatch((const char *)control->eac_MatchString, child->name)) {
+            continue;
+        }
+        memset(ed, 0, sizeof(*ed));
+        ed->ed_Name = (UBYTE *)(ed + 1);
+        strcpy((char *)ed->ed_Name, child->name);
+        ed->ed_Type = child->type;
+        ed->ed_Size = child->type == ST_FILE ? child->size : 0;
+        ed->ed_Prot = child->protection;
+        ed->ed_Days = child->date.ds_Days;
+        ed->ed_Mins = child->date.ds_Minute;
+        ed->ed_Ticks = child->date.ds_Tick;
+        if (last) {
+            last->ed_Next = ed;
+        }
+        last = ed;
+        fill += length;
+        control->eac_Entries++;
+    }
+    if (!child) {
+        mock_ioErr = ERROR_NO_MORE_ENTRIES;
+        return DOSFALSE;
+    }
+    return DOSTRUE;
+}
+
+VOID ExAllEnd(BPTR lock, struct ExAllData *buffer, LONG size, LONG type, struct ExAllControl *control)
+{
+    CALL("ExAllEnd");
+    control->eac_LastKey = 0;
+}
+
+LONG Info(BPTR lock, struct InfoData *info)
+{
+    struct MockNode *node = MockLockNode(lock);
+
+    CALL("Info");
+    if (!node) {
+        mock_ioErr = ERROR_INVALID_LOCK;
+        return DOSFALSE;
+    }
+    Latency(node);
+    memset(info, 0, sizeof(*info));
+    info->id_DiskType = node->volume->diskType;
+    info->id_BytesPerBlock = 512;
+    info->id_NumBlocks = 100000;
+    info->id_VolumeNode = MKBADDR(&node->volume->dosList);
+    return DOSTRUE;
+}
+
+/* DOS list */
+static struct DosList dosListHead;
+
+struct DosList *LockDosList(ULONG flags)
+{
+    CALL("LockDosList");
+    mock_dosListLocks++;
+    return &dosListHead;
+}
+
+VOID UnLockDosList(ULONG flags)
+{
+    CALL("UnLockDosList");
+    mock_dosListLocks--;
+}
+
+struct DosList *NextDosEntry(struct DosList *dlist, ULONG flags)
+{
+    LONG i = 0;
+
+    CALL("NextDosEntry");
+    if (!(flags & LDF_VOLUMES)) {
+        return NULL;
+    }
+    if (dlist != &dosListHead) {
+        for (i = 0; i < volumeCount && &volumes[i]->dosList != dlist; i++) {
+        }
+        i++;
+    }
+    return i < volumeCount ? &volumes[i]->dosList : NULL;
+}
+
+struct DevProc *GetDeviceProc(CONST_STRPTR name, struct DevProc *dp)
+{
+    struct DevProc *dvp;
+    const char *colon = strchr((const char *)name, ':');
+    struct MockNode *node;
+    LONG error = 0;
+    LONG i;
+
+    CALL("GetDeviceProc");
+    if (dp) {
+        /* Multi-directory assigns are not scripted */
+        mock_ioErr = ERROR_NO_MORE_ENTRIES;
+        return NULL;
+    }
+    dvp = MockArenaAlloc(sizeof(struct DevProc));
+    if (!colon || colon == (const char *)name) {
+        node = MockLockNode(mock_process.pr_CurrentDir);
+        if (!node) {
+            node = BootRoot();
+        }
+        dvp->dvp_Port = &node->volume->port;
+        dvp->dvp_Lock = mock_process.pr_CurrentDir;
+    } else if ((i = FindAssign((const char *)name, colon - (const char *)name)) >= 0) {
+        node = assigns[i].target;
+        if (!node->volume->mounted) {
+            MockArenaFree(dvp);
+            mock_ioErr = ERROR_DEVICE_NOT_MOUNTED;
+            return NULL;
+        }
+        dvp->dvp_Port = &node->volume->port;
+        dvp->dvp_Flags = DVPF_ASSIGN;
+        if (assigns[i].binding) {
+            dvp->dvp_Lock = assigns[i].lock;
+        } else {
+            /* A non-binding assign is looked up again - the lock is ours */
+            dvp->dvp_Lock = MockNewLock(node, TRUE);
+            dvp->dvp_Flags |= DVPF_UNLOCK;
+        }
+    } else {
+        node = ResolveDevice((const char *)name, colon - (const char *)name, &error);
+        if (!node) {
+            MockArenaFree(dvp);
+            mock_ioErr = error;
+            return NULL;
+        }
+        dvp->dvp_Port = &node->volume->port;
+    }
+    devProcsOutstanding++;
+    return dvp;
+}
+
+VOID FreeDeviceProc(struct DevProc *dp)
+{
+    CALL("FreeDeviceProc");
+    if (!dp) {
+        return;
+    }
+    if (dp->dvp_Flags & DVPF_UNLOCK) {
+        LockSlot(dp->dvp_Lock)->live = FALSE;
+    }
+    devProcsOutstanding--;
+    MockArenaFree(dp);
+}
+
+struct MsgPort *GetFileSysTask(VOID)
+{
+    CALL("GetFileSysTask");
+    return &BootRoot()->volume->port;
+}
+
+/* DOS objects */
+APTR AllocDosObject(ULONG type, struct TagItem *tags)
+{
+    APTR object = NULL;
+
+    CALL("AllocDosObject");
+    switch (type) {
+        case DOS_FILEHANDLE:
+            object = AllocVec(sizeof(struct FileHandle), MEMF_CLEAR);
+            break;
+        case DOS_FIB:
+            object = AllocVec(sizeof(struct FileInfoBlock), MEMF_CLEAR);
+            break;
+        case DOS_EXALLCONTROL:
+            object = AllocVec(sizeof(struct ExAllControl), MEMF_CLEAR);
+            break;
+        case DOS_STDPKT: {
+            struct StandardPacket *sp = AllocVec(sizeof(struct StandardPacket), MEMF_CLEAR);
+
+            if (sp) {
+                sp->sp_Msg.mn_Node.ln_Name = (char *)&sp->sp_Pkt;
+                sp->sp_Pkt.dp_Link = &sp->sp_Msg;
+            }
+            object = sp;
+            break;
+        }
+    }
+    return object;
+}
+
+VOID FreeDosObject(ULONG type, APTR ptr)
+{
+    CALL("FreeDosObject");
+    FreeVec(ptr);
+}
+
+/* Errors */
+static const struct {
+    LONG code;
+    const char *text;
+} faults[] = {
+    { ERROR_NO_FREE_STORE, "not enough memory available" },
+    { ERROR_BAD_TEMPLATE, "bad template" },
+    { ERROR_BAD_NUMBER, "bad number" },
+    { ERROR_REQUIRED_ARG_MISSING, "required argument missing" },
+    { ERROR_KEY_NEEDS_ARG, "value after keyword missing" },
+    { ERROR_TOO_MANY_ARGS, "wrong number of arguments" },
+    { ERROR_LINE_TOO_LONG, "argument line invalid or too long" },
+    { ERROR_OBJECT_IN_USE, "object in use" },
+    { ERROR_OBJECT_EXISTS, "object already exists" },
+    { ERROR_DIR_NOT_FOUND, "directory not found" },
+    { ERROR_OBJECT_NOT_FOUND, "object not found" },
+    { ERROR_INVALID_LOCK, "invalid lock" },
+    { ERROR_OBJECT_WRONG_TYPE, "object is not of required type" },
+    { ERROR_DEVICE_NOT_MOUNTED, "device (or volume) is not mounted" },
+    { ERROR_SEEK_ERROR, "seek error" },
+    { ERROR_NOT_A_DOS_DISK, "not a valid DOS disk" },
+    { ERROR_NO_DISK, "no disk in drive" },
+    { ERROR_NO_MORE_ENTRIES, "no more entries in directory" },
+    { ERROR_BREAK, "***Break" },
+    { 0, NULL }
+};
+
+LONG IoErr(VOID)
+{
+    CALL("IoErr");
+    return mock_ioErr;
+}
+
+LONG SetIoErr(LONG result)
+{
+    LONG old = mock_ioErr;
+
+    CALL("SetIoErr");
+    mock_ioErr = result;
+    return old;
+}
+
+LONG Fault(LONG code, CONST_STRPTR header, STRPTR buffer, LONG len)
+{
+    char text[160];
+    const char *message = NULL;
+    LONG i;
+
+    CALL("Fault");
+    for (i = 0; faults[i].text; i++) {
+        if (faults[i].code == code) {
+            message = faults[i].text;
+        }
+    }
+    if (message) {
+        snprintf(text, sizeof(text), "%s%s%s", header ? (const char *)header : "", header ? ": " : "", message);
+    } else {
+        snprintf(text, sizeof(text), "%s%sError %d", header ? (const char *)header : "", header ? ": " : "", (int)code);
+    }
+    if (len <= 0) {
+        return 0;
+    }
+    strncpy((char *)buffer, text, len - 1);
+    buffer[len - 1] = '\0';
+    return strlen((char *)buffer);
+}
+
+LONG PrintFault(LONG code, CONST_STRPTR header)
+{
+    UBYTE text[160];
+
+    CALL("PrintFault");
+    if (code == 0) {
+        return DOSFALSE;
+    }
+    Fault(code, header, text, sizeof(text) - 1);
+    strcat((char *)text, "\n");
+    MockOut(Output(), (const char *)text, strlen((char *)text));
+    return DOSTRUE;
+}
+
+/* Output */
+VOID MockOut(BPTR fh, const char *text, LONG length)
+{
+    struct MockHandle *handle = (struct MockHandle *)BADDR(fh);
+
+    if (handle == &handles[FH_OUTPUT]) {
+        if (outputLength + length < OUTPUT_SIZE) {
+            memcpy(outputText + outputLength, text, length);
+            outputLength += length;
+            outputText[outputLength] = '\0';
+        }
+    } else if (handle == &handles[FH_ERROR]) {
+        if (errorLength + length < OUTPUT_SIZE) {
+            memcpy(errorText + errorLength, text, length);
+            errorLength += length;
+            errorText[errorLength] = '\0';
+        }
+    } else {
+        Write(fh, text, length);
+    }
+}
+
+const char *MockOutput(VOID)
+{
+    return outputText;
+}
+
+const char *MockErrors(VOID)
+{
+    return errorText;
+}
+
+LONG Printf(CONST_STRPTR format, ...)
+{
+    char text[4096];
+    va_list args;
+    LONG length;
+
+    CALL("Printf");
+    va_start(args, format);
+    length = MockFormat(text, sizeof(text), (const char *)format, args);
+    va_end(args);
+    MockOut(Output(), text, length);
+    return length;
+}
+
+LONG FPrintf(BPTR fh, CONST_STRPTR format, ...)
+{
+    char text[4096];
+    va_list args;
+    LONG length;
+
+    CALL("FPrintf");
+    va_start(args, format);
+    length = MockFormat(text, sizeof(text), (const char *)format, args);
+    va_end(args);
+    MockOut(fh, text, length);
+    return length;
+}
+
+BPTR Input(VOID)
+{
+    CALL("Input");
+    return MKBADDR(&handles[FH_INPUT]);
+}
+
+BPTR Output(VOID)
+{
+    CALL("Output");
+    return MKBADDR(&handles[FH_OUTPUT]);
+}
+
+/* Files */
+static struct MockHandle *NewHandle(struct MockNode *node, BOOL writing)
+{
+    LONG i;
+
+    for (i = FH_ERROR + 1; i < MAX_HANDLES; i++) {
+        if (!handles[i].live) {
+            memset(&handles[i], 0, sizeof(handles[i]));
+            handles[i].node = node;
+            handles[i].live = TRUE;
+            handles[i].writing = writing;
+            liveHandles++;
+            return &handles[i];
+        }
+    }
+    MockCheck(0, "fewer than 256 open files", __FILE__, __LINE__);
+    return NULL;
+}
+
+static struct MockHandle *HandleOf(BPTR fh)
+{
+    struct MockHandle *handle = (struct MockHandle *)BADDR(fh);
+
+    if (handle < handles || handle >= handles + MAX_HANDLES || !handle->live) {
+        return NULL;
+    }
+    return handle;
+}
+
+/* Create or truncate a file for writing */
+static struct MockNode *CreateFile(const char *name, BPTR relative, LONG *errorOut)
+{
+    char drawer[512];
+    const char *part = strrchr(name, '/');
+    const char *colon = strchr(name, ':');
+    struct MockNode *node = MockResolve(name, relative, errorOut);
+    struct MockNode *parent;
+
+    if (node) {
+        if (node->type != ST_FILE) {
+            *errorOut = ERROR_OBJECT_WRONG_TYPE;
+            return NULL;
+        }
+        node->size = 0;
+        return node;
+    }
+    if (*errorOut != ERROR_OBJECT_NOT_FOUND) {
+        return NULL;
+    }
+    if (!part || (colon && part < colon)) {
+        part = colon;
+    }
+    if (part) {
+        memcpy(drawer, name, part - name + (part == colon ? 1 : 0));
+        drawer[part - name + (part == colon ? 1 : 0)] = '\0';
+        part++;
+    } else {
+        drawer[0] = '\0';
+        part = name;
+    }
+    parent = MockResolve(drawer, relative, errorOut);
+    if (!parent) {
+        return NULL;
+    }
+    if (parent->type == ST_FILE) {
+        *errorOut = ERROR_OBJECT_WRONG_TYPE;
+        return NULL;
+    }
+    *errorOut = 0;
+    return NewNode(parent, part, ST_FILE);
+}
+
+BPTR Open(CONST_STRPTR name, LONG mode)
+{
+    struct MockNode *node;
+    struct MockHandle *handle;
+    LONG error = 0;
+
+    CALL("Open");
+    if (strcmp((const char *)name, "*") == 0) {
+        return Output();
+    }
+    if (mode == MODE_NEWFILE) {
+        node = CreateFile((const char *)name, NULL, &error);
+        if (node) {
+            node->writes++;
+        }
+    } else {
+        node = MockResolve((const char *)name, NULL, &error);
+        if (node && node->type != ST_FILE) {
+            node = NULL;
+            error = ERROR_OBJECT_WRONG_TYPE;
+        } else if (node && (node->protection & FIBF_READ)) {
+            /* Protection bits are active low - a set bit forbids */
+            node = NULL;
+            error = ERROR_READ_PROTECTED;
+        }
+    }
+    Latency(node);
+    if (!node) {
+        mock_ioErr = error;
+        return NULL;
+    }
+    handle = NewHandle(node, mode != MODE_OLDFILE);
+    return handle ? MKBADDR(handle) : NULL;
+}
+
+LONG Close(BPTR file)
+{
+    struct MockHandle *handle = HandleOf(file);
+
+    CALL("Close");
+    if (file == NULL) {
+        return DOSTRUE;
+    }
+    if (!handle || handle - handles <= FH_ERROR) {
+        MockCheck(0, "Close() of an open file of our own", __FILE__, __LINE__);
+        return DOSFALSE;
+    }
+    if (handle->writing) {
+        DateStamp(&handle->node->date);
+        if (handle->node->parent) {
+            handle->node->parent->date = handle->node->date;
+        }
+    }
+    Latency(handle->node);
+    handle->live = FALSE;
+    liveHandles--;
+    return DOSTRUE;
+}
+
+static LONG ReadHandle(struct MockHandle *handle, APTR buffer, LONG length)
+{
+    LONG available;
+
+    if (handle == &handles[FH_INPUT]) {
+        available = strlen(stdinText) - stdinPos;
+        if (length > available) {
+            length = available;
+        }
+        memcpy(buffer, stdinText + stdinPos, length);
+        stdinPos += length;
+        return length;
+    }
+    available = handle->node->size - handle->pos;
+    if (length > available) {
+        length = available;
+    }
+    if (length < 0) {
+        length = 0;
+    }
+    memcpy(buffer, handle->node->data + handle->pos, length);
+    handle->pos += length;
+    return length;
+}
+
+LONG Read(BPTR file, APTR buffer, LONG length)
+{
+    struct MockHandle *handle = HandleOf(file);
+
+    CALL("Read");
+    if (!handle) {
+        mock_ioErr = ERROR_INVALID_LOCK;
+        return -1;
+    }
+    Latency(handle->node);
+    return ReadHandle(handle, buffer, length);
+}
+
+static LONG WriteHandle(struct MockHandle *handle, const void *buffer, LONG length)
+{
+    struct MockNode *node = handle->node;
+
+    if (handle->pos + length + 1 > node->capacity) {
+        node->capacity = (handle->pos + length + 1) * 2;
+        node->data = realloc(node->data, node->capacity);
+    }
+    memcpy(node->data + handle->pos, buffer, length);
+    handle->pos += length;
+    if (handle->pos > node->size) {
+        node->size = handle->pos;
+    }
+    return length;
+}
+
+LONG Write(BPTR file, const void *buffer, LONG length)
+{
+    struct MockHandle *handle = HandleOf(file);
+
+    CALL("Write");
+    if (handle == &handles[FH_OUTPUT] || handle == &handles[FH_ERROR]) {
+        MockOut(file, buffer, length);
+        return length;
+    }
+    if (!handle || !handle->writing) {
+        mock_ioErr = ERROR_OBJECT_WRONG_TYPE;
+        return -1;
+    }
+    Latency(handle->node);
+    return WriteHandle(handle, buffer, length);
+}
+
+LONG Seek(BPTR file, LONG position, LONG offset)
+{
+    struct MockHandle *handle = HandleOf(file);
+    LONG old;
+    LONG target;
+
+    CALL("Seek");
+    if (!handle || !handle->node) {
+        mock_ioErr = ERROR_SEEK_ERROR;
+        return -1;
+    }
+    old = handle->pos;
+    if (offset == OFFSET_BEGINNING) {
+        target = position;
+    } else if (offset == OFFSET_END) {
+        target = handle->node->size + position;
+    } else {
+        target = old + position;
+    }
+    if (target < 0 || target > handle->node->size) {
+        mock_ioErr = ERROR_SEEK_ERROR;
+        return -1;
+    }
+    handle->pos = target;
+    return old;
+}
+
+LONG FGetC(BPTR fh)
+{
+    struct MockHandle *handle = HandleOf(fh);
+    UBYTE c;
+
+    CALL("FGetC");
+    if (!handle || ReadHandle(handle, &c, 1) != 1) {
+        return -1;
+    }
+    return c;
+}
+
+STRPTR FGets(BPTR fh, STRPTR buf, ULONG len)
+{
+    struct MockHandle *handle = HandleOf(fh);
+    ULONG i = 0;
+    UBYTE c;
+
+    CALL("FGets");
+    if (!handle) {
+        mock_ioErr = ERROR_INVALID_LOCK;
+        return NULL;
+    }
+    while (i + 1 < len && ReadHandle(handle, &c, 1) == 1) {
+        buf[i++] = c;
+        if (c == '\n') {
+            break;
+        }
+    }
+    buf[i] = '\0';
+    return i ? buf : NULL;
+}
+
+STRPTR FilePart(CONST_STRPTR path)
+{
+    const char *slash;
+    const char *colon;
+
+    CALL("FilePart");
+    if (!path) {
+        return NULL;
+    }
+    slash = strrchr((const char *)path, '/');
+    colon = strrchr((const char *)path, ':');
+    if (slash && (!colon || slash > colon)) {
+        return (STRPTR)slash + 1;
+    }
+    if (colon) {
+        return (STRPTR)colon + 1;
+    }
+    return (STRPTR)path;
+}
+
+/* Packets - answered at once, replied after the volume's latency */
+VOID SendPkt(struct DosPacket *dp, struct MsgPort *port, struct MsgPort *replyport)
+{
+    struct MockVolume *volume = NULL;
+    struct MockHandle *handle;
+    LONG i;
+
+    CALL("SendPkt");
+    for (i = 0; i < volumeCount; i++) {
+        if (&volumes[i]->port == port) {
+            volume = volumes[i];
+        }
+    }
+    MockCheck(volume != NULL, "packets only go to a volume's handler", __FILE__, __LINE__);
+    dp->dp_Res1 = DOSFALSE;
+    dp->dp_Res2 = 0;
+
+    switch (dp->dp_Type) {
+        case ACTION_FINDINPUT: {
+            struct FileHandle *fh = (struct FileHandle *)BADDR(dp->dp_Arg1);
+            UBYTE *bname = (UBYTE *)BADDR(dp->dp_Arg3);
+            char name[256];
+            const char *path;
+            struct MockNode *start = volume->root;
+            struct MockNode *node;
+            LONG error = 0;
+
+            memcpy(name, bname + 1, bname[0]);
+            name[bname[0]] = '\0';
+            path = strchr(name, ':') ? strchr(name, ':') + 1 : name;
+            if (dp->dp_Arg2) {
+                start = MockLockNode((BPTR)dp->dp_Arg2);
+                if (!start) {
+                    MockCount("StaleLockPacket");
+                    dp->dp_Res2 = ERROR_INVALID_LOCK;
+                    break;
+                }
+            }
+            node = WalkPath(start, path, &error);
+            if (!node || node->type != ST_FILE) {
+                dp->dp_Res2 = node ? ERROR_OBJECT_WRONG_TYPE : error;
+                break;
+            }
+            handle = NewHandle(node, FALSE);
+            fh->fh_Type = port;
+            fh->fh_Arg1 = (LONG)(handle - handles);
+            dp->dp_Res1 = DOSTRUE;
+            break;
+        }
+        case ACTION_READ:
+            handle = &handles[dp->dp_Arg1];
+            dp->dp_Res1 = ReadHandle(handle, (APTR)(IPTR)(ULONG)dp->dp_Arg2, dp->dp_Arg3);
+            break;
+        case ACTION_END:
+            handle = &handles[dp->dp_Arg1];
+            handle->live = FALSE;
+            liveHandles--;
+            dp->dp_Res1 = DOSTRUE;
+            break;
+        default:
+            dp->dp_Res2 = 209;
+            break;
+    }
+
+    dp->dp_Port = replyport;
+    MockQueuePacket(dp, replyport, volume->latency);
+}
+
+/* Variables */
+static LONG FindLocalVar(const char *name)
+{
+    LONG i;
+
+    for (i = 0; i < localVarCount; i++) {
+        if (strcasecmp(localVars[i].name, name) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+const char *MockLocalVar(const char *name)
+{
+    LONG i = FindLocalVar(name);
+
+    return i >= 0 ? localVars[i].value : NULL;
+}
+
+LONG GetVar(CONST_STRPTR name, STRPTR buffer, LONG size, LONG flags)
+{
+    struct MockNode *node;
+    char path[256];
+    LONG length;
+    LONG i;
+
+    CALL("GetVar");
+    if (!(flags & GVF_GLOBAL_ONLY) && (i = FindLocalVar((const char *)name)) >= 0) {
+        Strncpy(buffer, (STRPTR)localVars[i].value, size);
+        return strlen((char *)buffer);
+    }
+    if (flags & GVF_LOCAL_ONLY) {
+        mock_ioErr = ERROR_OBJECT_NOT_FOUND;
+        return -1;
+    }
+    snprintf(path, sizeof(path), "ENV:%s", (const char *)name);
+    node = MockFind(path);
+    if (!node || node->type != ST_FILE) {
+        mock_ioErr = ERROR_OBJECT_NOT_FOUND;
+        return -1;
+    }
+    Latency(node);
+    for (length = 0; length < node->size && length < size - 1 && node->data[length] != '\n'; length++) {
+        buffer[length] = node->data[length];
+    }
+    buffer[length] = '\0';
+    return length;
+}
+
+LONG SetVar(CONST_STRPTR name, CONST_STRPTR buffer, LONG size, LONG flags)
+{
+    char path[256];
+    LONG i;
+
+    CALL("SetVar");
+    if (size < 0) {
+        size = strlen((const char *)buffer);
+    }
+    if (flags & GVF_LOCAL_ONLY) {
+        i = FindLocalVar((const char *)name);
+        if (i < 0) {
+            i = localVarCount++;
+        }
+        strncpy(localVars[i].name, (const char *)name, sizeof(localVars[i].name) - 1);
+        memset(localVars[i].value, 0, sizeof(localVars[i].value));
+        memcpy(localVars[i].value, buffer, size < 255 ? size : 255);
+        return DOSTRUE;
+    }
+    snprintf(path, sizeof(path), "ENV:%s", (const char *)name);
+    MockFile(path, buffer, size);
+    MockFind(path)->writes++;
+    if (flags & GVF_SAVE_VAR) {
+        snprintf(path, sizeof(path), "ENVARC:%s", (const char *)name);
+        MockFile(path, buffer, size);
+        MockFind(path)->writes++;
+    }
+    return DOSTRUE;
+}
+
+/* ReadArgs() over mock_commandLine */
+#define MAX_ITEMS 32
+#define MAX_MULTI 64
+
+static LONG NextToken(const char **line, char *token, LONG size)
+{
+    const char *p = *line;
+    LONG length = 0;
+
+    while (*p == ' ' || *p == '\t') {
+        p++;
+    }
+    if (!*p) {
+        return -1;
+    }
+    while (*p && *p != ' ' && *p != '\t') {
+        if (*p == '"') {
+            for (p++; *p && *p != '"'; p++) {
+                if (length < size - 1) {
+                    token[length++] = *p;
+                }
+            }
+            if (*p) {
+                p++;
+            }
+        } else {
+            if (length < size - 1) {
+                token[length++] = *p;
+            }
+            p++;
+        }
+    }
+    token[length] = '\0';
+    *line = p;
+    return length;
+}
+
+/* Does key name the template item? Items are "NAME=ALIAS/X/Y" */
+static BOOL ItemNamed(const char *item, const char *key, LONG keyLength)
+{
+    const char *p = item;
+
+    while (*p && *p != '/') {
+        const char *end = p;
+
+        while (*end && *end != '=' && *end != '/') {
+            end++;
+        }
+        if (end - p == keyLength && strncasecmp(p, key, keyLength) == 0) {
+            return TRUE;
+        }
+        p = (*end == '=') ? end + 1 : end;
+    }
+    return FALSE;
+}
+
+static BOOL ItemHas(const char *item, char modifier)
+{
+    const char *p = strchr(item, '/');
+
+    for (; p; p = strchr(p + 1, '/')) {
+        if (toupper((unsigned char)p[1]) == modifier) {
+            return TRUE;
+        }
+    }
+    return FALSE;
+}
+
+static BOOL StoreArg(const char *item, LONG *slot, const char *value)
+{
+    if (ItemHas(item, 'N')) {
+        LONG *number = MockArenaAlloc(sizeof(LONG));
+        char *end;
+
+        *number = strtol(value, &end, 10);
+        if (!*value || *end) {
+            mock_ioErr = ERROR_BAD_NUMBER;
+            return FALSE;
+        }
+        *slot = (LONG)(IPTR)number;
+    } else if (ItemHas(item, 'M')) {
+        STRPTR *array = (STRPTR *)(IPTR)(ULONG)*slot;
+        LONG count = 0;
+
+        if (!array) {
+            array = MockArenaAlloc(MAX_MULTI * sizeof(STRPTR));
+            *slot = (LONG)(IPTR)array;
+        }
+        while (array[count]) {
+            count++;
+        }
+        if (count < MAX_MULTI - 1) {
+            array[count] = (STRPTR)MockArenaString(value);
+        }
+    } else {
+        *slot = (LONG)(IPTR)MockArenaString(value);
+    }
+    return TRUE;
+}
+
+struct RDArgs *ReadArgs(CONST_STRPTR arg_template, LONG *array, struct RDArgs *args)
+{
+    char templ[512];
+    char *items[MAX_ITEMS];
+    LONG itemCount = 0;
+    char token[512];
+    const char *line = mock_commandLine ? mock_commandLine : "";
+    BOOL filled[MAX_ITEMS];
+    char *p;
+    LONG i;
+
+    CALL("ReadArgs");
+    strncpy(templ, (const char *)arg_template, sizeof(templ) - 1);
+    templ[sizeof(templ) - 1] = '\0';
+    for (p = templ; p && itemCount < MAX_ITEMS; ) {
+        items[itemCount++] = p;
+        p = strchr(p, ',');
+        if (p) {
+            *p++ = '\0';
+        }
+    }
+    memset(filled, 0, sizeof(filled));
+
+    while (NextToken(&line, token, sizeof(token)) >= 0) {
+        char *equals = strchr(token, '=');
+        LONG item = -1;
+
+        /* KEY=value */
+        if (equals) {
+            for (i = 0; i < itemCount; i++) {
+                if (ItemNamed(items[i], token, equals - token)) {
+                    item = i;
+                    break;
+                }
+            }
+            if (item >= 0) {
+                if (ItemHas(items[item], 'S')) {
+                    mock_ioErr = ERROR_TOO_MANY_ARGS;
+                    return NULL;
+                }
+                if (!StoreArg(items[item], &array[item], equals + 1)) {
+                    return NULL;
+                }
+                filled[item] = TRUE;
+                continue;
+            }
+        }
+
+        /* KEY value, or a switch */
+        for (i = 0; i < itemCount; i++) {
+            if (ItemNamed(items[i], token, strlen(token))) {
+                item = i;
+                break;
+            }
+        }
+        if (item >= 0) {
+            if (ItemHas(items[item], 'S')) {
+                array[item] = DOSTRUE;
+            } else {
+                if (NextToken(&line, token, sizeof(token)) < 0) {
+                    mock_ioErr = ERROR_KEY_NEEDS_ARG;
+                    return NULL;
+                }
+                if (!StoreArg(items[item], &array[item], token)) {
+                    return NULL;
+                }
+            }
+            filled[item] = TRUE;
+            continue;
+        }
+
+        /* Positional */
+        for (i = 0; i < itemCount; i++) {
+            if (!ItemHas(items[i], 'K') && !ItemHas(items[i], 'S') &&
+                (!filled[i] || ItemHas(items[i], 'M'))) {
+                item = i;
+                break;
+            }
+        }
+        if (item < 0) {
+            mock_ioErr = ERROR_TOO_MANY_ARGS;
+            return NULL;
+        }
+        if (!StoreArg(items[item], &array[item], token)) {
+            return NULL;
+        }
+        filled[item] = TRUE;
+    }
+
+    for (i = 0; i < itemCount; i++) {
+        if (ItemHas(items[i], 'A') && !filled[i]) {
+            mock_ioErr = ERROR_REQUIRED_ARG_MISSING;
+            return NULL;
+        }
+    }
+
+    argsOutstanding++;
+    return MockArenaAlloc(sizeof(struct RDArgs));
+}
+
+VOID FreeArgs(struct RDArgs *args)
+{
+    CALL("FreeArgs");
+    if (args) {
+        argsOutstanding--;
+    }
+}
+
+LONG StrToLong(CONST_STRPTR string, LONG *value)
+{
+    const char *p = (const char *)string;
+    char *end;
+
+    CALL("StrToLong");
+    while (*p == ' ' || *p == '\t') {
+        p++;
+    }
+    *value = strtol(p, &end, 10);
+    if (end == p) {
+        return -1;
+    }
+    return end - (const char *)string;
+}
+
+LONG System(CONST_STRPTR command, struct TagItem *tags)
+{
+    VOID (*hook)(VOID) = systemHook;
+
+    CALL("System");
+    MockLaunchRecord("system", (const char *)command, "");
+    systemHook = NULL;
+    if (hook) {
+        hook();
+    }
+    return 0;
+}
+
+/* Run something once, as the next System() command - e.g. another Open */
+VOID MockOnSystem(VOID (*hook)(VOID))
+{
+    systemHook = hook;
+}
+
+struct CommandLineInterface *Cli(VOID)
+{
+    CALL("Cli");
+    return cliRun ? &mockCli : NULL;
+}
+
+/* Patterns - kept in source form, matched without regard to case */
+static const char *SkipItem(const char *p)
+{
+    LONG depth = 0;
+
+    if (*p == '\'') {
+        return p[1] ? p + 2 : p + 1;
+    }
+    if (*p == '[') {
+        while (*p && *p != ']') {
+            p++;
+        }
+        return *p ? p + 1 : p;
+    }
+    if (*p == '(') {
+        do {
+            if (*p == '(') {
+                depth++;
+            } else if (*p == ')') {
+                depth--;
+            }
+            p++;
+        } while (*p && depth > 0);
+        return p;
+    }
+    if (*p == '#') {
+        return SkipItem(p + 1);
+    }
+    return *p ? p + 1 : p;
+}
+
+static BOOL MatchHere(const char *p, const char *pend, const char *s, const char *send);
+
+/* Does the single item [p, pend) match exactly [s, send)? */
+static BOOL MatchItem(const char *p, const char *pend, const char *s, const char *send)
+{
+    if (*p == '(') {
+        const char *alt = p + 1;
+        const char *q;
+        LONG depth = 0;
+
+        /* Try each |-separated alternative */
+        for (q = alt; q < pend - 1; q++) {
+            if (*q == '(') {
+                depth++;
+            } else if (*q == ')') {
+                depth--;
+            } else if (*q == '|' && depth == 0) {
+                if (MatchHere(alt, q, s, send)) {
+                    return TRUE;
+                }
+                alt = q + 1;
+            }
+        }
+        return MatchHere(alt, pend - 1, s, send);
+    }
+    if (send - s != 1) {
+        return FALSE;
+    }
+    if (*p == '?') {
+        return TRUE;
+    }
+    if (*p == '\'') {
+        return tolower((unsigned char)p[1]) == tolower((unsigned char)*s);
+    }
+    if (*p == '[') {
+        const char *q = p + 1;
+        BOOL negate = FALSE;
+        BOOL in = FALSE;
+
+        if (*q == '~') {
+            negate = TRUE;
+            q++;
+        }
+        for (; q < pend - 1; q++) {
+            if (q[1] == '-' && q + 2 < pend - 1) {
+                if (tolower((unsigned char)*s) >= tolower((unsigned char)q[0]) &&
+                    tolower((unsigned char)*s) <= tolower((unsigned char)q[2])) {
+                    in = TRUE;
+                }
+                q += 2;
+            } else if (tolower((unsigned char)*q) == tolower((unsigned char)*s)) {
+                in = TRUE;
+            }
+        }
+        return in != negate;
+    }
+    return tolower((unsigned char)*p) == tolower((unsigned char)*s);
+}
+
+static BOOL MatchHere(const char *p, const char *pend, const char *s, const char *send)
+{
+    const char *end;
+    const char *k;
+
+    if (p >= pend) {
+        return s == send;
+    }
+    if (*p == '~') {
+        return !MatchHere(p + 1, pend, s, send);
+    }
+    if (*p == '%') {
+        return MatchHere(p + 1, pend, s, send);
+    }
+    if (*p == '#') {
+        const char *item = p + 1;
+
+        end = SkipItem(item);
+        if (MatchHere(end, pend, s, send)) {
+            return TRUE;
+        }
+        for (k = s + 1; k <= send; k++) {
+            if (MatchItem(item, end, s, k) && MatchHere(p, pend, k, send)) {
+                return TRUE;
+            }
+        }
+        return FALSE;
+    }
+    end = SkipItem(p);
+    for (k = s; k <= send; k++) {
+        if (MatchItem(p, end, s, k) && MatchHere(end, pend, k, send)) {
+            return TRUE;
+        }
+    }
+    return FALSE;
+}
+
+BOOL MockPatternMatch(const char *pattern, const char *name)
+{
+    return MatchHere(pattern, pattern + strlen(pattern), name, name + strlen(name));
+}
+
+LONG ParsePatternNoCase(CONST_STRPTR pat, STRPTR patbuf, LONG patbuflen)
+{
+    LONG length = strlen((const char *)pat);
+
+    CALL("ParsePatternNoCase");
+    if (patbuflen < length * 2 + 2) {
+        return -1;
+    }
+    strcpy((char *)patbuf, (const char *)pat);
+    return strpbrk((const char *)pat, "#?()|[]~%'") ? 1 : 0;
+}
+
+LONG MatchPatternNoCase(CONST_STRPTR pat, STRPTR str)
+{
+    CALL("MatchPatternNoCase");
+    return MockPatternMatch((const char *)pat, (const char *)str) ? DOSTRUE : DOSFALSE;
+}
+
+/* Dates */
+LONG CompareDates(const struct DateStamp *date1, const struct DateStamp *date2)
+{
+    CALL("CompareDates");
+    if (date1->ds_Days != date2->ds_Days) {
+        return date1->ds_Days > date2->ds_Days ? -1 : 1;
+    }
+    if (date1->ds_Minute != date2->ds_Minute) {
+        return date1->ds_Minute > date2->ds_Minute ? -1 : 1;
+    }
+    if (date1->ds_Tick != date2->ds_Tick) {
+        return date1->ds_Tick > date2->ds_Tick ? -1 : 1;
+    }
+    return 0;
+}
+
+LONG DateToStr(struct DateTime *datetime)
+{
+    CALL("DateToStr");
+    if (datetime->dat_StrDate) {
+        sprintf((char *)datetime->dat_StrDate, "%05d", (int)datetime->dat_Stamp.ds_Days);
+    }
+    if (datetime->dat_StrTime) {
+        sprintf((char *)datetime->dat_StrTime, "%02d:%02d:%02d",
+                (int)(datetime->dat_Stamp.ds_Minute / 60), (int)(datetime->dat_Stamp.ds_Minute % 60),
+                (int)(datetime->dat_Stamp.ds_Tick / TICKS_PER_SECOND));
+    }
+    if (datetime->dat_StrDay) {
+        strcpy((char *)datetime->dat_StrDay, "Monday");
+    }
+    return DOSTRUE;
+}
+
+/* Resident segments */
+struct MockSegment {
+    struct Segment seg;
+    UBYTE name[64];
+};
+
+#define MAX_SEGMENTS 32
+
+static struct MockSegment *residents[MAX_SEGMENTS];
+static LONG residentCount = 0;
+
+BPTR LoadSeg(CONST_STRPTR name)
+{
+    struct MockNode *node;
+    LONG error;
+    ULONG *seglist;
+
+    CALL("LoadSeg");
+    node = MockResolve((const char *)name, NULL, &error);
+    if (!node || node->type != ST_FILE || node->size < 4 ||
+        node->data[0] != 0 || node->data[1] != 0 || node->data[2] != 3 || node->data[3] != 0xF3) {
+        mock_ioErr = node ? ERROR_OBJECT_WRONG_TYPE : error;
+        return NULL;
+    }
+    Latency(node);
+    MockAdvance(node->size);
+    seglist = MockArenaAlloc(16);
+    seglist[1] = (ULONG)node->key;
+    segmentsLoaded++;
+    return MKBADDR(seglist);
+}
+
+VOID UnLoadSeg(BPTR seglist)
+{
+    CALL("UnLoadSeg");
+    if (seglist) {
+        segmentsLoaded--;
+        MockArenaFree(BADDR(seglist));
+    }
+}
+
+struct Segment *FindSegment(CONST_STRPTR name, const struct Segment *seg, LONG system)
+{
+    LONG i = 0;
+
+    CALL("FindSegment");
+    if (seg) {
+        for (i = 0; i < residentCount && &residents[i]->seg != seg; i++) {
+        }
+        i++;
+    }
+    for (; i < residentCount; i++) {
+        UBYTE *bname = residents[i]->seg.seg_Name;
+
+        if (bname[0] == strlen((const char *)name) && strncasecmp((char *)bname + 1, (const char *)name, bname[0]) == 0) {
+            return &residents[i]->seg;
+        }
+    }
+    return NULL;
+}
+
+LONG AddSegment(CONST_STRPTR name, BPTR seg, LONG system)
+{
+    struct MockSegment *resident;
+    LONG length = strlen((const char *)name);
+
+    CALL("AddSegment");
+    if (residentCount == MAX_SEGMENTS || length > 62) {
+        return DOSFALSE;
+    }
+    resident = MockArenaAlloc(sizeof(struct MockSegment));
+    resident->seg.seg_Seg = seg;
+    resident->seg.seg_UC = system ? CMD_SYSTEM : 0;
+    resident->seg.seg_Name[0] = (UBYTE)length;
+    memcpy(resident->seg.seg_Name + 1, name, length);
+    residents[residentCount++] = resident;
+    segmentsLoaded--;
+    return DOSTRUE;
+}
+
+LONG RemSegment(struct Segment *seg)
+{
+    LONG i;
+
+    CALL("RemSegment");
+    for (i = 0; i < residentCount; i++) {
+        if (&residents[i]->seg == seg) {
+            if (seg->seg_UC != 0) {
+                return DOSFALSE;
+            }
+            residents[i] = residents[--residentCount];
+            return DOSTRUE;
+        }
+    }
+    return DOSFALSE;
+}
+
+/* Names made resident, for the scenarios */
+LONG MockResidentCount(VOID)
+{
+    return residentCount;
+}
+
+const char *MockResidentName(LONG index)
+{
+    static char name[64];
+    UBYTE *bname = residents[index]->seg.seg_Name;
+
+    memcpy(name, bname + 1, bname[0]);
+    name[bname[0]] = '\0';
+    return name;
+}
+
+/* Run bookkeeping */
+VOID MockResetDos(BOOL cli, struct MockNode *currentDir)
+{
+    LONG i;
+
+    outputLength = 0;
+    outputText[0] = '\0';
+    errorLength = 0;
+    errorText[0] = '\0';
+    mock_ioErr = 0;
+    mock_staleLockUses = 0;
+    localVarCount = 0;
+    cliRun = cli;
+    for (i = 0; i <= FH_ERROR; i++) {
+        handles[i].live = TRUE;
+        handles[i].node = NULL;
+    }
+    mock_process.pr_CurrentDir = currentDir ? MockNewLock(currentDir, TRUE) : NULL;
+    mock_process.pr_CLI = cli ? MKBADDR(&mockCli) : NULL;
+    mock_process.pr_CES = cli ? MKBADDR(&handles[FH_ERROR]) : NULL;
+}
+
+VOID MockCheckDos(BPTR initialDir)
+{
+    MockCheck(mock_process.pr_CurrentDir == initialDir, "current directory restored", __FILE__, __LINE__);
+    MockCheck(liveLocks == 0, "every lock unlocked", __FILE__, __LINE__);
+    MockCheck(liveHandles == 0, "every file closed", __FILE__, __LINE__);
+    MockCheck(argsOutstanding == 0, "FreeArgs() called", __FILE__, __LINE__);
+    MockCheck(devProcsOutstanding == 0, "FreeDeviceProc() called", __FILE__, __LINE__);
+    MockCheck(mock_dosListLocks == 0, "DOS list unlocked", __FILE__, __LINE__);
+    MockCheck(segmentsLoaded == 0, "every LoadSeg() unloaded or made resident", __FILE__, __LINE__);
+    if (liveLocks) {
+        LONG i;
+
+        for (i = 0; i < MAX_LOCKS; i++) {
+            if (locks[i].live && !locks[i].owned) {
+                fprintf(stderr, "  lock left on %s\n", locks[i].node->name);
+                KillLock(&locks[i]);
+            }
+        }
+    }
+}
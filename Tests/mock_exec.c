@@ -0,0 +1,646 @@
+/*
+ * Open - host test harness
+ *
+ * Copyright (c) 2025 amigazen project
+ * Licensed under BSD 2-Clause License
+ */
+
+/* exec.library and timer.device: memory, ports, packets, semaphores and */
+/* a virtual clock that only moves when open.c calls the system */
+
+#include <stdio.h>
+#include <string.h>
+#include "mock.h"
+
+struct ExecBase *SysBase;
+struct DosLibrary *DOSBase;
+struct IntuitionBase *IntuitionBase;
+struct Library *UtilityBase;
+struct Library *IconBase;
+struct Library *WorkbenchBase;
+struct Library *DataTypesBase;
+
+/* Every call is counted by name */
+#define MAX_COUNTERS 160
+
+static struct {
+    const char *name;
+    ULONG count;
+} counters[MAX_COUNTERS];
+static LONG counterCount = 0;
+
+VOID MockCount(const char *function)
+{
+    LONG i;
+
+    for (i = 0; i < counterCount; i++) {
+        if (counters[i].name == function || strcmp(counters[i].name, function) == 0) {
+            counters[i].count++;
+            return;
+        }
+    }
+    if (counterCount < MAX_COUNTERS) {
+        counters[counterCount].name = function;
+        counters[counterCount].count = 1;
+        counterCount++;
+    }
+}
+
+ULONG MockCalls(const char *function)
+{
+    LONG i;
+
+    for (i = 0; i < counterCount; i++) {
+        if (strcmp(counters[i].name, function) == 0) {
+            return counters[i].count;
+        }
+    }
+    return 0;
+}
+
+/* Virtual clock - every call costs a little, I/O costs the volume latency */
+#define CALL_COST 5
+
+static unsigned long long clockMicros = 0;
+static LONG clockBaseDays = 17000;
+static LONG clockBaseMinute = 600;
+
+VOID MockAdvance(ULONG micros)
+{
+    clockMicros += micros;
+}
+
+ULONG MockNow(VOID)
+{
+    return (ULONG)clockMicros;
+}
+
+VOID MockSetTime(LONG days, LONG minute)
+{
+    clockBaseDays = days;
+    clockBaseMinute = minute;
+    clockMicros = 0;
+}
+
+#define CALL(name) (MockCount(name), MockAdvance(CALL_COST))
+
+/* Memory - a first fit arena below 2 GB with a header per block */
+#define ARENA_SIZE (96UL * 1024 * 1024)
+#define BLOCK_MAGIC 0x4D4F434BUL
+#define BLOCK_FREE  0x46524545UL
+
+struct Block {
+    ULONG magic;
+    ULONG size;
+    ULONG run;
+    UWORD internal;
+    UWORD pad;
+};
+
+static UBYTE arena[ARENA_SIZE] __attribute__((aligned(16)));
+static ULONG arenaUsed = 0;
+static ULONG currentRun = 0;
+static LONG freeErrors = 0;
+
+static APTR ArenaAlloc(ULONG size, BOOL internal)
+{
+    struct Block *block;
+    ULONG offset = 0;
+    ULONG total = (sizeof(struct Block) + size + 15) & ~15UL;
+
+    /* Reuse a freed block that is big enough */
+    while (offset < arenaUsed) {
+        block = (struct Block *)(arena + offset);
+        if (block->magic == BLOCK_FREE && block->size >= size) {
+            block->magic = BLOCK_MAGIC;
+            block->run = currentRun;
+            block->internal = internal;
+            return block + 1;
+        }
+        offset += (sizeof(struct Block) + block->size + 15) & ~15UL;
+    }
+
+    if (arenaUsed + total > ARENA_SIZE) {
+        return NULL;
+    }
+    block = (struct Block *)(arena + arenaUsed);
+    block->magic = BLOCK_MAGIC;
+    block->size = total - sizeof(struct Block);
+    block->run = currentRun;
+    block->internal = internal;
+    arenaUsed += total;
+
+    return block + 1;
+}
+
+APTR MockArenaAlloc(ULONG size)
+{
+    APTR memory = ArenaAlloc(size, TRUE);
+
+    if (memory) {
+        memset(memory, 0, size);
+    }
+    return memory;
+}
+
+char *MockArenaString(const char *text)
+{
+    char *copy = MockArenaAlloc(strlen(text) + 1);
+
+    strcpy(copy, text);
+    return copy;
+}
+
+APTR AllocVec(ULONG size, ULONG flags)
+{
+    APTR memory;
+
+    CALL("AllocVec");
+    if (size == 0) {
+        return NULL;
+    }
+    memory = ArenaAlloc(size, FALSE);
+    if (memory && (flags & MEMF_CLEAR)) {
+        memset(memory, 0, size);
+    } else if (memory) {
+        /* Uninitialised memory is never zero on a real system either */
+        memset(memory, 0xEE, size);
+    }
+    return memory;
+}
+
+VOID FreeVec(APTR memory)
+{
+    struct Block *block;
+
+    CALL("FreeVec");
+    if (memory == NULL) {
+        return;
+    }
+    block = (struct Block *)memory - 1;
+    if ((UBYTE *)block < arena || (UBYTE *)block >= arena + arenaUsed || block->magic != BLOCK_MAGIC ||
+        block->internal) {
+        freeErrors++;
+        return;
+    }
+    block->magic = BLOCK_FREE;
+}
+
+VOID MockArenaFree(APTR memory)
+{
+    if (memory) {
+        ((struct Block *)memory - 1)->magic = BLOCK_FREE;
+    }
+}
+
+ULONG mock_chipFree = 1500000;
+ULONG mock_fastFree = 30000000;
+
+VOID MockAvailMem(ULONG chip, ULONG fast)
+{
+    mock_chipFree = chip;
+    mock_fastFree = fast;
+}
+
+ULONG AvailMem(ULONG flags)
+{
+    ULONG chip = mock_chipFree;
+    ULONG fast = mock_fastFree;
+
+    CALL("AvailMem");
+    if (flags & MEMF_LARGEST) {
+        /* Free memory is never in one piece */
+        chip = chip / 2;
+        fast = fast / 2;
+        if (flags & MEMF_CHIP) {
+            return chip;
+        }
+        if (flags & MEMF_FAST) {
+            return fast;
+        }
+        return chip > fast ? chip : fast;
+    }
+    if (flags & MEMF_CHIP) {
+        return chip;
+    }
+    if (flags & MEMF_FAST) {
+        return fast;
+    }
+    return chip + fast;
+}
+
+/* Libraries */
+static struct Library mockLibraries[8];
+static LONG librariesOpen = 0;
+static const char *libraryNames[] = {
+    "intuition.library", "utility.library", "workbench.library", "datatypes.library",
+    "icon.library", "requester.class", "dos.library", NULL
+};
+
+struct Library *OpenLibrary(CONST_STRPTR name, ULONG version)
+{
+    LONG i;
+
+    CALL("OpenLibrary");
+    for (i = 0; libraryNames[i] != NULL; i++) {
+        if (strcmp((const char *)name, libraryNames[i]) == 0) {
+            mockLibraries[i].lib_Node.ln_Name = (char *)libraryNames[i];
+            mockLibraries[i].lib_Version = 47;
+            if (version > 47) {
+                return NULL;
+            }
+            librariesOpen++;
+            return &mockLibraries[i];
+        }
+    }
+    return NULL;
+}
+
+VOID CloseLibrary(APTR library)
+{
+    CALL("CloseLibrary");
+    if (library) {
+        librariesOpen--;
+    }
+}
+
+/* Tasks and signals */
+struct Process mock_process;
+static ULONG signals = 0;
+LONG mock_breakAfterLocks = -1;
+
+struct Task *FindTask(CONST_STRPTR name)
+{
+    CALL("FindTask");
+    return name == NULL ? &mock_process.pr_Task : NULL;
+}
+
+ULONG SetSignal(ULONG newSignals, ULONG mask)
+{
+    ULONG old = signals;
+
+    CALL("SetSignal");
+    signals = (signals & ~mask) | (newSignals & mask);
+    return old;
+}
+
+VOID MockBreakAfterLocks(LONG locks)
+{
+    mock_breakAfterLocks = locks;
+}
+
+VOID MockBreak(VOID)
+{
+    signals |= SIGBREAKF_CTRL_C;
+}
+
+/* Lists, as exec keeps them */
+static VOID InitList(struct List *list)
+{
+    list->lh_Head = (struct Node *)&list->lh_Tail;
+    list->lh_Tail = NULL;
+    list->lh_TailPred = (struct Node *)&list->lh_Head;
+}
+
+static VOID AddTailNode(struct List *list, struct Node *node)
+{
+    struct Node *tail = (struct Node *)&list->lh_Tail;
+
+    node->ln_Succ = tail;
+    node->ln_Pred = list->lh_TailPred;
+    list->lh_TailPred->ln_Succ = node;
+    list->lh_TailPred = node;
+}
+
+static struct Node *RemHeadNode(struct List *list)
+{
+    struct Node *node = list->lh_Head;
+
+    if (node->ln_Succ == NULL) {
+        return NULL;
+    }
+    list->lh_Head = node->ln_Succ;
+    node->ln_Succ->ln_Pred = (struct Node *)&list->lh_Head;
+    return node;
+}
+
+/* Ports */
+static LONG portsOpen = 0;
+static struct MsgPort deficonsPort;
+BOOL mock_defIcons = FALSE;
+
+VOID MockDefIcons(BOOL running)
+{
+    mock_defIcons = running;
+}
+
+struct MsgPort *CreateMsgPort(VOID)
+{
+    struct MsgPort *port = MockArenaAlloc(sizeof(struct MsgPort));
+
+    CALL("CreateMsgPort");
+    InitList(&port->mp_MsgList);
+    portsOpen++;
+    return port;
+}
+
+VOID DeleteMsgPort(struct MsgPort *port)
+{
+    CALL("DeleteMsgPort");
+    if (port) {
+        portsOpen--;
+        MockArenaFree(port);
+    }
+}
+
+struct MsgPort *FindPort(CONST_STRPTR name)
+{
+    CALL("FindPort");
+    if (strcmp((const char *)name, "DEFICONS") == 0 && mock_defIcons) {
+        return &deficonsPort;
+    }
+    return NULL;
+}
+
+/* Packets in flight - replied once the virtual clock reaches them */
+#define MAX_PENDING 64
+
+static struct {
+    struct DosPacket *dp;
+    struct MsgPort *replyPort;
+    unsigned long long due;
+} pending[MAX_PENDING];
+static LONG pendingCount = 0;
+
+VOID MockQueuePacket(struct DosPacket *dp, struct MsgPort *replyPort, ULONG due)
+{
+    if (pendingCount == MAX_PENDING) {
+        MockCheck(0, "fewer than 64 packets in flight", __FILE__, __LINE__);
+        return;
+    }
+    pending[pendingCount].dp = dp;
+    pending[pendingCount].replyPort = replyPort;
+    pending[pendingCount].due = clockMicros + due;
+    pendingCount++;
+}
+
+/* Put replies that are due on their ports; with wait, move the clock on */
+/* to the first reply for the port if none is there yet */
+VOID MockDeliverPackets(BOOL wait, struct MsgPort *port)
+{
+    LONG i;
+
+    if (wait && port->mp_MsgList.lh_Head->ln_Succ == NULL) {
+        unsigned long long first = 0;
+        BOOL any = FALSE;
+
+        for (i = 0; i < pendingCount; i++) {
+            if (pending[i].replyPort == port && (!any || pending[i].due < first)) {
+                first = pending[i].due;
+                any = TRUE;
+            }
+        }
+        if (!any) {
+            MockCheck(0, "WaitPort() on a port with no packet outstanding", __FILE__, __LINE__);
+            return;
+        }
+        if (first > clockMicros) {
+            clockMicros = first;
+        }
+    }
+
+    for (i = 0; i < pendingCount; ) {
+        if (pending[i].due <= clockMicros) {
+            struct Message *msg = pending[i].dp->dp_Link;
+
+            AddTailNode(&pending[i].replyPort->mp_MsgList, &msg->mn_Node);
+            pending[i] = pending[--pendingCount];
+        } else {
+            i++;
+        }
+    }
+}
+
+struct Message *GetMsg(struct MsgPort *port)
+{
+    CALL("GetMsg");
+    MockDeliverPackets(FALSE, port);
+    return (struct Message *)RemHeadNode(&port->mp_MsgList);
+}
+
+struct Message *WaitPort(struct MsgPort *port)
+{
+    CALL("WaitPort");
+    MockDeliverPackets(TRUE, port);
+    return (struct Message *)port->mp_MsgList.lh_Head;
+}
+
+/* Semaphores - the published ones outlive a run */
+#define MAX_SEMAPHORES 8
+
+static struct SignalSemaphore *published[MAX_SEMAPHORES];
+static LONG publishedCount = 0;
+LONG mock_semaphores = 0;
+LONG mock_forbid = 0;
+
+struct SignalSemaphore *FindSemaphore(CONST_STRPTR name)
+{
+    LONG i;
+
+    CALL("FindSemaphore");
+    for (i = 0; i < publishedCount; i++) {
+        if (strcmp(published[i]->ss_Link.ln_Name, (const char *)name) == 0) {
+            return published[i];
+        }
+    }
+    return NULL;
+}
+
+VOID AddSemaphore(struct SignalSemaphore *sem)
+{
+    CALL("AddSemaphore");
+    if (publishedCount < MAX_SEMAPHORES) {
+        published[publishedCount++] = sem;
+    }
+}
+
+VOID RemSemaphore(struct SignalSemaphore *sem)
+{
+    LONG i;
+
+    CALL("RemSemaphore");
+    for (i = 0; i < publishedCount; i++) {
+        if (published[i] == sem) {
+            published[i] = published[--publishedCount];
+            return;
+        }
+    }
+}
+
+VOID InitSemaphore(struct SignalSemaphore *sem)
+{
+    CALL("InitSemaphore");
+    sem->ss_NestCount = 0;
+}
+
+VOID ObtainSemaphore(struct SignalSemaphore *sem)
+{
+    CALL("ObtainSemaphore");
+    sem->ss_NestCount++;
+    mock_semaphores++;
+}
+
+VOID ObtainSemaphoreShared(struct SignalSemaphore *sem)
+{
+    CALL("ObtainSemaphoreShared");
+    sem->ss_NestCount++;
+    mock_semaphores++;
+}
+
+ULONG AttemptSemaphore(struct SignalSemaphore *sem)
+{
+    CALL("AttemptSemaphore");
+    sem->ss_NestCount++;
+    mock_semaphores++;
+    return TRUE;
+}
+
+VOID ReleaseSemaphore(struct SignalSemaphore *sem)
+{
+    CALL("ReleaseSemaphore");
+    sem->ss_NestCount--;
+    mock_semaphores--;
+}
+
+VOID Forbid(VOID)
+{
+    CALL("Forbid");
+    mock_forbid++;
+}
+
+VOID Permit(VOID)
+{
+    CALL("Permit");
+    mock_forbid--;
+}
+
+/* timer.device */
+static LONG ioRequests = 0;
+static LONG devicesOpen = 0;
+static struct Device timerDevice;
+
+APTR CreateIORequest(struct MsgPort *port, ULONG size)
+{
+    struct IORequest *io;
+
+    CALL("CreateIORequest");
+    if (!port) {
+        return NULL;
+    }
+    io = MockArenaAlloc(size);
+    io->io_Message.mn_ReplyPort = port;
+    ioRequests++;
+    return io;
+}
+
+VOID DeleteIORequest(APTR ioReq)
+{
+    CALL("DeleteIORequest");
+    if (ioReq) {
+        ioRequests--;
+        MockArenaFree(ioReq);
+    }
+}
+
+BYTE OpenDevice(CONST_STRPTR name, ULONG unit, struct IORequest *ioReq, ULONG flags)
+{
+    CALL("OpenDevice");
+    if (strcmp((const char *)name, TIMERNAME) != 0) {
+        return -1;
+    }
+    ioReq->io_Device = &timerDevice;
+    devicesOpen++;
+    return 0;
+}
+
+VOID CloseDevice(struct IORequest *ioReq)
+{
+    CALL("CloseDevice");
+    devicesOpen--;
+}
+
+#define ECLOCK_FREQUENCY 709379UL
+
+ULONG ReadEClock(struct EClockVal *dest)
+{
+    unsigned long long ticks;
+
+    CALL("ReadEClock");
+    ticks = clockMicros * ECLOCK_FREQUENCY / 1000000ULL;
+    dest->ev_hi = (ULONG)(ticks >> 32);
+    dest->ev_lo = (ULONG)ticks;
+    return ECLOCK_FREQUENCY;
+}
+
+/* dos.library DateStamp() lives here, next to the clock */
+struct DateStamp *DateStamp(struct DateStamp *date)
+{
+    unsigned long long ticks = clockMicros / 20000ULL;
+    unsigned long long minutes = clockBaseMinute + ticks / (TICKS_PER_SECOND * 60);
+
+    CALL("DateStamp");
+    date->ds_Days = clockBaseDays + (LONG)(minutes / 1440);
+    date->ds_Minute = (LONG)(minutes % 1440);
+    date->ds_Tick = (LONG)(ticks % (TICKS_PER_SECOND * 60));
+    return date;
+}
+
+/* Run bookkeeping */
+VOID MockResetExec(VOID)
+{
+    currentRun++;
+    counterCount = 0;
+    signals = 0;
+    freeErrors = 0;
+    memset(&mock_process, 0, sizeof(mock_process));
+    InitList(&mock_process.pr_MsgPort.mp_MsgList);
+}
+
+/* Report what open.c left behind at the end of a run */
+VOID MockCheckExec(VOID)
+{
+    ULONG offset = 0;
+    LONG leaks = 0;
+    LONG i;
+
+    while (offset < arenaUsed) {
+        struct Block *block = (struct Block *)(arena + offset);
+
+        if (block->magic == BLOCK_MAGIC && !block->internal && block->run == currentRun) {
+            BOOL keep = FALSE;
+
+            /* A published semaphore stays for the next run */
+            for (i = 0; i < publishedCount; i++) {
+                if ((UBYTE *)published[i] >= (UBYTE *)(block + 1) &&
+                    (UBYTE *)published[i] < (UBYTE *)(block + 1) + block->size) {
+                    keep = TRUE;
+                }
+            }
+            if (!keep) {
+                leaks++;
+                fprintf(stderr, "  leaked %lu bytes\n", (unsigned long)block->size);
+            }
+        }
+        offset += (sizeof(struct Block) + block->size + 15) & ~15UL;
+    }
+
+    MockCheck(leaks == 0, "no AllocVec() left over", __FILE__, __LINE__);
+    MockCheck(freeErrors == 0, "FreeVec() only of live blocks", __FILE__, __LINE__);
+    MockCheck(pendingCount == 0, "every packet reply collected", __FILE__, __LINE__);
+    MockCheck(mock_forbid == 0, "Forbid() and Permit() balanced", __FILE__, __LINE__);
+    MockCheck(mock_semaphores == 0, "semaphores released", __FILE__, __LINE__);
+    MockCheck(librariesOpen == 0, "libraries closed", __FILE__, __LINE__);
+    MockCheck(portsOpen == 0, "message ports deleted", __FILE__, __LINE__);
+    MockCheck(ioRequests == 0 && devicesOpen == 0, "timer.device closed", __FILE__, __LINE__);
+    mock_breakAfterLocks = -1;
+}
@@ -0,0 +1,643 @@
+/*
+ * Open - host test harness
+ *
+ * Copyright (c) 2025 amigazen project
+ * Licensed under BSD 2-Clause License
+ */
+
+/* utility, intuition, requester.class, icon, workbench and datatypes */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include "mock.h"
+
+#define CALL(name) (MockCount(name), MockAdvance(5))
+
+/* open.c's own definitions of the datatypes tool tags */
+#define TOOLA_Which (TAG_USER + 2)
+
+LONG mock_ibaseLocks = 0;
+
+static LONG objectsOutstanding = 0;
+static LONG diskObjectsOutstanding = 0;
+static LONG dataTypesOutstanding = 0;
+static LONG drawerListsOutstanding = 0;
+static LONG screensLocked = 0;
+
+/* Launches */
+static struct MockLaunch launches[MOCK_MAX_LAUNCHES];
+static LONG launchCount = 0;
+
+VOID MockLaunchRecord(const char *how, const char *what, const char *arg)
+{
+    if (launchCount == MOCK_MAX_LAUNCHES) {
+        return;
+    }
+    strncpy(launches[launchCount].how, how, sizeof(launches[0].how) - 1);
+    strncpy(launches[launchCount].what, what ? what : "", sizeof(launches[0].what) - 1);
+    strncpy(launches[launchCount].arg, arg ? arg : "", sizeof(launches[0].arg) - 1);
+    launchCount++;
+}
+
+LONG MockLaunchCount(VOID)
+{
+    return launchCount;
+}
+
+const struct MockLaunch *MockLaunchAt(LONG index)
+{
+    static struct MockLaunch none;
+
+    return (index >= 0 && index < launchCount) ? &launches[index] : &none;
+}
+
+/* RawDoFmt() style formatting; open.c passes LONGs and pointers below */
+/* 2 GB, so every argument is read as a long and cut to 32 bits */
+LONG MockFormat(char *out, LONG size, const char *format, va_list args)
+{
+    LONG length = 0;
+    const char *p;
+
+    for (p = format; *p && length < size - 1; p++) {
+        char spec[16];
+        char text[512];
+        LONG specLength = 0;
+        unsigned long value;
+
+        if (*p != '%') {
+            out[length++] = *p;
+            continue;
+        }
+        p++;
+        if (*p == '%') {
+            out[length++] = '%';
+            continue;
+        }
+        spec[specLength++] = '%';
+        while ((*p == '-' || *p == '0' || isdigit((unsigned char)*p)) && specLength < 10) {
+            spec[specLength++] = *p++;
+        }
+        if (*p == 'l') {
+            p++;
+        }
+        value = va_arg(args, unsigned long) & 0xFFFFFFFFUL;
+        switch (*p) {
+            case 's':
+                spec[specLength++] = 's';
+                spec[specLength] = '\0';
+                snprintf(text, sizeof(text), spec, value ? (const char *)(IPTR)value : "(null)");
+                break;
+            case 'd':
+                spec[specLength++] = 'l';
+                spec[specLength++] = 'd';
+                spec[specLength] = '\0';
+                snprintf(text, sizeof(text), spec, (long)(LONG)value);
+                break;
+            case 'u':
+            case 'x':
+            case 'X':
+                spec[specLength++] = 'l';
+                spec[specLength++] = *p;
+                spec[specLength] = '\0';
+                snprintf(text, sizeof(text), spec, value);
+                break;
+            case 'c':
+                spec[specLength++] = 'c';
+                spec[specLength] = '\0';
+                snprintf(text, sizeof(text), spec, (int)(value & 0xFF));
+                break;
+            default:
+                snprintf(text, sizeof(text), "<%%%c>", *p);
+                break;
+        }
+        if (length + (LONG)strlen(text) >= size) {
+            break;
+        }
+        strcpy(out + length, text);
+        length += strlen(text);
+    }
+    out[length] = '\0';
+    return length;
+}
+
+/* utility.library */
+LONG Stricmp(CONST_STRPTR string1, CONST_STRPTR string2)
+{
+    CALL("Stricmp");
+    return strcasecmp((const char *)string1, (const char *)string2);
+}
+
+LONG Strnicmp(CONST_STRPTR string1, CONST_STRPTR string2, LONG length)
+{
+    CALL("Strnicmp");
+    return strncasecmp((const char *)string1, (const char *)string2, length);
+}
+
+UBYTE ToLower(ULONG character)
+{
+    return (UBYTE)tolower((int)(character & 0xFF));
+}
+
+UBYTE ToUpper(ULONG character)
+{
+    return (UBYTE)toupper((int)(character & 0xFF));
+}
+
+LONG Strncpy(STRPTR dst, CONST_STRPTR src, LONG size)
+{
+    LONG length = strlen((const char *)src);
+
+    if (size <= 0) {
+        return length;
+    }
+    if (length >= size) {
+        memcpy(dst, src, size - 1);
+        dst[size - 1] = '\0';
+    } else {
+        memcpy(dst, src, length + 1);
+    }
+    return length;
+}
+
+LONG Strlcat(STRPTR dst, CONST_STRPTR src, LONG size)
+{
+    LONG used = strlen((const char *)dst);
+
+    if (used < size - 1) {
+        Strncpy(dst + used, src, size - used);
+    }
+    return used + strlen((const char *)src);
+}
+
+LONG SNPrintf(STRPTR buffer, LONG size, CONST_STRPTR format, ...)
+{
+    va_list args;
+    LONG length;
+
+    va_start(args, format);
+    length = MockFormat((char *)buffer, size, (const char *)format, args);
+    va_end(args);
+    return length;
+}
+
+/* requester.class */
+static Class requesterClass;
+
+Class *REQUESTER_GetClass(VOID)
+{
+    CALL("REQUESTER_GetClass");
+    return &requesterClass;
+}
+
+struct MockObject {
+    char body[1024];
+};
+
+APTR NewObject(Class *classPtr, CONST_STRPTR classID, ...)
+{
+    struct MockObject *object;
+    va_list args;
+    unsigned long tag;
+
+    CALL("NewObject");
+    object = MockArenaAlloc(sizeof(struct MockObject));
+    va_start(args, classID);
+    while ((tag = va_arg(args, unsigned long) & 0xFFFFFFFFUL) != TAG_DONE) {
+        unsigned long data = va_arg(args, unsigned long) & 0xFFFFFFFFUL;
+
+        if (tag == REQ_BodyText && data) {
+            strncpy(object->body, (const char *)(IPTR)data, sizeof(object->body) - 1);
+        }
+    }
+    va_end(args);
+    objectsOutstanding++;
+    return object;
+}
+
+VOID DisposeObject(APTR object)
+{
+    CALL("DisposeObject");
+    if (object) {
+        objectsOutstanding--;
+        MockArenaFree(object);
+    }
+}
+
+ULONG DoMethod(Object *obj, ULONG methodID, ...)
+{
+    CALL("DoMethod");
+    if (methodID == RM_OPENREQ) {
+        MockLaunchRecord("requester", ((struct MockObject *)obj)->body, "");
+    }
+    return 0;
+}
+
+/* intuition.library - one Workbench screen with scripted windows */
+static struct Screen workbenchScreen;
+static struct Window *closingWindow = NULL;  /* Closed once IntuitionBase is unlocked */
+
+VOID MockWindow(const char *title)
+{
+    struct Window *window = MockArenaAlloc(sizeof(struct Window));
+    struct Window **link = &workbenchScreen.FirstWindow;
+
+    window->Title = (UBYTE *)MockArenaString(title);
+    window->Flags = WFLG_WBENCHWINDOW;
+    window->WScreen = &workbenchScreen;
+    while (*link) {
+        link = &(*link)->NextWindow;
+    }
+    *link = window;
+}
+
+/* Workbench closes the window as soon as it gets the chance */
+VOID MockCloseWindowSoon(const char *title)
+{
+    struct Window *window;
+
+    for (window = workbenchScreen.FirstWindow; window; window = window->NextWindow) {
+        if (strcmp((const char *)window->Title, title) == 0) {
+            closingWindow = window;
+        }
+    }
+}
+
+struct Screen *LockPubScreen(CONST_STRPTR name)
+{
+    CALL("LockPubScreen");
+    if (!name || strcmp((const char *)name, "Workbench") != 0) {
+        return NULL;
+    }
+    screensLocked++;
+    return &workbenchScreen;
+}
+
+VOID UnlockPubScreen(CONST_STRPTR name, struct Screen *screen)
+{
+    CALL("UnlockPubScreen");
+    if (screen) {
+        screensLocked--;
+    }
+}
+
+static VOID CheckWindow(struct Window *window)
+{
+    struct Window *w;
+
+    for (w = workbenchScreen.FirstWindow; w && w != window; w = w->NextWindow) {
+    }
+    MockCheck(w != NULL, "window is still open", __FILE__, __LINE__);
+    MockCheck(mock_ibaseLocks == 0, "no Intuition call under LockIBase()", __FILE__, __LINE__);
+}
+
+VOID WindowToFront(struct Window *window)
+{
+    CALL("WindowToFront");
+    CheckWindow(window);
+    MockLaunchRecord("front", (const char *)window->Title, "");
+}
+
+VOID ActivateWindow(struct Window *window)
+{
+    CALL("ActivateWindow");
+    CheckWindow(window);
+}
+
+ULONG LockIBase(ULONG dontknow)
+{
+    CALL("LockIBase");
+    mock_ibaseLocks++;
+    return 1;
+}
+
+VOID UnlockIBase(ULONG ibLock)
+{
+    struct Window **link;
+
+    CALL("UnlockIBase");
+    if (--mock_ibaseLocks == 0 && closingWindow) {
+        for (link = &workbenchScreen.FirstWindow; *link; link = &(*link)->NextWindow) {
+            if (*link == closingWindow) {
+                *link = closingWindow->NextWindow;
+                break;
+            }
+        }
+        closingWindow = NULL;
+    }
+}
+
+/* workbench.library - open drawers by path */
+#define MAX_OPEN_DRAWERS 16
+
+static char openDrawers[MAX_OPEN_DRAWERS][256];
+static LONG openDrawerCount = 0;
+
+VOID MockOpenDrawer(const char *path, const char *title)
+{
+    if (openDrawerCount < MAX_OPEN_DRAWERS) {
+        strncpy(openDrawers[openDrawerCount++], path, 255);
+    }
+    MockWindow(title);
+}
+
+/* The path of a node, as NameFromLock() would give it */
+static VOID NodePath(struct MockNode *node, char *path, LONG size)
+{
+    char tail[512];
+
+    tail[0] = '\0';
+    for (; node->parent; node = node->parent) {
+        char part[512];
+
+        snprintf(part, sizeof(part), "%s%s%s", node->name, tail[0] ? "/" : "", tail);
+        strcpy(tail, part);
+    }
+    snprintf(path, size, "%s:%s", node->volume->name, tail);
+}
+
+BOOL OpenWorkbenchObjectA(CONST_STRPTR name, const struct TagItem *tags)
+{
+    char arg[512];
+    struct MockNode *node;
+    LONG error;
+    BPTR argLock = NULL;
+    const char *argName = NULL;
+    const struct TagItem *tag;
+
+    CALL("OpenWorkbenchObjectA");
+    arg[0] = '\0';
+    for (tag = tags; tag && tag->ti_Tag != TAG_DONE; tag++) {
+        if (tag->ti_Tag == WBOPENA_ArgLock) {
+            argLock = (BPTR)tag->ti_Data;
+        } else if (tag->ti_Tag == WBOPENA_ArgName) {
+            argName = (const char *)(IPTR)tag->ti_Data;
+        }
+    }
+    if (argLock) {
+        struct MockNode *drawer = MockLockNode(argLock);
+
+        MockCheck(drawer != NULL, "WBOPENA_ArgLock is a live lock", __FILE__, __LINE__);
+        if (drawer) {
+            NodePath(drawer, arg, sizeof(arg));
+            if (argName) {
+                if (arg[strlen(arg) - 1] != ':') {
+                    strcat(arg, "/");
+                }
+                strcat(arg, argName);
+            }
+        }
+    }
+    if (!*name) {
+        MockLaunchRecord("workbench", "", arg);
+        return TRUE;
+    }
+    node = MockResolve((const char *)name, NULL, &error);
+    if (!node) {
+        mock_ioErr = error;
+        return FALSE;
+    }
+    MockAdvance(node->volume->latency);
+    MockLaunchRecord("workbench", (const char *)name, arg);
+    return TRUE;
+}
+
+BOOL WorkbenchControlA(CONST_STRPTR name, const struct TagItem *tags)
+{
+    const struct TagItem *tag;
+
+    CALL("WorkbenchControlA");
+    for (tag = tags; tag && tag->ti_Tag != TAG_DONE; tag++) {
+        if (tag->ti_Tag == WBCTRLA_GetOpenDrawerList) {
+            struct List *list = MockArenaAlloc(sizeof(struct List));
+            LONG i;
+
+            list->lh_Head = (struct Node *)&list->lh_Tail;
+            list->lh_Tail = NULL;
+            list->lh_TailPred = (struct Node *)&list->lh_Head;
+            for (i = 0; i < openDrawerCount; i++) {
+                struct Node *node = MockArenaAlloc(sizeof(struct Node));
+
+                node->ln_Name = MockArenaString(openDrawers[i]);
+                node->ln_Succ = (struct Node *)&list->lh_Tail;
+                node->ln_Pred = list->lh_TailPred;
+                list->lh_TailPred->ln_Succ = node;
+                list->lh_TailPred = node;
+            }
+            *(struct List **)(IPTR)tag->ti_Data = list;
+            drawerListsOutstanding++;
+        } else if (tag->ti_Tag == WBCTRLA_FreeOpenDrawerList) {
+            struct List *list = (struct List *)(IPTR)tag->ti_Data;
+            struct Node *node = list->lh_Head;
+
+            while (node->ln_Succ) {
+                struct Node *next = node->ln_Succ;
+
+                MockArenaFree(node->ln_Name);
+                MockArenaFree(node);
+                node = next;
+            }
+            MockArenaFree(list);
+            drawerListsOutstanding--;
+        }
+    }
+    return TRUE;
+}
+
+/* icon.library */
+struct DiskObject *GetDiskObject(CONST_STRPTR name)
+{
+    char path[512];
+    struct MockNode *node;
+    struct DiskObject *icon;
+    LONG error;
+
+    CALL("GetDiskObject");
+    snprintf(path, sizeof(path), "%s.info", (const char *)name);
+    node = MockResolve(path, NULL, &error);
+    if (!node) {
+        mock_ioErr = error;
+        return NULL;
+    }
+    MockAdvance(node->volume->latency);
+    icon = MockArenaAlloc(sizeof(struct DiskObject));
+    icon->do_Magic = 0xE310;
+    icon->do_DefaultTool = MockArenaString(node->defaultTool);
+    diskObjectsOutstanding++;
+    return icon;
+}
+
+VOID FreeDiskObject(struct DiskObject *diskobj)
+{
+    CALL("FreeDiskObject");
+    if (diskobj) {
+        diskObjectsOutstanding--;
+        MockArenaFree(diskobj->do_DefaultTool);
+        MockArenaFree(diskobj);
+    }
+}
+
+/* Identification as DefIcons does it: a scripted type, else a guess */
+struct DiskObject *GetIconTagList(CONST_STRPTR name, const struct TagItem *tags)
+{
+    const struct TagItem *tag;
+    char *typeBuffer = NULL;
+    LONG *errorCode = NULL;
+    struct MockNode *node;
+    LONG error;
+
+    CALL("GetIconTagList");
+    for (tag = tags; tag && tag->ti_Tag != TAG_DONE; tag++) {
+        if (tag->ti_Tag == ICONGETA_IdentifyBuffer) {
+            typeBuffer = (char *)(IPTR)tag->ti_Data;
+        } else if (tag->ti_Tag == ICONA_ErrorCode) {
+            errorCode = (LONG *)(IPTR)tag->ti_Data;
+        }
+    }
+    node = MockResolve((const char *)name, NULL, &error);
+    if (errorCode) {
+        *errorCode = node ? 0 : error;
+    }
+    if (!node || !typeBuffer) {
+        return NULL;
+    }
+    MockAdvance(node->volume->latency);
+    typeBuffer[0] = '\0';
+    if (mock_defIcons) {
+        if (node->defIconsType[0]) {
+            strcpy(typeBuffer, node->defIconsType);
+        } else if (node->type != ST_FILE) {
+            strcpy(typeBuffer, "drawer");
+        } else if (node->size >= 4 && node->data[2] == 0x03 && node->data[3] == 0xF3) {
+            strcpy(typeBuffer, "tool");
+        } else {
+            strcpy(typeBuffer, "project");
+        }
+    }
+    return NULL;
+}
+
+/* datatypes.library */
+struct MockDataType *MockDataTypeNew(const char *name, ULONG group)
+{
+    struct MockDataType *dt = calloc(1, sizeof(struct MockDataType));
+
+    strncpy(dt->name, name, sizeof(dt->name) - 1);
+    dt->group = group;
+    return dt;
+}
+
+VOID MockDataTypeTool(struct MockDataType *dt, UWORD which, UWORD flags, const char *program)
+{
+    if (dt->toolCount < 4) {
+        dt->tools[dt->toolCount].which = which;
+        dt->tools[dt->toolCount].flags = flags;
+        strncpy(dt->tools[dt->toolCount].program, program, sizeof(dt->tools[0].program) - 1);
+        dt->toolCount++;
+    }
+}
+
+VOID MockDataTypeOf(const char *path, struct MockDataType *dt)
+{
+    struct MockNode *node = MockFind(path);
+
+    if (node) {
+        node->dataType = dt;
+    }
+}
+
+struct DataType *ObtainDataTypeA(ULONG type, APTR handle, struct TagItem *attrs)
+{
+    struct MockNode *node;
+    struct DataType *dtn;
+    LONG i;
+
+    CALL("ObtainDataTypeA");
+    if (type != DTST_FILE) {
+        return NULL;
+    }
+    node = MockLockNode((BPTR)(IPTR)handle);
+    MockCheck(node != NULL, "ObtainDataTypeA() on a live lock", __FILE__, __LINE__);
+    if (!node || !node->dataType) {
+        mock_ioErr = ERROR_OBJECT_NOT_FOUND;
+        return NULL;
+    }
+    MockAdvance(node->volume->latency);
+    dtn = MockArenaAlloc(sizeof(struct DataType));
+    dtn->dtn_Header = MockArenaAlloc(sizeof(struct DataTypeHeader));
+    dtn->dtn_Header->dth_Name = (STRPTR)MockArenaString(node->dataType->name);
+    dtn->dtn_Header->dth_BaseName = dtn->dtn_Header->dth_Name;
+    dtn->dtn_Header->dth_GroupID = node->dataType->group;
+    dtn->dtn_ToolList.lh_Head = (struct Node *)&dtn->dtn_ToolList.lh_Tail;
+    dtn->dtn_ToolList.lh_TailPred = (struct Node *)&dtn->dtn_ToolList.lh_Head;
+    for (i = 0; i < node->dataType->toolCount; i++) {
+        struct ToolNode *tn = MockArenaAlloc(sizeof(struct ToolNode));
+        struct List *list = &dtn->dtn_ToolList;
+
+        tn->tn_Tool.tn_Which = node->dataType->tools[i].which;
+        tn->tn_Tool.tn_Flags = node->dataType->tools[i].flags;
+        tn->tn_Tool.tn_Program = (STRPTR)MockArenaString(node->dataType->tools[i].program);
+        tn->tn_Node.ln_Succ = (struct Node *)&list->lh_Tail;
+        tn->tn_Node.ln_Pred = list->lh_TailPred;
+        list->lh_TailPred->ln_Succ = &tn->tn_Node;
+        list->lh_TailPred = &tn->tn_Node;
+    }
+    dataTypesOutstanding++;
+    return dtn;
+}
+
+VOID ReleaseDataType(struct DataType *dt)
+{
+    CALL("ReleaseDataType");
+    if (dt) {
+        dataTypesOutstanding--;
+    }
+}
+
+struct ToolNode *FindToolNodeA(struct List *toollist, struct TagItem *attrs)
+{
+    struct Node *node;
+    struct TagItem *tag;
+    ULONG which = 0;
+
+    CALL("FindToolNodeA");
+    for (tag = attrs; tag && tag->ti_Tag != TAG_DONE; tag++) {
+        if (tag->ti_Tag == TOOLA_Which) {
+            which = tag->ti_Data;
+        }
+    }
+    for (node = toollist->lh_Head; node->ln_Succ; node = node->ln_Succ) {
+        if (((struct ToolNode *)node)->tn_Tool.tn_Which == which) {
+            return (struct ToolNode *)node;
+        }
+    }
+    return NULL;
+}
+
+ULONG LaunchToolA(struct Tool *tool, STRPTR project, struct TagItem *attrs)
+{
+    CALL("LaunchToolA");
+    MockLaunchRecord("datatypes", (const char *)tool->tn_Program, (const char *)project);
+    return TRUE;
+}
+
+/* Run bookkeeping */
+VOID MockResetLibs(VOID)
+{
+    launchCount = 0;
+    memset(launches, 0, sizeof(launches));
+    mock_ibaseLocks = 0;
+}
+
+VOID MockCheckLibs(VOID)
+{
+    MockCheck(objectsOutstanding == 0, "every requester disposed", __FILE__, __LINE__);
+    MockCheck(diskObjectsOutstanding == 0, "every DiskObject freed", __FILE__, __LINE__);
+    MockCheck(dataTypesOutstanding == 0, "every DataType released", __FILE__, __LINE__);
+    MockCheck(drawerListsOutstanding == 0, "open drawer list freed", __FILE__, __LINE__);
+    MockCheck(screensLocked == 0, "Workbench screen unlocked", __FILE__, __LINE__);
+    MockCheck(mock_ibaseLocks == 0, "IntuitionBase unlocked", __FILE__, __LINE__);
+    objectsOutstanding = diskObjectsOutstanding = dataTypesOutstanding = 0;
+    drawerListsOutstanding = screensLocked = 0;
+}
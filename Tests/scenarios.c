@@ -0,0 +1,885 @@
+/*
+ * Open - host test harness
+ *
+ * Copyright (c) 2025 amigazen project
+ * Licensed under BSD 2-Clause License
+ */
+
+/* Scenarios: each builds a world, runs Open and checks what it did */
+/* Call counts are exact on purpose - a change that adds I/O to an item */
+/* has to change the count here too */
+
+#include <stdio.h>
+#include <string.h>
+#include "mock.h"
+
+#define LAUNCHED(i, how_, what_, arg_) \
+    CHECK(strcmp(MockLaunchAt(i)->how, how_) == 0 && \
+          strcmp(MockLaunchAt(i)->what, what_) == 0 && \
+          strcmp(MockLaunchAt(i)->arg, arg_) == 0)
+
+/* A DEVS:DataTypes descriptor matching any IFF file */
+/* Longwords are native, as open.c reads them with Read() on this host */
+static VOID MockDescriptor(const char *path, ULONG group)
+{
+    struct DataTypeHeader header;
+    WORD mask[4] = { -1, -1, -1, -1 };   /* FORM reads back byte-swapped here */
+    ULONG chunk[5];
+    UBYTE descriptor[sizeof(chunk) + sizeof(header) + sizeof(mask)];
+
+    /* Built byte by byte - the header's pointers would pad a struct */
+    memset(&header, 0, sizeof(header));
+    header.dth_Mask = (WORD *)(IPTR)sizeof(header);
+    header.dth_MaskLen = 4;
+    header.dth_GroupID = group;
+    header.dth_Flags = DTF_IFF;
+    chunk[0] = ID_FORM;
+    chunk[1] = sizeof(descriptor) - 8;
+    chunk[2] = ID_DTYP;
+    chunk[3] = ID_DTHD;
+    chunk[4] = sizeof(header) + sizeof(mask);
+    memcpy(descriptor, chunk, sizeof(chunk));
+    memcpy(descriptor + sizeof(chunk), &header, sizeof(header));
+    memcpy(descriptor + sizeof(chunk) + sizeof(header), mask, sizeof(mask));
+    MockFile(path, descriptor, sizeof(descriptor));
+}
+
+/* An IFF picture, its FORM id native like the descriptors' */
+static VOID MockPicture(const char *path)
+{
+    ULONG form[3] = { ID_FORM, 4, 0 };
+
+    MockFile(path, form, sizeof(form));
+}
+
+/* A few text files typed by DefIcons, with a def_ascii icon */
+static VOID TextWorld(VOID)
+{
+    MockDefIcons(TRUE);
+    MockText("Work:ReadMe", "Hello\n");
+    MockType("Work:ReadMe", "ascii");
+    MockText("Work:Notes", "Notes\n");
+    MockType("Work:Notes", "ascii");
+    MockText("Work:ToDo", "Things\n");
+    MockType("Work:ToDo", "ascii");
+    MockIcon("ENV:Sys/def_ascii", "SYS:Utilities/MultiView");
+}
+
+/* A text file opens with the tool of its def_ icon */
+static VOID OpenTextFile(VOID)
+{
+    TextWorld();
+
+    CHECK(MockRun("Work:ReadMe") == RETURN_OK);
+    CHECK(MockLaunchCount() == 1);
+    LAUNCHED(0, "workbench", "System:Utilities/MultiView", "Work:ReadMe");
+    CHECK_CALLS("GetIconTagList", 3);
+    CHECK_CALLS("GetDiskObject", 1);
+    CHECK_CALLS("ObtainDataTypeA", 0);
+    CHECK_CALLS("System", 0);
+}
+
+/* A tool named without a path is found along the command path once, */
+/* and the second run takes it from ENV:Open/ToolCache */
+static VOID ToolCacheSecondRun(VOID)
+{
+    ULONG firstLocks;
+
+    TextWorld();
+    MockIcon("ENV:Sys/def_ascii", "MultiView");
+    MockCommandPath("SYS:C");
+    MockCommandPath("SYS:Utilities");
+
+    CHECK(MockRun("Work:ReadMe") == RETURN_OK);
+    firstLocks = MockCalls("Lock");
+    CHECK(MockGetEnv("Open/ToolCache") != NULL);
+
+    CHECK(MockRun("Work:ReadMe") == RETURN_OK);
+    LAUNCHED(0, "workbench", "System:Utilities/MultiView", "Work:ReadMe");
+    CHECK(MockCalls("Lock") <= firstLocks);
+}
+
+/* ENV:Open is made by the first run that has something to keep */
+static VOID EnvDrawerCreated(VOID)
+{
+    TextWorld();
+    MockCommandPath("SYS:Utilities");
+    MockIcon("ENV:Sys/def_ascii", "MultiView");
+    CHECK(MockFind("ENV:Open") == NULL);
+
+    CHECK(MockRun("Work:ReadMe") == RETURN_OK);
+    CHECK(MockFind("ENV:Open") != NULL);
+    CHECK(MockGetEnv("Open/ToolCache") != NULL);
+    CHECK(MockGetEnv("Open/DTMatch") != NULL);
+    CHECK_CALLS("CreateDir", 1);
+}
+
+/* Several files: one DefIcons lookup each, one def_ icon for all */
+static VOID OpenSeveralFiles(VOID)
+{
+    TextWorld();
+
+    CHECK(MockRun("Work:ReadMe Work:Notes Work:ToDo") == RETURN_OK);
+    CHECK(MockLaunchCount() == 3);
+    LAUNCHED(0, "workbench", "System:Utilities/MultiView", "Work:ReadMe");
+    LAUNCHED(1, "workbench", "System:Utilities/MultiView", "Work:Notes");
+    LAUNCHED(2, "workbench", "System:Utilities/MultiView", "Work:ToDo");
+    CHECK_CALLS("GetIconTagList", 9);
+    CHECK_CALLS("GetDiskObject", 1);
+}
+
+/* TOOL= skips tool selection; DefIcons is still asked whether the file */
+/* is a program */
+static VOID ToolOverride(VOID)
+{
+    TextWorld();
+
+    CHECK(MockRun("Work:ReadMe TOOL=C:Ed") == RETURN_OK);
+    LAUNCHED(0, "workbench", "C:Ed", "Work:ReadMe");
+    CHECK_CALLS("GetIconTagList", 2);
+    CHECK_CALLS("GetDiskObject", 0);
+}
+
+/* A drawer is opened in Workbench */
+static VOID OpenDrawer(VOID)
+{
+    MockDir("Work:Docs");
+
+    CHECK(MockRun("Work:Docs") == RETURN_OK);
+    CHECK(MockLaunchCount() == 1);
+    LAUNCHED(0, "workbench", "Work:Docs", "");
+}
+
+/* A drawer already open is brought to front instead */
+static VOID DrawerAlreadyOpen(VOID)
+{
+    MockDir("Work:Docs");
+    MockWindow("Work");
+    MockOpenDrawer("Work:Docs", "Docs");
+
+    CHECK(MockRun("Work:Docs") == RETURN_OK);
+    CHECK(MockLaunchCount() == 1);
+    LAUNCHED(0, "front", "Docs", "");
+    CHECK_CALLS("OpenWorkbenchObjectA", 0);
+}
+
+/* A drawer window that closes while it is being looked for is not */
+/* touched; the drawer is opened through Workbench instead */
+static VOID DrawerWindowCloses(VOID)
+{
+    MockDir("Work:Docs");
+    MockOpenDrawer("Work:Docs", "Docs");
+    MockCloseWindowSoon("Docs");
+
+    CHECK(MockRun("Work:Docs") == RETURN_OK);
+    CHECK_CALLS("WindowToFront", 0);
+    CHECK_CALLS("OpenWorkbenchObjectA", 1);
+}
+
+/* A file that is not there fails and says why */
+static VOID MissingFile(VOID)
+{
+    CHECK(MockRun("Work:Nothing") != RETURN_OK);
+    CHECK(MockLaunchCount() == 0);
+    CHECK_OUTPUT("object not found");
+}
+
+/* Without DefIcons, datatypes.library's tool is used */
+static VOID DatatypesTool(VOID)
+{
+    struct MockDataType *ilbm = MockDataTypeNew("ILBM", GID_PICTURE);
+
+    MockDataTypeTool(ilbm, 2, TF_WORKBENCH, "SYS:Utilities/MultiView");
+    MockFile("Work:Pic.iff", "FORM\0\0\0\4ILBM", 12);
+    MockDataTypeOf("Work:Pic.iff", ilbm);
+
+    CHECK(MockRun("Work:Pic.iff") == RETURN_OK);
+    CHECK(MockLaunchCount() == 1);
+    CHECK(strcmp(MockLaunchAt(0)->arg, "Work:Pic.iff") == 0);
+    CHECK_CALLS("ObtainDataTypeA", 1);
+}
+
+/* Only the program of a tool with arguments is looked for, and shell */
+/* tools from datatypes.library are command lines, not paths */
+static VOID ToolArguments(VOID)
+{
+    struct MockDataType *ilbm = MockDataTypeNew("ILBM", GID_PICTURE);
+
+    TextWorld();
+    MockIcon("ENV:Sys/def_ascii", "SYS:Utilities/MultiView SCREEN=Workbench");
+    MockDataTypeTool(ilbm, 2, TF_SHELL, "Run >NIL: Display \"%s\"");
+    MockFile("Work:Pic.iff", "FORM\0\0\0\4ILBM", 12);
+    MockDataTypeOf("Work:Pic.iff", ilbm);
+
+    CHECK(MockRun("Work:ReadMe Work:Pic.iff RESOLVE") == RETURN_OK);
+    CHECK_OUTPUT("\tSYS:Utilities/MultiView SCREEN=Workbench\t");
+    CHECK_OUTPUT("\tRun >NIL: Display \"%s\"\t");
+    CHECK(strstr(MockErrors(), "not found") == NULL);
+}
+
+/* RESOLVE keeps a missing tool's message out of the records */
+static VOID ResolveMissingTool(VOID)
+{
+    TextWorld();
+    MockIcon("ENV:Sys/def_ascii", "SYS:Utilities/Gone");
+
+    MockRun("Work:ReadMe RESOLVE");
+    CHECK_ERRORS("Open: Tool not found: SYS:Utilities/Gone");
+    CHECK(strstr(MockOutput(), "not found") == NULL);
+}
+
+/* An item that can't be locked still gets its record; the fault goes to */
+/* the error stream */
+static VOID ResolveMissingItem(VOID)
+{
+    TextWorld();
+
+    MockRun("Work:Gone Work:ReadMe RESOLVE");
+    CHECK_OUTPUT("Work:Gone\tmissing\t-\t-\t-\tnone\tnone\n");
+    CHECK_OUTPUT("Work:ReadMe\tdata\tascii\t");
+    CHECK_ERRORS("Open: ");
+    CHECK(strstr(MockOutput(), "Open: ") == NULL);
+}
+
+/* A DEVS:DataTypes that can't be compiled is noted in ENV:Open/DTMatch, */
+/* so the next run doesn't read the drawer again */
+static VOID DTMatchFailureNoted(VOID)
+{
+    MockDescriptor("DEVS:DataTypes/ILBM", GID_PICTURE);
+    MockDescriptor("DEVS:DataTypes/Locked", GID_PICTURE);
+    MockFind("DEVS:DataTypes/Locked")->protection = FIBF_READ;
+    MockPicture("Work:Pic.iff");
+
+    MockRun("Work:Pic.iff RESOLVE");
+    CHECK(MockCalls("ExNext") > 0);
+    CHECK(MockWrites("ENV:Open/DTMatch") == 1);
+    MockRun("Work:Pic.iff RESOLVE");
+    CHECK_CALLS("ExNext", 0);
+    CHECK(MockWrites("ENV:Open/DTMatch") == 1);
+}
+
+/* A text file no descriptor matches is still text, as datatypes.library's */
+/* built-in ascii type would make it, so $Editor opens it */
+static VOID DTMatchUnmatchedText(VOID)
+{
+    MockDescriptor("DEVS:DataTypes/ILBM", GID_PICTURE);
+    MockExecutable("System:C/Ed", 100);
+    MockSetEnv("Editor", "System:C/Ed");
+    MockText("Work:Plan", "Plan\n");
+
+    MockRun("Work:Plan RESOLVE");
+    CHECK_OUTPUT("Work:Plan\tdata\t-\ttext\tSystem:C/Ed\tsystem\teditor\n");
+}
+
+/* A DTMatch file pointing outside its own pool is compiled afresh */
+static VOID DTMatchCorrupt(VOID)
+{
+    struct MockNode *file;
+    struct DTMatchLayout {
+        ULONG magic;
+        UWORD version;
+        UWORD count;
+        struct DateStamp dirDate;
+        ULONG poolSize;
+        ULONG groupID;
+        WORD priority;
+        UWORD flags;
+        UWORD maskLen;
+        UWORD opaque;
+        ULONG maskOffset;
+        ULONG patternOffset;
+    } *layout;
+
+    MockDescriptor("DEVS:DataTypes/ILBM", GID_PICTURE);
+    MockPicture("Work:Pic.iff");
+
+    MockRun("Work:Pic.iff RESOLVE");
+    CHECK_OUTPUT("\tpicture\t");
+    file = MockFind("ENV:Open/DTMatch");
+    CHECK(file != NULL && file->size >= (LONG)sizeof(*layout));
+    layout = (struct DTMatchLayout *)file->data;
+    CHECK(layout->count == 1 && layout->maskLen == 4);
+    layout->maskOffset = 0x7FFFFFF0;
+
+    MockRun("Work:Pic.iff RESOLVE");
+    CHECK(MockCalls("ExNext") > 0);
+    CHECK(MockWrites("ENV:Open/DTMatch") == 2);
+    CHECK_OUTPUT("\tpicture\t");
+}
+
+/* With $Open/SegCache set, a pure $Editor is made resident under a name */
+/* of its own, and started from memory the next time */
+static VOID ResidentEditor(VOID)
+{
+    struct MockDataType *ascii = MockDataTypeNew("ascii", MAKE_ID('t','e','x','t'));
+
+    MockExecutable("System:C/Ed", 100)->protection |= FIBF_PURE;
+    MockSetEnv("Editor", "System:C/Ed");
+    MockSetEnv("Open/SegCache", "64");
+    MockText("Work:Notes", "Notes\n");
+    MockDataTypeOf("Work:Notes", ascii);
+
+    CHECK(MockRun("Work:Notes EDIT") == RETURN_OK);
+    CHECK(MockLaunchCount() == 1);
+    CHECK(MockResidentCount() == 1);
+    CHECK(strncmp(MockResidentName(0), "Ed.", 3) == 0);
+    CHECK(strncmp(MockLaunchAt(0)->what, MockResidentName(0), strlen(MockResidentName(0))) == 0);
+
+    CHECK(MockRun("Work:Notes EDIT") == RETURN_OK);
+    CHECK_CALLS("LoadSeg", 0);
+    CHECK(MockResidentCount() == 1);
+    CHECK(strncmp(MockLaunchAt(0)->what, MockResidentName(0), strlen(MockResidentName(0))) == 0);
+}
+
+/* Another Open makes View resident and saves its list meanwhile */
+static VOID OtherOpenSaves(VOID)
+{
+    CHECK(AddSegment((CONST_STRPTR)"View.1234", LoadSeg((CONST_STRPTR)"System:C/View"), 0));
+    MockText("ENV:Open/Residents", "View.1234\tSystem:C/View\t1 2 3 400 1 2 3\n");
+}
+
+/* The resident list is merged with what another Open saved meanwhile */
+static VOID ResidentListMerged(VOID)
+{
+    struct MockDataType *ascii = MockDataTypeNew("ascii", MAKE_ID('t','e','x','t'));
+    const char *list;
+
+    MockExecutable("System:C/Ed", 100)->protection |= FIBF_PURE;
+    MockExecutable("System:C/View", 100)->protection |= FIBF_PURE;
+    MockSetEnv("Editor", "System:C/Ed");
+    MockSetEnv("Open/SegCache", "64");
+    MockText("Work:Notes", "Notes\n");
+    MockDataTypeOf("Work:Notes", ascii);
+    MockOnSystem(OtherOpenSaves);
+
+    CHECK(MockRun("Work:Notes EDIT") == RETURN_OK);
+    CHECK(MockResidentCount() == 2);
+    list = MockGetEnv("ENV:Open/Residents");
+    CHECK(strstr(list, "\tSystem:C/Ed\t") != NULL);
+    CHECK(strstr(list, "View.1234\tSystem:C/View\t") != NULL);
+}
+
+/* With $Open/SegCache set to 0, the residents Open made are removed */
+static VOID ResidentBudgetOff(VOID)
+{
+    struct MockDataType *ascii = MockDataTypeNew("ascii", MAKE_ID('t','e','x','t'));
+
+    MockExecutable("System:C/Ed", 100)->protection |= FIBF_PURE;
+    MockSetEnv("Editor", "System:C/Ed");
+    MockSetEnv("Open/SegCache", "64");
+    MockText("Work:Notes", "Notes\n");
+    MockDataTypeOf("Work:Notes", ascii);
+
+    CHECK(MockRun("Work:Notes EDIT") == RETURN_OK);
+    CHECK(MockResidentCount() == 1);
+
+    MockSetEnv("Open/SegCache", "0");
+    CHECK(MockRun("Work:Notes EDIT") == RETURN_OK);
+    LAUNCHED(0, "system", "System:C/Ed Work:Notes", "");
+    CHECK(MockResidentCount() == 0);
+    CHECK(strcmp(MockGetEnv("ENV:Open/Residents"), "") == 0);
+}
+
+/* An executable is started through Workbench */
+static VOID OpenExecutable(VOID)
+{
+    MockDefIcons(TRUE);
+    MockExecutable("Work:Game", 1000);
+
+    CHECK(MockRun("Work:Game") == RETURN_OK);
+    CHECK(MockLaunchCount() == 1);
+    LAUNCHED(0, "workbench", "Work:Game", "");
+}
+
+/* An executable whose hunks don't fit in free memory is not started */
+static VOID ExecutableTooBig(VOID)
+{
+    MockDefIcons(TRUE);
+    MockExecutable("Work:Game", 100000);
+    MockAvailMem(100 * 1024, 200 * 1024);
+
+    CHECK(MockRun("Work:Game") != RETURN_OK);
+    CHECK(MockLaunchCount() == 0);
+    CHECK_OUTPUT("Not enough free memory to load: Work:Game");
+    CHECK_CALLS("LoadSeg", 0);
+}
+
+/* Binary assets are not run */
+static VOID SkipLibrary(VOID)
+{
+    MockDefIcons(TRUE);
+    MockExecutable("Work:foo.library", 1000);
+
+    MockRun("Work:foo.library");
+    CHECK(MockLaunchCount() == 0);
+}
+
+/* RESOLVE prints one record per item and launches nothing */
+static VOID ResolveRecords(VOID)
+{
+    TextWorld();
+    MockDir("Work:Docs");
+
+    CHECK(MockRun("Work:ReadMe Work:Docs RESOLVE") == RETURN_OK);
+    CHECK(MockLaunchCount() == 0);
+    CHECK_OUTPUT("Work:ReadMe\tdata\tascii\t");
+    CHECK_OUTPUT("System:Utilities/MultiView\tworkbench\tdeficons\n");
+    CHECK_OUTPUT("Work:Docs\tdrawer\t");
+}
+
+/* SETVAR leaves the last record in local variables */
+static VOID ResolveSetVar(VOID)
+{
+    TextWorld();
+
+    CHECK(MockRun("Work:ReadMe RESOLVE SETVAR") == RETURN_OK);
+    CHECK(MockLocalVar("OpenKind") && strcmp(MockLocalVar("OpenKind"), "data") == 0);
+    CHECK(MockLocalVar("OpenMethod") && strcmp(MockLocalVar("OpenMethod"), "workbench") == 0);
+}
+
+/* ENV:Open/Stages is left alone once a suffix's order has settled, and */
+/* ENVARC: only gets every few changes */
+static VOID StageStatsSettle(VOID)
+{
+    char name[32];
+    LONG i;
+
+    TextWorld();
+    MockText("Work:Plan.txt", "Plan\n");
+    MockType("Work:Plan.txt", "ascii");
+
+    for (i = 0; i < 6; i++) {
+        MockRun("Work:Plan.txt RESOLVE");
+    }
+    CHECK(MockWrites("ENV:Open/Stages") == 3);
+    CHECK(MockWrites("ENVARC:Open/Stages") == 0);
+
+    for (i = 0; i < 5; i++) {
+        sprintf(name, "Work:Plan.v%ld", (long)i);
+        MockText(name, "Plan\n");
+        MockType(name, "ascii");
+        strcat(name, " RESOLVE");
+        MockRun(name);
+    }
+    CHECK(MockWrites("ENVARC:Open/Stages") == 1);
+}
+
+/* With $Open/SharedCache set, a def_ icon's tool is shared with later */
+/* runs until the icon is saved again */
+static VOID SharedDefIconTool(VOID)
+{
+    TextWorld();
+    MockSetEnv("Open/SharedCache", "10");
+
+    CHECK(MockRun("Work:ReadMe") == RETURN_OK);
+    LAUNCHED(0, "workbench", "System:Utilities/MultiView", "Work:ReadMe");
+    CHECK(MockRun("Work:Notes") == RETURN_OK);
+    LAUNCHED(0, "workbench", "System:Utilities/MultiView", "Work:Notes");
+    CHECK_CALLS("GetDiskObject", 0);
+
+    MockAdvance(1000000);
+    MockIcon("ENV:Sys/def_ascii", "C:Ed");
+    CHECK(MockRun("Work:ToDo") == RETURN_OK);
+    LAUNCHED(0, "workbench", "System:C/Ed", "Work:ToDo");
+    CHECK_CALLS("GetDiskObject", 1);
+}
+
+/* Kept for 0 minutes, the cache is freed when its last user finishes */
+static VOID SharedCacheFreed(VOID)
+{
+    TextWorld();
+    MockSetEnv("Open/SharedCache", "0");
+
+    CHECK(MockRun("Work:ReadMe") == RETURN_OK);
+    LAUNCHED(0, "workbench", "System:Utilities/MultiView", "Work:ReadMe");
+    CHECK(FindSemaphore((CONST_STRPTR)"Open.cache") == NULL);
+}
+
+/* ALL opens every file below a drawer, skipping icons */
+static VOID WalkTree(VOID)
+{
+    TextWorld();
+    MockText("Work:Docs/a", "a\n");
+    MockType("Work:Docs/a", "ascii");
+    MockIcon("Work:Docs/a", "");
+    MockText("Work:Docs/Sub/b", "b\n");
+    MockType("Work:Docs/Sub/b", "ascii");
+    MockText("Work:Docs/Sub/Deeper/c", "c\n");
+    MockType("Work:Docs/Sub/Deeper/c", "ascii");
+
+    CHECK(MockRun("Work:Docs ALL") == RETURN_OK);
+    CHECK(MockLaunchCount() == 3);
+    LAUNCHED(0, "workbench", "System:Utilities/MultiView", "Work:Docs/a");
+    LAUNCHED(1, "workbench", "System:Utilities/MultiView", "Work:Docs/Sub/b");
+    LAUNCHED(2, "workbench", "System:Utilities/MultiView", "Work:Docs/Sub/Deeper/c");
+}
+
+/* ALL keeps its drawer levels on the heap - a deep tree needs no more */
+/* stack than a flat one */
+static VOID WalkDeepTree(VOID)
+{
+    char path[512];
+    ULONG flat;
+    LONG i;
+
+    TextWorld();
+    MockText("Work:Flat/a", "a\n");
+    MockType("Work:Flat/a", "ascii");
+    strcpy(path, "Work:Deep");
+    for (i = 0; i < 24; i++) {
+        strcat(path, "/D");
+    }
+    strcat(path, "/a");
+    MockText(path, "a\n");
+    MockType(path, "ascii");
+
+    CHECK(MockRun("Work:Flat ALL") == RETURN_OK);
+    flat = MockStackUsed();
+    CHECK(MockRun("Work:Deep ALL") == RETURN_OK);
+    CHECK(MockLaunchCount() == 1);
+    CHECK(MockStackUsed() < flat + 256);
+}
+
+/* FROM= reads names from a list file */
+static VOID FromList(VOID)
+{
+    TextWorld();
+    MockText("RAM:T/list", "Work:ReadMe\n\nWork:Notes\n");
+
+    CHECK(MockRun("FROM=RAM:T/list") == RETURN_OK);
+    CHECK(MockLaunchCount() == 2);
+    LAUNCHED(1, "workbench", "System:Utilities/MultiView", "Work:Notes");
+}
+
+/* A long TRACE run keeps the names of its newest items, which the */
+/* events still refer to */
+static VOID TraceNamesNewest(VOID)
+{
+    static char list[16384];
+    static char text[262144];
+    char name[64];
+    struct MockNode *trace;
+    LONG used = 0;
+    LONG i;
+
+    TextWorld();
+    for (i = 1; i <= 300; i++) {
+        sprintf(name, "Work:A_rather_long_file_name_%03ld", (long)i);
+        MockText(name, "Text\n");
+        MockType(name, "ascii");
+        used += sprintf(list + used, "%s\n", name);
+    }
+    MockText("RAM:T/list", list);
+
+    CHECK(MockRun("FROM=RAM:T/list RESOLVE TRACE=RAM:T/trace") == RETURN_OK);
+    trace = MockFind("RAM:T/trace");
+    CHECK(trace != NULL);
+    if (trace != NULL && trace->size < (LONG)sizeof(text)) {
+        memcpy(text, trace->data, trace->size);
+        text[trace->size] = '\0';
+        MockCheckText(text, "N 300 Work:A_rather_long_file_name_300\n", "trace", __FILE__, __LINE__);
+        MockCheckText(text, " E item 300\n", "trace", __FILE__, __LINE__);
+    }
+}
+
+/* ENV:Open/LargeFiles sends files over the size limit to their own tool */
+static VOID LargeFileRoute(VOID)
+{
+    static char big[5000];
+
+    TextWorld();
+    memset(big, 'x', sizeof(big) - 1);
+    MockText("Work:Big", big);
+    MockType("Work:Big", "ascii");
+    MockExecutable("System:Tools/BigEd", 10);
+    MockText("ENV:Open/LargeFiles", "; Big text files\nascii 4K SYS:Tools/BigEd\n");
+
+    CHECK(MockRun("Work:ReadMe Work:Big") == RETURN_OK);
+    CHECK(MockLaunchCount() == 2);
+    LAUNCHED(0, "workbench", "System:Utilities/MultiView", "Work:ReadMe");
+    LAUNCHED(1, "workbench", "System:Tools/BigEd", "Work:Big");
+}
+
+/* BENCH repeats the decision without launching; the def_ icon is only */
+/* read once, unless COLD forgets it between runs */
+static VOID BenchRuns(VOID)
+{
+    TextWorld();
+
+    CHECK(MockRun("Work:ReadMe BENCH=5") == RETURN_OK);
+    CHECK(MockLaunchCount() == 0);
+    CHECK_OUTPUT("Bench: Work:ReadMe: 5 runs\n");
+    CHECK_OUTPUT("Bench: item");
+    CHECK_CALLS("GetDiskObject", 1);
+
+    CHECK(MockRun("Work:ReadMe BENCH=5 COLD") == RETURN_OK);
+    CHECK(MockLaunchCount() == 0);
+    CHECK_OUTPUT("Bench: Work:ReadMe: 5 runs (cold)\n");
+    CHECK_CALLS("GetDiskObject", 5);
+}
+
+/* Ctrl-C stops before the next item */
+static VOID BreakStops(VOID)
+{
+    TextWorld();
+    MockBreakAfterLocks(1);
+
+    MockRun("Work:ReadMe Work:Notes Work:ToDo");
+    CHECK(MockLaunchCount() < 3);
+}
+
+/* A rule decides without identifying the file */
+static VOID RuleMatches(VOID)
+{
+    TextWorld();
+    MockSetEnv("Open/Rules", "; pattern verb tool\n#?.txt EDIT C:Ed\nRead#? * C:Ed\n");
+
+    CHECK(MockRun("Work:ReadMe") == RETURN_OK);
+    LAUNCHED(0, "workbench", "C:Ed", "Work:ReadMe");
+    CHECK_CALLS("GetIconTagList", 0);
+}
+
+/* A suffix with more than one period is matched as a pattern */
+static VOID RuleDoubleSuffix(VOID)
+{
+    TextWorld();
+    MockSetEnv("Open/Rules", "#?.tar.gz * C:Ed\n");
+    MockText("Work:src.tar.gz", "x");
+    MockText("Work:notes.gz", "x");
+    MockType("Work:notes.gz", "ascii");
+
+    CHECK(MockRun("Work:src.tar.gz Work:notes.gz") == RETURN_OK);
+    CHECK(MockLaunchCount() == 2);
+    LAUNCHED(0, "workbench", "C:Ed", "Work:src.tar.gz");
+    LAUNCHED(1, "workbench", "System:Utilities/MultiView", "Work:notes.gz");
+}
+
+/* FAST classifies by name only */
+static VOID FastByName(VOID)
+{
+    TextWorld();
+    MockText("Work:Letter.txt", "Dear\n");
+
+    CHECK(MockRun("Work:Letter.txt FAST") == RETURN_OK);
+    LAUNCHED(0, "workbench", "System:Utilities/MultiView", "Work:Letter.txt");
+    CHECK_CALLS("GetIconTagList", 0);
+}
+
+/* Workbench arguments */
+static VOID WorkbenchArgs(VOID)
+{
+    static const char *names[] = { "ReadMe", "Notes" };
+
+    TextWorld();
+
+    CHECK(MockRunWorkbench("Work:", names, 2) == RETURN_OK);
+    CHECK(MockLaunchCount() == 2);
+    LAUNCHED(0, "workbench", "System:Utilities/MultiView", "Work:ReadMe");
+    LAUNCHED(1, "workbench", "System:Utilities/MultiView", "Work:Notes");
+}
+
+/* Workbench failures are collected into one requester */
+static VOID WorkbenchFailures(VOID)
+{
+    static const char *names[] = { "Gone1", "ReadMe", "Gone2", "Plan" };
+
+    TextWorld();
+    MockFile("Work:Plan", "\0\1\2\3", 4);
+    MockType("Work:Plan", "plan");
+    MockIcon("ENV:Sys/def_plan", "SYS:Utilities/Gone");
+
+    MockRunWorkbench("Work:", names, 4);
+    CHECK(MockLaunchCount() == 2);
+    LAUNCHED(0, "workbench", "System:Utilities/MultiView", "Work:ReadMe");
+    CHECK(strcmp(MockLaunchAt(1)->how, "requester") == 0);
+    CHECK(strstr(MockLaunchAt(1)->what, "Gone1: object not found") != NULL);
+    CHECK(strstr(MockLaunchAt(1)->what, "Gone2: object not found") != NULL);
+    CHECK(strstr(MockLaunchAt(1)->what, "Plan: object not found") != NULL);
+}
+
+/* $Open/Monitor records Workbench runs too, and REPORT shows them */
+static VOID WorkbenchUsage(VOID)
+{
+    static const char *names[] = { "ReadMe", "Notes" };
+
+    TextWorld();
+    MockSetEnv("Open/Monitor", "1");
+
+    CHECK(MockRunWorkbench("Work:", names, 2) == RETURN_OK);
+    CHECK(MockWrites("ENVARC:Open/Usage") == 1);
+    CHECK(MockRun("REPORT") == RETURN_OK);
+    CHECK_OUTPUT("Usage: 1 runs from");
+    CHECK_OUTPUT("Usage: item              2 calls");
+}
+
+/* Headers of the next items are read with packets while one is opened */
+static VOID ReadAheadPackets(VOID)
+{
+    TextWorld();
+
+    CHECK(MockRun("Work:ReadMe Work:Notes Work:ToDo") == RETURN_OK);
+    CHECK(MockLaunchCount() == 3);
+    CHECK(MockCalls("SendPkt") > 0);
+    CHECK(MockStaleLockUses() == 0);
+}
+
+/* On a non-binding assign the lock GetDeviceProc() gives is its own, so */
+/* it has to stay valid until the handler has answered ACTION_FINDINPUT */
+static VOID ReadAheadAssign(VOID)
+{
+    TextWorld();
+    MockAssign("Docs", "Work:", FALSE);
+
+    CHECK(MockRun("Docs:ReadMe Docs:Notes Docs:ToDo") == RETURN_OK);
+    CHECK(MockLaunchCount() == 3);
+    CHECK_CALLS("StaleLockPacket", 0);
+    CHECK(MockStaleLockUses() == 0);
+    CHECK_CALLS("Read", 1);
+}
+
+/* Names with qualifiers are read ahead under the name they are opened by */
+static VOID ReadAheadQualifiers(VOID)
+{
+    TextWorld();
+
+    CHECK(MockRun("Work:ReadMe Work:Notes/EDIT Work:ToDo/TOOL=C:Ed") == RETURN_OK);
+    CHECK(MockLaunchCount() == 3);
+    LAUNCHED(2, "workbench", "C:Ed", "Work:ToDo");
+    CHECK_CALLS("Read", 1);
+}
+
+/* STATS prints a line per item and a summary, to the error stream with */
+/* RESOLVE; the mock clock makes the stage times those of the scripted */
+/* volumes - two requests to Work: at 0.8 ms each for the lock stage */
+static VOID StatsOutput(VOID)
+{
+    TextWorld();
+
+    CHECK(MockRun("Work:ReadMe STATS RESOLVE") == RETURN_OK);
+    CHECK_ERRORS("Stats: Work:ReadMe: lock 1.6");
+    CHECK_ERRORS("Stats: Work:ReadMe: calls ParentDir 3 Read 1 Lock 5 Examine 3 GetIconTagList 3 GetDiskObject 1\n");
+    CHECK_ERRORS("Stats: 1 items in ");
+    CHECK(strstr(MockOutput(), "Stats:") == NULL);
+}
+
+/* BATCH fails items on a volume that is not there without a requester */
+static VOID BatchMissingVolume(VOID)
+{
+    TextWorld();
+
+    MockRun("DF0:ReadMe Work:Notes BATCH");
+    CHECK_CALLS("InsertVolumeRequester", 0);
+    CHECK(MockLaunchCount() == 1);
+    LAUNCHED(0, "workbench", "System:Utilities/MultiView", "Work:Notes");
+}
+
+/* Per-file qualifiers */
+static VOID Qualifiers(VOID)
+{
+    TextWorld();
+
+    CHECK(MockRun("Work:ReadMe/TOOL=C:Ed Work:Notes") == RETURN_OK);
+    CHECK(MockLaunchCount() == 2);
+    LAUNCHED(0, "workbench", "C:Ed", "Work:ReadMe");
+    LAUNCHED(1, "workbench", "System:Utilities/MultiView", "Work:Notes");
+}
+
+/* A verb qualifier picks the datatype's tool for that verb */
+static VOID QualifierVerb(VOID)
+{
+    struct MockDataType *ascii = MockDataTypeNew("ascii", MAKE_ID('t','e','x','t'));
+
+    MockDataTypeTool(ascii, 2, TF_WORKBENCH, "System:Utilities/MultiView");
+    MockDataTypeTool(ascii, 3, TF_WORKBENCH, "System:C/Ed");
+    MockText("Work:Notes", "Notes\n");
+    MockDataTypeOf("Work:Notes", ascii);
+
+    CHECK(MockRun("Work:Notes Work:Notes/EDIT") == RETURN_OK);
+    CHECK(MockLaunchCount() == 2);
+    LAUNCHED(0, "datatypes", "System:Utilities/MultiView", "Work:Notes");
+    LAUNCHED(1, "datatypes", "System:C/Ed", "Work:Notes");
+}
+
+/* A file whose name only looks qualified is opened by that name, with */
+/* one Lock() to find out */
+static VOID QualifierRealName(VOID)
+{
+    TextWorld();
+    MockDir("Work:Docs");
+    MockText("Work:Docs/EDIT", "Edit\n");
+    MockType("Work:Docs/EDIT", "ascii");
+
+    CHECK(MockRun("Work:ReadMe Work:Docs/EDIT") == RETURN_OK);
+    CHECK(MockLaunchCount() == 2);
+    LAUNCHED(1, "workbench", "System:Utilities/MultiView", "Work:Docs/EDIT");
+}
+
+/* The DefIcons tool has gone and the deadline passes before the next */
+/* stage, so the name decides - both def_ tools are looked up */
+static VOID DeadlineAfterMissingTool(VOID)
+{
+    MockVolume("Slow", 10000);
+    MockDefIcons(TRUE);
+    MockText("Slow:Notes.txt", "Notes\n");
+    MockType("Slow:Notes.txt", "ilbm");
+    MockIcon("ENV:Sys/def_ilbm", "Slow:Gone/Viewer");
+    MockIcon("ENV:Sys/def_ascii", "SYS:Utilities/MultiView");
+
+    CHECK(MockRun("Slow:Notes.txt DEADLINE=80") == RETURN_OK);
+    CHECK(MockLaunchCount() == 1);
+    LAUNCHED(0, "workbench", "System:Utilities/MultiView", "Slow:Notes.txt");
+    CHECK_OUTPUT("identifying files by name only");
+}
+
+const struct Scenario scenarios[] = {
+    { "open-text-file", OpenTextFile },
+    { "tool-cache-second-run", ToolCacheSecondRun },
+    { "env-drawer-created", EnvDrawerCreated },
+    { "open-several-files", OpenSeveralFiles },
+    { "tool-override", ToolOverride },
+    { "open-drawer", OpenDrawer },
+    { "drawer-already-open", DrawerAlreadyOpen },
+    { "drawer-window-closes", DrawerWindowCloses },
+    { "missing-file", MissingFile },
+    { "datatypes-tool", DatatypesTool },
+    { "tool-arguments", ToolArguments },
+    { "resolve-missing-tool", ResolveMissingTool },
+    { "resolve-missing-item", ResolveMissingItem },
+    { "dtmatch-failure-noted", DTMatchFailureNoted },
+    { "dtmatch-corrupt", DTMatchCorrupt },
+    { "dtmatch-unmatched-text", DTMatchUnmatchedText },
+    { "resident-editor", ResidentEditor },
+    { "resident-list-merged", ResidentListMerged },
+    { "resident-budget-off", ResidentBudgetOff },
+    { "open-executable", OpenExecutable },
+    { "executable-too-big", ExecutableTooBig },
+    { "skip-library", SkipLibrary },
+    { "resolve-records", ResolveRecords },
+    { "resolve-setvar", ResolveSetVar },
+    { "stage-stats-settle", StageStatsSettle },
+    { "shared-deficon-tool", SharedDefIconTool },
+    { "shared-cache-freed", SharedCacheFreed },
+    { "walk-tree", WalkTree },
+    { "walk-deep-tree", WalkDeepTree },
+    { "from-list", FromList },
+    { "trace-names-newest", TraceNamesNewest },
+    { "large-file-route", LargeFileRoute },
+    { "bench-runs", BenchRuns },
+    { "break-stops", BreakStops },
+    { "rule-matches", RuleMatches },
+    { "rule-double-suffix", RuleDoubleSuffix },
+    { "fast-by-name", FastByName },
+    { "workbench-args", WorkbenchArgs },
+    { "workbench-failures", WorkbenchFailures },
+    { "workbench-usage", WorkbenchUsage },
+    { "read-ahead-packets", ReadAheadPackets },
+    { "read-ahead-assign", ReadAheadAssign },
+    { "read-ahead-qualifiers", ReadAheadQualifiers },
+    { "stats-output", StatsOutput },
+    { "batch-missing-volume", BatchMissingVolume },
+    { "qualifiers", Qualifiers },
+    { "qualifier-verb", QualifierVerb },
+    { "qualifier-real-name", QualifierRealName },
+    { "deadline-after-missing-tool", DeadlineAfterMissingTool },
+    { NULL, NULL }
+};